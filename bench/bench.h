@@ -0,0 +1,33 @@
+#ifndef DECIMA_NATIVE_BENCH_H
+#define DECIMA_NATIVE_BENCH_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+double BenchNow(void);
+
+uint64_t BenchRandom(uint64_t *state);
+
+int BenchScan(int argc, char **argv);
+
+int BenchScanThreads(int argc, char **argv);
+
+int BenchResolve(int argc, char **argv);
+
+int BenchTraverse(int argc, char **argv);
+
+int BenchSort(int argc, char **argv);
+
+int BenchExport(int argc, char **argv);
+
+int BenchDiff(int argc, char **argv);
+
+int BenchLookup(int argc, char **argv);
+
+int BenchSerialize(int argc, char **argv);
+
+int BenchEnums(int argc, char **argv);
+
+int BenchTypeDb(int argc, char **argv);
+
+#endif //DECIMA_NATIVE_BENCH_H
@@ -0,0 +1,135 @@
+#include "bench.h"
+#include "synth.h"
+#include "traverse.h"
+#include "sort.h"
+#include "typedb.h"
+#include "diff.h"
+#include "arena.h"
+#include "typehash.h"
+#include "layout.h"
+#include "plan.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#define BENCH_NULL_DEVICE "NUL"
+#else
+#define BENCH_NULL_DEVICE "/dev/null"
+#endif
+
+#define BENCH_PREVIOUS_PATH "decima_bench.prev.bin"
+#define BENCH_CURRENT_PATH "decima_bench.bin"
+
+static _Bool WriteDump(const char *path, struct SynthGraph *graph) {
+    struct Traversal traversal;
+    FILE *file;
+    _Bool result;
+
+    RTTI_ResetDisplayNames();
+    RTTI_ResetEnumTables();
+    TypeHashReset();
+    LayoutReset();
+    PlanReset();
+    SessionReset();
+
+    TraversalInit(&traversal, 1 << 16, NULL, NULL);
+    for (size_t i = 0; i < graph->num_roots; i++)
+        TraversalAdd(&traversal, graph->roots[i]);
+
+    size_t count = traversal.visited.count;
+    struct RTTI **sorted = malloc(count * sizeof(struct RTTI *));
+    memcpy(sorted, traversal.visited.items, count * sizeof(struct RTTI *));
+    SortTypes(sorted, count);
+
+    result = (file = fopen(path, "wb")) != NULL;
+    if (result) {
+        result = TypeDbWrite(file, sorted, count);
+        fclose(file);
+    }
+
+    free(sorted);
+    TraversalFree(&traversal);
+    return result;
+}
+
+/// Dumps a synthetic graph, changes a few compounds the way a patch would and dumps it again,
+/// then measures the delta between the two. Every 100th compound gets an attr moved without a
+/// version bump, so it is only caught by the hash, and every 250th gets a new version.
+int BenchDiff(int argc, char **argv) {
+    size_t num_compounds = argc > 0 ? strtoull(argv[0], NULL, 10) : 100000;
+    int iterations = argc > 1 ? atoi(argv[1]) : 5;
+    struct SynthGraph graph;
+    struct TypeDb previous, current;
+    struct DiffSummary summary;
+    double best = 0;
+
+    if (iterations < 1) {
+        fprintf(stderr, "Iterations must be positive\n");
+        return 1;
+    }
+
+    if (!SynthGenerate(&graph, num_compounds, 12, 0x9E3779B97F4A7C15ull)) {
+        fprintf(stderr, "Unable to generate %zu compounds\n", num_compounds);
+        return 1;
+    }
+
+    _Bool written = WriteDump(BENCH_PREVIOUS_PATH, &graph);
+
+    for (size_t i = 0; i < graph.num_compounds; i++) {
+        struct RTTICompound *compound = &graph.compounds[i];
+
+        if (i % 100 == 0 && compound->mNumAttrs > 0 && compound->mAttrs[compound->mNumAttrs - 1].type != NULL)
+            compound->mAttrs[compound->mNumAttrs - 1].mOffset += 8;
+        if (i % 250 == 0)
+            compound->mVersion++;
+    }
+
+    written = written && WriteDump(BENCH_CURRENT_PATH, &graph);
+
+    if (!written || !TypeDbOpen(BENCH_PREVIOUS_PATH, &previous)) {
+        fprintf(stderr, "Unable to write the dumps\n");
+        remove(BENCH_PREVIOUS_PATH);
+        remove(BENCH_CURRENT_PATH);
+        SynthFree(&graph);
+        return 1;
+    }
+
+    if (!TypeDbOpen(BENCH_CURRENT_PATH, &current)) {
+        fprintf(stderr, "Unable to open the current dump\n");
+        TypeDbClose(&previous);
+        remove(BENCH_PREVIOUS_PATH);
+        remove(BENCH_CURRENT_PATH);
+        SynthFree(&graph);
+        return 1;
+    }
+
+    for (int i = 0; i < iterations; i++) {
+        FILE *file = fopen(BENCH_NULL_DEVICE, "wb");
+        double start = BenchNow();
+        DiffTypes(file, &previous, &current, &summary);
+        double elapsed = BenchNow() - start;
+        fclose(file);
+
+        if (i == 0 || elapsed < best)
+            best = elapsed;
+    }
+
+    printf("Diffed %u against %u types in %.2f ms\n", current.header->num_types, previous.header->num_types, best * 1e3);
+    printf("%zu added, %zu removed, %zu changed, %zu unchanged\n", summary.added, summary.removed, summary.changed,
+           summary.unchanged);
+
+    TypeDbClose(&current);
+    TypeDbClose(&previous);
+    remove(BENCH_PREVIOUS_PATH);
+    remove(BENCH_CURRENT_PATH);
+    RTTI_ResetDisplayNames();
+    RTTI_ResetEnumTables();
+    TypeHashReset();
+    LayoutReset();
+    PlanReset();
+    SessionReset();
+    SynthFree(&graph);
+    return 0;
+}
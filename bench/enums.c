@@ -0,0 +1,192 @@
+#include "bench.h"
+#include "rtti.h"
+#include "arena.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BENCH_ENUM_NAME_LENGTH 24
+
+enum BenchEnumShape {
+    BenchEnumShape_Contiguous,
+    BenchEnumShape_Sparse,
+    BenchEnumShape_Flags,
+    BenchEnumShape_Count
+};
+
+static const char *g_shape_names[BenchEnumShape_Count] = {"contiguous", "sparse", "flags"};
+
+static const char *LinearName(struct RTTIEnum *enumeration, uint64_t value) {
+    for (int i = 0; i < enumeration->num_values; i++) {
+        if (enumeration->values[i].mValue == value)
+            return enumeration->values[i].mName;
+    }
+
+    return NULL;
+}
+
+static size_t LinearFlags(struct RTTIEnum *enumeration, uint64_t value, const char **names, uint64_t *rest) {
+    size_t count = 0;
+
+    for (int i = 0; i < enumeration->num_values && value; i++) {
+        uint64_t mask = enumeration->values[i].mValue;
+        if (mask != 0 && (value & mask) == mask) {
+            names[count++] = enumeration->values[i].mName;
+            value &= ~mask;
+        }
+    }
+
+    *rest = value;
+    return count;
+}
+
+static _Bool LinearValue(struct RTTIEnum *enumeration, const char *name, uint64_t *value) {
+    for (int i = 0; i < enumeration->num_values; i++) {
+        const struct RTTIValue *candidate = &enumeration->values[i];
+        _Bool match = strcmp(candidate->mName, name) == 0;
+
+        for (int j = 0; j < 4 && !match; j++)
+            match = candidate->mAliases[j] != NULL && strcmp(candidate->mAliases[j], name) == 0;
+
+        if (match) {
+            *value = candidate->mValue;
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+/// Values in declaration order the way the game has them: contiguous ones from 0 with a few repeats,
+/// sparse ones spread over 32 bits, flags one bit each.
+static void BuildEnum(struct RTTIEnum *enumeration, struct RTTIValue *values, char *names, enum BenchEnumShape shape,
+                      uint16_t count, uint64_t *state) {
+    memset(enumeration, 0, sizeof(*enumeration));
+    enumeration->base.kind = shape == BenchEnumShape_Flags ? RTTIKind_EnumFlags : RTTIKind_Enum;
+    enumeration->size = shape == BenchEnumShape_Flags ? 8 : 4;
+    enumeration->num_values = count;
+    enumeration->type_name = g_shape_names[shape];
+    enumeration->values = values;
+
+    for (uint16_t i = 0; i < count; i++) {
+        char *name = names + (size_t) i * BENCH_ENUM_NAME_LENGTH;
+        uint64_t value;
+
+        if (shape == BenchEnumShape_Contiguous)
+            value = i % 17 == 16 ? i - 1 : i;
+        else if (shape == BenchEnumShape_Sparse)
+            value = BenchRandom(state) & 0xFFFFFFFF;
+        else
+            value = (uint64_t) 1 << (i % 64);
+
+        snprintf(name, BENCH_ENUM_NAME_LENGTH, "%s_%u", g_shape_names[shape], i);
+        memset(&values[i], 0, sizeof(values[i]));
+        values[i].mValue = value;
+        values[i].mName = name;
+        if (i % 5 == 0)
+            values[i].mAliases[0] = name + 1;
+    }
+}
+
+/// Looks values up by value, splits flags and looks values up by name, through the enum tables and with a scan
+/// over the values. Both must agree on every lookup.
+int BenchEnums(int argc, char **argv) {
+    uint16_t num_values = (uint16_t) (argc > 0 ? strtoul(argv[0], NULL, 10) : 200);
+    size_t num_lookups = argc > 1 ? strtoull(argv[1], NULL, 10) : 1000000;
+    struct RTTIValue *values = malloc((size_t) (num_values ? num_values : 1) * sizeof(struct RTTIValue));
+    char *names = malloc((size_t) (num_values ? num_values : 1) * BENCH_ENUM_NAME_LENGTH);
+    uint64_t *queries = malloc(num_lookups * sizeof(uint64_t));
+    uint64_t state = 0x2545F4914F6CDD1Dull;
+    size_t mismatches = 0;
+
+    if (num_values == 0 || values == NULL || names == NULL || queries == NULL) {
+        fprintf(stderr, "Unable to build enums of %u values\n", num_values);
+        return 1;
+    }
+
+    printf("%zu lookups into enums of %u values\n", num_lookups, num_values);
+
+    for (int shape = 0; shape < BenchEnumShape_Count; shape++) {
+        struct RTTIEnum enumeration;
+        const char *expected[64];
+        const char *actual[64];
+        uint64_t expected_rest;
+        uint64_t actual_rest;
+        size_t checksum = 0;
+
+        BuildEnum(&enumeration, values, names, (enum BenchEnumShape) shape, num_values, &state);
+
+        // Every other query misses
+        for (size_t i = 0; i < num_lookups; i++) {
+            if (shape == BenchEnumShape_Flags)
+                queries[i] = BenchRandom(&state);
+            else
+                queries[i] = i & 1 ? BenchRandom(&state) & 0xFFFFFFFF : values[BenchRandom(&state) % num_values].mValue;
+        }
+
+        for (size_t i = 0; i < num_lookups && i < 100000; i++) {
+            if (shape == BenchEnumShape_Flags) {
+                size_t count = LinearFlags(&enumeration, queries[i], expected, &expected_rest);
+                mismatches += count != RTTI_EnumFlags(&enumeration, queries[i], actual, &actual_rest)
+                              || expected_rest != actual_rest || memcmp(expected, actual, count * sizeof(*actual)) != 0;
+            } else {
+                mismatches += LinearName(&enumeration, queries[i]) != RTTI_EnumName(&enumeration, queries[i]);
+            }
+
+            const char *name = values[queries[i] % num_values].mName + (i & 1);
+            uint64_t expected_value = 0;
+            uint64_t actual_value = 0;
+            _Bool found = LinearValue(&enumeration, name, &expected_value);
+            mismatches += found != RTTI_EnumValue(&enumeration, name, &actual_value) || expected_value != actual_value;
+        }
+
+        double start = BenchNow();
+        for (size_t i = 0; i < num_lookups; i++) {
+            if (shape == BenchEnumShape_Flags)
+                checksum += LinearFlags(&enumeration, queries[i], expected, &expected_rest);
+            else
+                checksum += LinearName(&enumeration, queries[i]) != NULL;
+        }
+        double linear = BenchNow() - start;
+
+        start = BenchNow();
+        for (size_t i = 0; i < num_lookups; i++) {
+            if (shape == BenchEnumShape_Flags)
+                checksum += RTTI_EnumFlags(&enumeration, queries[i], actual, &actual_rest);
+            else
+                checksum += RTTI_EnumName(&enumeration, queries[i]) != NULL;
+        }
+        double table = BenchNow() - start;
+
+        start = BenchNow();
+        for (size_t i = 0; i < num_lookups; i++) {
+            uint64_t value;
+            checksum += LinearValue(&enumeration, values[queries[i] % num_values].mName, &value);
+        }
+        double linear_names = BenchNow() - start;
+
+        start = BenchNow();
+        for (size_t i = 0; i < num_lookups; i++) {
+            uint64_t value;
+            checksum += RTTI_EnumValue(&enumeration, values[queries[i] % num_values].mName, &value);
+        }
+        double table_names = BenchNow() - start;
+
+        printf("%-10s %s: scan %.1f ns, table %.1f ns; by name: scan %.1f ns, table %.1f ns (%zu)\n",
+               g_shape_names[shape], shape == BenchEnumShape_Flags ? "split" : "names",
+               linear * 1e9 / (double) num_lookups, table * 1e9 / (double) num_lookups,
+               linear_names * 1e9 / (double) num_lookups, table_names * 1e9 / (double) num_lookups, checksum);
+
+        // Every shape reuses the same arrays, the tables of the previous one must go
+        RTTI_ResetEnumTables();
+        SessionReset();
+    }
+
+    printf("%zu mismatches\n", mismatches);
+
+    free(queries);
+    free(names);
+    free(values);
+    return mismatches ? 1 : 0;
+}
@@ -0,0 +1,211 @@
+#include "bench.h"
+#include "synth.h"
+#include "traverse.h"
+#include "sort.h"
+#include "export.h"
+#include "typedb.h"
+#include "arena.h"
+#include "typehash.h"
+#include "layout.h"
+#include "plan.h"
+#include "thread.h"
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#define BENCH_NULL_DEVICE "NUL"
+#else
+#define BENCH_NULL_DEVICE "/dev/null"
+#endif
+
+#define BENCH_MAX_ITERATIONS 64
+
+enum DumpPhase {
+    DumpPhase_Traverse,
+    DumpPhase_Sort,
+    DumpPhase_Hash,
+    DumpPhase_ExportJson,
+    DumpPhase_ExportJsonParallel,
+    DumpPhase_ExportLayouts,
+    DumpPhase_ExportIda,
+    DumpPhase_ExportIdaCompact,
+    DumpPhase_ExportTypeDb,
+    DumpPhase_Count
+};
+
+static const char *g_phase_names[DumpPhase_Count] = {"traverse", "sort", "hash", "export_json", "export_json_mt",
+                                                       "export_layouts", "export_ida", "export_ida_compact", "export_typedb"};
+
+/// Everything up to the "$stats" of hfw_types.json, the only part that differs from one export to the next.
+static char *ReadTypes(FILE *file, size_t *length) {
+    long size = ftell(file);
+    char *text = size > 0 ? malloc((size_t) size + 1) : NULL;
+
+    *length = 0;
+    if (text == NULL)
+        return NULL;
+
+    rewind(file);
+    *length = fread(text, 1, (size_t) size, file);
+    text[*length] = '\0';
+
+    char *stats = strstr(text, "\"$stats\"");
+    if (stats != NULL)
+        *length = (size_t) (stats - text);
+
+    return text;
+}
+
+/// Exports the types on one thread and on `threads`, both outputs must be the same.
+static _Bool ExportTypesMatch(struct RTTI **types, size_t count, unsigned threads) {
+    FILE *serial = tmpfile();
+    FILE *parallel = tmpfile();
+    size_t serial_length;
+    size_t parallel_length;
+    char *serial_text = NULL;
+    char *parallel_text = NULL;
+
+    if (serial != NULL && parallel != NULL) {
+        ExportTypes(serial, types, count, 1);
+        ExportTypes(parallel, types, count, threads);
+        serial_text = ReadTypes(serial, &serial_length);
+        parallel_text = ReadTypes(parallel, &parallel_length);
+    }
+
+    _Bool match = serial_text != NULL && parallel_text != NULL && serial_length == parallel_length
+                  && memcmp(serial_text, parallel_text, serial_length) == 0;
+
+    free(serial_text);
+    free(parallel_text);
+    if (serial != NULL)
+        fclose(serial);
+    if (parallel != NULL)
+        fclose(parallel);
+    return match;
+}
+
+static int CompareTimes(const void *a, const void *b) {
+    double x = *(const double *) a;
+    double y = *(const double *) b;
+    return (x > y) - (x < y);
+}
+
+/// Runs the dump pipeline of the hooks over a synthetic graph, output goes to the null device
+/// so that only the formatting is measured. Reports the minimum and the median of every phase.
+int BenchExport(int argc, char **argv) {
+    size_t num_compounds = argc > 0 ? strtoull(argv[0], NULL, 10) : 100000;
+    int iterations = argc > 1 ? atoi(argv[1]) : 5;
+    unsigned threads = argc > 2 ? (unsigned) atoi(argv[2]) : 0;
+    _Bool identical = 1;
+    double times[DumpPhase_Count][BENCH_MAX_ITERATIONS];
+    struct SynthGraph graph;
+
+    if (iterations < 1 || iterations > BENCH_MAX_ITERATIONS) {
+        fprintf(stderr, "Iterations must be within [1, %d]\n", BENCH_MAX_ITERATIONS);
+        return 1;
+    }
+
+    if (!SynthGenerate(&graph, num_compounds, 12, 0x9E3779B97F4A7C15ull)) {
+        fprintf(stderr, "Unable to generate %zu compounds\n", num_compounds);
+        return 1;
+    }
+
+    printf("Dumping %zu types (%zu attrs), %d iterations, exporting on %u threads\n", graph.count, graph.num_attrs,
+           iterations, threads ? threads : ThreadCount());
+
+    for (int i = 0; i < iterations; i++) {
+        struct Traversal traversal;
+        FILE *file;
+
+        // Every iteration starts cold, like a dump does
+        RTTI_ResetDisplayNames();
+        RTTI_ResetEnumTables();
+        TypeHashReset();
+        LayoutReset();
+        PlanReset();
+        SessionReset();
+
+        double start = BenchNow();
+        TraversalInit(&traversal, 1 << 16, NULL, NULL);
+        for (size_t j = 0; j < graph.num_roots; j++)
+            TraversalAdd(&traversal, graph.roots[j]);
+        times[DumpPhase_Traverse][i] = BenchNow() - start;
+
+        size_t count = traversal.visited.count;
+        struct RTTI **sorted = malloc(count * sizeof(struct RTTI *));
+        memcpy(sorted, traversal.visited.items, count * sizeof(struct RTTI *));
+
+        start = BenchNow();
+        SortTypes(sorted, count);
+        times[DumpPhase_Sort][i] = BenchNow() - start;
+
+        // Hashed up front, so that export_json only measures the formatting
+        start = BenchNow();
+        for (size_t j = 0; j < count; j++)
+            TypeHash(sorted[j]);
+        times[DumpPhase_Hash][i] = BenchNow() - start;
+
+        file = fopen(BENCH_NULL_DEVICE, "wb");
+        start = BenchNow();
+        ExportTypes(file, sorted, count, 1);
+        times[DumpPhase_ExportJson][i] = BenchNow() - start;
+        fclose(file);
+
+        file = fopen(BENCH_NULL_DEVICE, "wb");
+        start = BenchNow();
+        ExportTypes(file, sorted, count, threads);
+        times[DumpPhase_ExportJsonParallel][i] = BenchNow() - start;
+        fclose(file);
+
+        if (i == 0)
+            identical = ExportTypesMatch(sorted, count, threads);
+
+        file = fopen(BENCH_NULL_DEVICE, "wb");
+        start = BenchNow();
+        ExportLayouts(file, sorted, count);
+        times[DumpPhase_ExportLayouts][i] = BenchNow() - start;
+        fclose(file);
+
+        file = fopen(BENCH_NULL_DEVICE, "wb");
+        start = BenchNow();
+        ExportIda(file, sorted, count);
+        times[DumpPhase_ExportIda][i] = BenchNow() - start;
+        fclose(file);
+
+        // Synthetic types are heap allocated, there is no image to be relative to
+        file = fopen(BENCH_NULL_DEVICE, "wb");
+        start = BenchNow();
+        ExportIdaCompact(file, sorted, count, 0, SIZE_MAX);
+        times[DumpPhase_ExportIdaCompact][i] = BenchNow() - start;
+        fclose(file);
+
+        file = fopen(BENCH_NULL_DEVICE, "wb");
+        start = BenchNow();
+        TypeDbWrite(file, sorted, count);
+        times[DumpPhase_ExportTypeDb][i] = BenchNow() - start;
+        fclose(file);
+
+        free(sorted);
+        TraversalFree(&traversal);
+    }
+
+    printf("%-18s %10s %10s\n", "phase", "min ms", "median ms");
+    for (int phase = 0; phase < DumpPhase_Count; phase++) {
+        qsort(times[phase], (size_t) iterations, sizeof(double), CompareTimes);
+        printf("%-18s %10.2f %10.2f\n", g_phase_names[phase], times[phase][0] * 1e3, times[phase][iterations / 2] * 1e3);
+    }
+
+    printf("export_json_mt output %s\n", identical ? "identical" : "DIFFERENT");
+
+    RTTI_ResetDisplayNames();
+    RTTI_ResetEnumTables();
+    TypeHashReset();
+    LayoutReset();
+    PlanReset();
+    SessionReset();
+    SynthFree(&graph);
+    return identical ? 0 : 1;
+}
@@ -0,0 +1,90 @@
+#include "bench.h"
+#include "synth.h"
+#include "traverse.h"
+#include "registry.h"
+#include "arena.h"
+#include "typehash.h"
+#include "layout.h"
+#include "plan.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/// Builds the name registry over a synthetic graph and looks up random names,
+/// every one of them known, then the same names with their last character changed.
+int BenchLookup(int argc, char **argv) {
+    size_t num_compounds = argc > 0 ? strtoull(argv[0], NULL, 10) : 100000;
+    size_t num_lookups = argc > 1 ? strtoull(argv[1], NULL, 10) : 1000000;
+    struct SynthGraph graph;
+    struct Traversal traversal;
+    uint64_t state = 0x2545F4914F6CDD1Dull;
+    size_t found = 0;
+
+    if (!SynthGenerate(&graph, num_compounds, 12, 0x9E3779B97F4A7C15ull)) {
+        fprintf(stderr, "Unable to generate %zu compounds\n", num_compounds);
+        return 1;
+    }
+
+    TraversalInit(&traversal, 1 << 16, NULL, NULL);
+    for (size_t i = 0; i < graph.num_roots; i++)
+        TraversalAdd(&traversal, graph.roots[i]);
+
+    size_t count = traversal.visited.count;
+    struct RTTI **types = traversal.visited.items;
+    const char **names = malloc(num_lookups * sizeof(const char *));
+    char **misses = malloc(num_lookups * sizeof(char *));
+
+    double start = BenchNow();
+    _Bool built = RegistryBuild(types, count);
+    double build = BenchNow() - start;
+
+    if (!built || names == NULL || misses == NULL) {
+        fprintf(stderr, "Unable to build the registry\n");
+        return 1;
+    }
+
+    for (size_t i = 0; i < num_lookups; i++) {
+        names[i] = RTTI_DisplayName(types[BenchRandom(&state) % count]);
+        misses[i] = NULL;
+    }
+
+    // Misses are made once up front, for a handful of distinct names
+    for (size_t i = 0; i < num_lookups && i < 4096; i++) {
+        size_t length = strlen(names[i]);
+        misses[i] = malloc(length + 1);
+        memcpy(misses[i], names[i], length + 1);
+        misses[i][length - 1] ^= 0x20;
+    }
+
+    start = BenchNow();
+    for (size_t i = 0; i < num_lookups; i++)
+        found += RTTI_FindByName(names[i]) != NULL;
+    double hits = BenchNow() - start;
+
+    start = BenchNow();
+    for (size_t i = 0; i < num_lookups; i++)
+        found += RTTI_FindByName(misses[i & 4095]) != NULL;
+    double missed = BenchNow() - start;
+
+    printf("Registry of %zu types built in %.2f ms\n", count, build * 1e3);
+    printf("%zu hits in %.2f ms (%.1f ns each)\n", num_lookups, hits * 1e3, hits * 1e9 / (double) num_lookups);
+    printf("%zu misses in %.2f ms (%.1f ns each)\n", num_lookups, missed * 1e3, missed * 1e9 / (double) num_lookups);
+    printf("%zu found\n", found);
+
+    for (size_t i = 0; i < num_lookups && i < 4096; i++)
+        free(misses[i]);
+    free(misses);
+    free(names);
+
+    RegistryReset();
+    TraversalFree(&traversal);
+    RTTI_ResetDisplayNames();
+    RTTI_ResetEnumTables();
+    TypeHashReset();
+    LayoutReset();
+    PlanReset();
+    SessionReset();
+    SynthFree(&graph);
+    return 0;
+}
@@ -0,0 +1,69 @@
+#include "bench.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+struct Benchmark {
+    const char *name;
+    int (*run)(int argc, char **argv);
+};
+
+static const struct Benchmark g_benchmarks[] = {
+        {"scan", BenchScan},
+        {"scan-threads", BenchScanThreads},
+        {"resolve", BenchResolve},
+        {"traverse", BenchTraverse},
+        {"sort", BenchSort},
+        {"export", BenchExport},
+        {"diff", BenchDiff},
+        {"lookup", BenchLookup},
+        {"serialize", BenchSerialize},
+        {"enums", BenchEnums},
+        {"typedb", BenchTypeDb},
+};
+
+double BenchNow(void) {
+#ifdef _WIN32
+    LARGE_INTEGER counter, frequency;
+    QueryPerformanceCounter(&counter);
+    QueryPerformanceFrequency(&frequency);
+    return (double) counter.QuadPart / (double) frequency.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double) ts.tv_sec + (double) ts.tv_nsec * 1e-9;
+#endif
+}
+
+uint64_t BenchRandom(uint64_t *state) {
+    uint64_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    return *state = x;
+}
+
+int main(int argc, char **argv) {
+    size_t count = sizeof(g_benchmarks) / sizeof(*g_benchmarks);
+
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s <benchmark> [args...]\n\nBenchmarks:\n", argv[0]);
+        for (size_t i = 0; i < count; i++)
+            fprintf(stderr, "  %s\n", g_benchmarks[i].name);
+        return 1;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        if (strcmp(argv[1], g_benchmarks[i].name) == 0)
+            return g_benchmarks[i].run(argc - 2, argv + 2);
+    }
+
+    fprintf(stderr, "Unknown benchmark '%s'\n", argv[1]);
+    return 1;
+}
@@ -0,0 +1,258 @@
+#include "bench.h"
+#include "scan.h"
+#include "pe.h"
+#include "thread.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char *g_signatures[] = {
+        "40 55 48 8B EC 48 83 EC 70 80 3D ? ? ? ? ? 0F 85 ? ? ? ? 48 89 9C 24",
+        "40 55 53 56 48 8D 6C 24 ? 48 81 EC ? ? ? ? 0F B6 42 05 48 8B DA 48 8B",
+};
+
+// The scanner as it was before patterns were compiled, kept as the baseline
+static int LegacyScanPattern(uint8_t *start, const uint8_t *end, const char *pattern, uint8_t **position) {
+    while (start < end && *pattern) {
+        if (*pattern == '?') {
+            pattern += 2;
+        } else if (*start == strtol(pattern, NULL, 16)) {
+            pattern += 3;
+        } else {
+            *position = start + 1;
+            return 0;
+        }
+        start++;
+    }
+    return !*pattern;
+}
+
+static _Bool LegacyFindPattern(void *start, const void *end, const char *pattern, void **position) {
+    void *current = start;
+    while (current < end) {
+        if (LegacyScanPattern(current, end, pattern, (uint8_t **) &current)) {
+            *position = current;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/// Fills the buffer with bytes roughly distributed like x86-64 code, so that
+/// common opcode bytes produce a realistic number of false anchor hits.
+static void GenerateCode(uint8_t *buffer, size_t size, uint64_t seed) {
+    static const uint8_t common[] = {0x00, 0xCC, 0xFF, 0x48, 0x8B, 0x89, 0x24, 0x4C, 0x0F, 0x8D, 0xE8, 0x40, 0x55};
+
+    for (size_t i = 0; i < size; i++) {
+        uint64_t value = BenchRandom(&seed);
+        if ((value & 3) != 0)
+            buffer[i] = common[(value >> 8) % sizeof(common)];
+        else
+            buffer[i] = (uint8_t) (value >> 16);
+    }
+}
+
+static void PlantSignature(uint8_t *position, const char *signature) {
+    struct Pattern pattern;
+    CompilePattern(signature, &pattern);
+
+    for (size_t i = 0; i < pattern.length; i++) {
+        if (pattern.mask[i])
+            position[i] = pattern.bytes[i];
+    }
+}
+
+int BenchScan(int argc, char **argv) {
+    size_t size = (argc > 0 ? strtoull(argv[0], NULL, 10) : 256) << 20;
+    int iterations = argc > 1 ? atoi(argv[1]) : 3;
+    uint8_t *buffer = malloc(size);
+
+    if (buffer == NULL || size < 4096) {
+        fprintf(stderr, "Unable to allocate a %zu byte buffer\n", size);
+        free(buffer);
+        return 1;
+    }
+
+    GenerateCode(buffer, size, 0x9E3779B97F4A7C15ull);
+    PlantSignature(buffer + size - 2048, g_signatures[0]);
+    PlantSignature(buffer + size - 1024, g_signatures[1]);
+
+    printf("Scanning %zu MiB, %d iterations\n", size >> 20, iterations);
+
+    for (size_t s = 0; s < sizeof(g_signatures) / sizeof(*g_signatures); s++) {
+        void *legacy_position = NULL;
+        void *position = NULL;
+        double legacy_time = 0;
+        double time = 0;
+
+        for (int i = 0; i < iterations; i++) {
+            double start = BenchNow();
+            LegacyFindPattern(buffer, buffer + size, g_signatures[s], &legacy_position);
+            legacy_time += BenchNow() - start;
+
+            start = BenchNow();
+            FindPattern(buffer, buffer + size, g_signatures[s], &position);
+            time += BenchNow() - start;
+        }
+
+        if (position != legacy_position) {
+            fprintf(stderr, "Signature %zu: scanners disagree (%p vs %p)\n", s, position, legacy_position);
+            free(buffer);
+            return 1;
+        }
+
+        legacy_time /= iterations;
+        time /= iterations;
+
+        printf("signature %zu: legacy %8.2f ms (%7.1f MiB/s), compiled %8.2f ms (%7.1f MiB/s), x%.1f\n", s,
+               legacy_time * 1e3, (double) (size >> 20) / legacy_time,
+               time * 1e3, (double) (size >> 20) / time,
+               legacy_time / time);
+    }
+
+    struct Signature signatures[sizeof(g_signatures) / sizeof(*g_signatures)] = {0};
+    size_t num_signatures = sizeof(g_signatures) / sizeof(*g_signatures);
+    struct Section section = {buffer, buffer + size};
+    double separate_time = 0;
+    double time = 0;
+
+    for (size_t s = 0; s < num_signatures; s++) {
+        signatures[s].name = g_signatures[s];
+        signatures[s].pattern = g_signatures[s];
+    }
+
+    for (int i = 0; i < iterations; i++) {
+        double start = BenchNow();
+        for (size_t s = 0; s < num_signatures; s++) {
+            void *position;
+            FindPattern(buffer, buffer + size, g_signatures[s], &position);
+        }
+        separate_time += BenchNow() - start;
+
+        start = BenchNow();
+        FindPatterns(&section, signatures, num_signatures);
+        time += BenchNow() - start;
+    }
+
+    for (size_t s = 0; s < num_signatures; s++) {
+        void *position = NULL;
+        FindPattern(buffer, buffer + size, g_signatures[s], &position);
+
+        if (signatures[s].count == 0 || signatures[s].matches[0] != position) {
+            fprintf(stderr, "Signature %zu: single-pass scan disagrees\n", s);
+            free(buffer);
+            return 1;
+        }
+    }
+
+    printf("all signatures: separate passes %8.2f ms, single pass %8.2f ms\n",
+           separate_time / iterations * 1e3, time / iterations * 1e3);
+
+    free(buffer);
+    return 0;
+}
+
+int BenchScanThreads(int argc, char **argv) {
+    size_t size = (argc > 0 ? strtoull(argv[0], NULL, 10) : 512) << 20;
+    unsigned max_threads = argc > 1 ? (unsigned) atoi(argv[1]) : ThreadCount();
+    int iterations = argc > 2 ? atoi(argv[2]) : 3;
+    uint8_t *buffer = malloc(size);
+    struct Pattern pattern;
+
+    if (buffer == NULL || size < 4096) {
+        fprintf(stderr, "Unable to allocate a %zu byte buffer\n", size);
+        free(buffer);
+        return 1;
+    }
+
+    GenerateCode(buffer, size, 0x9E3779B97F4A7C15ull);
+    PlantSignature(buffer + size - 1024, g_signatures[0]);
+    CompilePattern(g_signatures[0], &pattern);
+
+    printf("Scanning %zu MiB, up to %u threads, %d iterations\n", size >> 20, max_threads, iterations);
+
+    double baseline = 0;
+
+    for (unsigned threads = 1; threads <= max_threads; threads = threads < max_threads && threads * 2 > max_threads ? max_threads : threads * 2) {
+        void *position = NULL;
+        double time = 0;
+
+        for (int i = 0; i < iterations; i++) {
+            double start = BenchNow();
+            FindCompiledPatternParallel(buffer, buffer + size, &pattern, threads, &position);
+            time += BenchNow() - start;
+        }
+
+        if (position != buffer + size - 1024) {
+            fprintf(stderr, "%u threads: wrong match %p\n", threads, position);
+            free(buffer);
+            return 1;
+        }
+
+        time /= iterations;
+        if (threads == 1)
+            baseline = time;
+
+        printf("%3u threads: %8.2f ms (%7.1f MiB/s), x%.2f\n", threads, time * 1e3, (double) (size >> 20) / time, baseline / time);
+
+        if (threads == max_threads)
+            break;
+    }
+
+    free(buffer);
+    return 0;
+}
+
+int BenchResolve(int argc, char **argv) {
+    struct PeImage image;
+    struct Section section;
+    size_t num_signatures = sizeof(g_signatures) / sizeof(*g_signatures);
+    struct Signature signatures[sizeof(g_signatures) / sizeof(*g_signatures)] = {0};
+
+    if (argc < 1) {
+        fprintf(stderr, "Usage: resolve <executable>\n");
+        return 1;
+    }
+
+    double start = BenchNow();
+
+    if (!PeOpen(argv[0], &image)) {
+        fprintf(stderr, "Unable to open '%s' as a PE image\n", argv[0]);
+        return 1;
+    }
+
+    double open_time = BenchNow() - start;
+
+    if (!PeFindSection(&image, ".text", &section)) {
+        fprintf(stderr, "Unable to find '.text' section in the executable\n");
+        PeClose(&image);
+        return 1;
+    }
+
+    for (size_t s = 0; s < num_signatures; s++) {
+        signatures[s].name = g_signatures[s];
+        signatures[s].pattern = g_signatures[s];
+    }
+
+    start = BenchNow();
+    FindPatterns(&section, signatures, num_signatures);
+    double scan_time = BenchNow() - start;
+
+    printf("Mapped %zu MiB in %.2f ms, scanned %zu MiB of '.text' in %.2f ms\n",
+           image.size >> 20, open_time * 1e3,
+           (size_t) ((uint8_t *) section.end - (uint8_t *) section.start) >> 20, scan_time * 1e3);
+
+    for (size_t s = 0; s < num_signatures; s++) {
+        printf("signature %zu: %zu match(es)", s, signatures[s].count);
+        for (size_t i = 0; i < signatures[s].count && i < SIGNATURE_MAX_MATCHES; i++) {
+            uint64_t address;
+            if (PeAddressOf(&image, signatures[s].matches[i], &address))
+                printf(" 0x%llx", (unsigned long long) address);
+        }
+        printf("\n");
+    }
+
+    PeClose(&image);
+    return 0;
+}
@@ -0,0 +1,279 @@
+#include "bench.h"
+#include "synth.h"
+#include "arena.h"
+#include "json.h"
+#include "layout.h"
+#include "plan.h"
+#include "typehash.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static void NaiveValue(struct JsonContext *ctx, struct RTTI *type, const uint8_t *memory);
+
+static uint64_t NaiveUnsigned(const uint8_t *memory, size_t size) {
+    uint64_t value = 0;
+
+    for (size_t i = 0; i < size && i < 8; i++)
+        value |= (uint64_t) memory[i] << i * 8;
+
+    return value;
+}
+
+static void NaiveHex(struct JsonContext *ctx, const uint8_t *memory, size_t size) {
+    char *text = malloc(size * 2 + 1);
+
+    for (size_t i = 0; i < size; i++)
+        snprintf(text + i * 2, 3, "%02X", memory[i]);
+    text[size * 2] = 0;
+
+    JsonValueStr(ctx, text);
+    free(text);
+}
+
+static float Pow2(int exponent) {
+    uint32_t bits = (uint32_t) (exponent + 127) << 23;
+    float value;
+
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+static float NaiveHalf(uint16_t half) {
+    int exponent = (half >> 10) & 0x1F;
+    float mantissa = (float) (half & 0x3FF);
+    float value = exponent ? (1024.0f + mantissa) * Pow2(exponent - 25) : mantissa * Pow2(-24);
+
+    return half & 0x8000 ? -value : value;
+}
+
+/// What the game would do without plans: the representation of an atom is looked up by name on every value.
+static void NaiveAtom(struct JsonContext *ctx, struct RTTIAtom *atom, const uint8_t *memory) {
+    struct RTTIAtom *base = atom;
+    const char *name = atom->mTypeName;
+
+    while (base->mBaseType != NULL && base->mBaseType != &base->base) {
+        base = (struct RTTIAtom *) base->mBaseType;
+        name = base->mTypeName;
+    }
+
+    if (strcmp(name, "bool") == 0) {
+        JsonValueBool(ctx, memory[0] != 0);
+    } else if (strcmp(name, "int8") == 0 || strcmp(name, "int16") == 0 || strcmp(name, "int") == 0
+               || strcmp(name, "int32") == 0 || strcmp(name, "int64") == 0) {
+        unsigned shift = 64 - atom->mSize * 8;
+        JsonValueNum(ctx, (int64_t) (NaiveUnsigned(memory, atom->mSize) << shift) >> shift);
+    } else if (strncmp(name, "uint", 4) == 0) {
+        JsonValueUnsigned(ctx, NaiveUnsigned(memory, atom->mSize));
+    } else if (strcmp(name, "float") == 0) {
+        float value;
+        memcpy(&value, memory, sizeof(value));
+        JsonValueFloat(ctx, value);
+    } else if (strcmp(name, "double") == 0) {
+        double value;
+        memcpy(&value, memory, sizeof(value));
+        JsonValueDouble(ctx, value);
+    } else if (strcmp(name, "HalfFloat") == 0) {
+        JsonValueFloat(ctx, NaiveHalf((uint16_t) NaiveUnsigned(memory, 2)));
+    } else if (strcmp(name, "String") == 0) {
+        const char *string;
+        memcpy(&string, memory, sizeof(string));
+        JsonValueStr(ctx, string ? string : "");
+    } else if (atom->mSimple) {
+        NaiveHex(ctx, memory, atom->mSize);
+    } else {
+        JsonValueNull(ctx);
+    }
+}
+
+static void NaiveFields(struct JsonContext *ctx, struct RTTICompound *compound, const uint8_t *memory) {
+    for (int i = 0; i < compound->mNumBases; i++)
+        NaiveFields(ctx, (struct RTTICompound *) compound->mBases[i].mType, memory + compound->mBases[i].mOffset);
+
+    for (int i = 0; i < compound->mNumAttrs; i++) {
+        if (compound->mAttrs[i].type == NULL)
+            continue;
+        JsonName(ctx, compound->mAttrs[i].mName);
+        NaiveValue(ctx, compound->mAttrs[i].type, memory + compound->mAttrs[i].mOffset);
+    }
+}
+
+static void NaiveValue(struct JsonContext *ctx, struct RTTI *type, const uint8_t *memory) {
+    struct RTTIEnum *enumeration = (struct RTTIEnum *) type;
+    struct RTTIContainer *container = (struct RTTIContainer *) type;
+    const char *name = NULL;
+    uint64_t value;
+    char address[32];
+    const uint8_t *items;
+
+    switch (type->kind) {
+        case RTTIKind_Atom:
+            NaiveAtom(ctx, (struct RTTIAtom *) type, memory);
+            break;
+        case RTTIKind_Enum:
+            value = NaiveUnsigned(memory, enumeration->size);
+            for (int i = 0; i < enumeration->num_values && name == NULL; i++)
+                name = enumeration->values[i].mValue == value ? enumeration->values[i].mName : NULL;
+            if (name != NULL)
+                JsonValueStr(ctx, name);
+            else
+                JsonValueUnsigned(ctx, value);
+            break;
+        case RTTIKind_EnumFlags:
+            value = NaiveUnsigned(memory, enumeration->size);
+            JsonBeginArray(ctx);
+            for (int i = 0; i < enumeration->num_values && value; i++) {
+                uint64_t mask = enumeration->values[i].mValue;
+                if (mask != 0 && (value & mask) == mask) {
+                    JsonValueStr(ctx, enumeration->values[i].mName);
+                    value &= ~mask;
+                }
+            }
+            if (value)
+                JsonValueUnsigned(ctx, value);
+            JsonEndArray(ctx);
+            break;
+        case RTTIKind_Compound:
+            JsonBeginObject(ctx);
+            NaiveFields(ctx, (struct RTTICompound *) type, memory);
+            JsonEndObject(ctx);
+            break;
+        case RTTIKind_Container:
+            if (strcmp(container->mContainerType->mTypeName, "Array") != 0) {
+                JsonValueNull(ctx);
+                break;
+            }
+            value = NaiveUnsigned(memory, 4);
+            memcpy(&items, memory + 8, sizeof(items));
+            JsonBeginArray(ctx);
+            for (uint64_t i = 0; i < value; i++) {
+                struct RTTI *item = container->mItemType;
+                uint32_t stride = item->kind == RTTIKind_Compound ? ((struct RTTICompound *) item)->mSize
+                                  : item->kind == RTTIKind_Atom ? ((struct RTTIAtom *) item)->mSize
+                                  : item->kind == RTTIKind_Container ? ((struct RTTIContainer *) item)->mContainerType->mSize
+                                  : item->kind == RTTIKind_Pointer ? ((struct RTTIPointer *) item)->mPointerType->mSize
+                                  : ((struct RTTIEnum *) item)->size;
+                NaiveValue(ctx, item, items + i * stride);
+            }
+            JsonEndArray(ctx);
+            break;
+        case RTTIKind_Pointer:
+            memcpy(&items, memory, sizeof(items));
+            if (items == NULL) {
+                JsonValueNull(ctx);
+                break;
+            }
+            snprintf(address, sizeof(address), "0x%llx", (unsigned long long) (uintptr_t) items);
+            JsonValueStr(ctx, address);
+            break;
+        default:
+            JsonValueNull(ctx);
+            break;
+    }
+}
+
+/// Serializes synthetic instances with their plans and with a writer that interprets the attrs and bases
+/// of every instance instead. Both write pointers as addresses and must agree byte for byte, the plans are
+/// then also run following Ref pointers, to JSON and to binary.
+int BenchSerialize(int argc, char **argv) {
+    size_t num_compounds = argc > 0 ? strtoull(argv[0], NULL, 10) : 20000;
+    size_t num_instances = argc > 1 ? strtoull(argv[1], NULL, 10) : 500;
+    struct SynthGraph graph;
+    struct SynthInstances instances = {0};
+    struct PlanWriter addresses = {.no_follow = 1};
+    uint64_t state = 0x2545F4914F6CDD1Dull;
+
+    if (num_compounds == 0 || !SynthGenerate(&graph, num_compounds, 12, 0x9E3779B97F4A7C15ull)) {
+        fprintf(stderr, "Unable to generate %zu compounds\n", num_compounds);
+        return 1;
+    }
+
+    struct RTTICompound **types = malloc(num_instances * sizeof(struct RTTICompound *));
+    void **objects = malloc(num_instances * sizeof(void *));
+    const struct Plan **plans = malloc(num_instances * sizeof(const struct Plan *));
+
+    for (size_t i = 0; types && objects && plans && i < num_instances; i++) {
+        types[i] = &graph.compounds[BenchRandom(&state) % graph.num_compounds];
+        objects[i] = SynthInstance(&instances, types[i], &state);
+        if (objects[i] == NULL) {
+            fprintf(stderr, "Unable to build instance %zu\n", i);
+            return 1;
+        }
+    }
+
+    if (types == NULL || objects == NULL || plans == NULL) {
+        fprintf(stderr, "Unable to allocate %zu instances\n", num_instances);
+        return 1;
+    }
+
+    printf("Serializing %zu instances (%zu objects) of %zu compounds\n", num_instances, instances.count, num_compounds);
+
+    double start = BenchNow();
+    for (size_t i = 0; i < num_instances; i++)
+        plans[i] = PlanOf(&types[i]->base);
+    double compile = BenchNow() - start;
+
+    struct JsonContext naive;
+    JsonInit(&naive, NULL);
+    start = BenchNow();
+    JsonBeginArray(&naive);
+    for (size_t i = 0; i < num_instances; i++)
+        NaiveValue(&naive, &types[i]->base, objects[i]);
+    JsonEndArray(&naive);
+    double interpreted = BenchNow() - start;
+
+    struct JsonContext planned;
+    JsonInit(&planned, NULL);
+    start = BenchNow();
+    JsonBeginArray(&planned);
+    for (size_t i = 0; i < num_instances; i++)
+        PlanWriteJson(&planned, plans[i], objects[i], &addresses);
+    JsonEndArray(&planned);
+    double lowered = BenchNow() - start;
+
+    _Bool identical = naive.length == planned.length && memcmp(naive.buffer, planned.buffer, naive.length) == 0;
+
+    struct JsonContext followed;
+    JsonInit(&followed, NULL);
+    start = BenchNow();
+    JsonBeginArray(&followed);
+    for (size_t i = 0; i < num_instances; i++)
+        PlanWriteJson(&followed, plans[i], objects[i], NULL);
+    JsonEndArray(&followed);
+    double following = BenchNow() - start;
+
+    FILE *file = tmpfile();
+    _Bool written = file != NULL;
+    start = BenchNow();
+    for (size_t i = 0; i < num_instances && written; i++)
+        written = PlanWriteBinary(file, plans[i], objects[i], NULL);
+    double binary = BenchNow() - start;
+    long binary_size = written ? ftell(file) : -1;
+
+    printf("Plans compiled in %.2f ms\n", compile * 1e3);
+    printf("Interpreted JSON in %.2f ms, %zu bytes\n", interpreted * 1e3, naive.length);
+    printf("Planned JSON in %.2f ms, %zu bytes (%.2fx), %s\n", lowered * 1e3, planned.length, interpreted / lowered,
+           identical ? "identical" : "DIFFERENT");
+    printf("Planned JSON following Refs in %.2f ms, %zu bytes\n", following * 1e3, followed.length);
+    printf("Planned binary following Refs in %.2f ms, %ld bytes\n", binary * 1e3, binary_size);
+
+    if (file != NULL)
+        fclose(file);
+    JsonFinish(&naive);
+    JsonFinish(&planned);
+    JsonFinish(&followed);
+    free(types);
+    free(objects);
+    free(plans);
+
+    RTTI_ResetDisplayNames();
+    RTTI_ResetEnumTables();
+    TypeHashReset();
+    LayoutReset();
+    PlanReset();
+    SessionReset();
+    SynthInstancesFree(&instances);
+    SynthFree(&graph);
+    return identical && written ? 0 : 1;
+}
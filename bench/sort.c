@@ -0,0 +1,67 @@
+#include "bench.h"
+#include "synth.h"
+#include "sort.h"
+#include "arena.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+int BenchSort(int argc, char **argv) {
+    size_t num_compounds = argc > 0 ? strtoull(argv[0], NULL, 10) : 100000;
+    int iterations = argc > 1 ? atoi(argv[1]) : 5;
+    struct SynthGraph graph;
+    double legacy_time = 0;
+    double radix_time = 0;
+
+    if (!SynthGenerate(&graph, num_compounds, 12, 0x9E3779B97F4A7C15ull)) {
+        fprintf(stderr, "Unable to generate %zu compounds\n", num_compounds);
+        return 1;
+    }
+
+    struct RTTI **legacy = malloc(graph.count * sizeof(struct RTTI *));
+    struct RTTI **radix = malloc(graph.count * sizeof(struct RTTI *));
+    uint64_t state = 0x2545F4914F6CDD1Dull;
+
+    printf("Sorting %zu types, %d iterations\n", graph.count, iterations);
+
+    for (int i = 0; i < iterations; i++) {
+        // Discovery order is unrelated to the sorted one
+        memcpy(legacy, graph.types, graph.count * sizeof(struct RTTI *));
+        for (size_t j = graph.count; j > 1; j--) {
+            size_t k = (size_t) (BenchRandom(&state) % j);
+            struct RTTI *swap = legacy[j - 1];
+            legacy[j - 1] = legacy[k];
+            legacy[k] = swap;
+        }
+        memcpy(radix, legacy, graph.count * sizeof(struct RTTI *));
+
+        double start = BenchNow();
+        qsort(legacy, graph.count, sizeof(struct RTTI *), RTTIKind_CompareLexical);
+        legacy_time += BenchNow() - start;
+
+        start = BenchNow();
+        SortTypes(radix, graph.count);
+        radix_time += BenchNow() - start;
+
+        if (memcmp(legacy, radix, graph.count * sizeof(struct RTTI *)) != 0) {
+            fprintf(stderr, "Sorted order differs from qsort\n");
+            free(legacy);
+            free(radix);
+            SessionReset();
+            SynthFree(&graph);
+            return 1;
+        }
+    }
+
+    legacy_time /= iterations;
+    radix_time /= iterations;
+    printf("qsort: %8.2f ms\n", legacy_time * 1e3);
+    printf("radix: %8.2f ms, x%.2f\n", radix_time * 1e3, legacy_time / radix_time);
+
+    free(legacy);
+    free(radix);
+    SessionReset();
+    SynthFree(&graph);
+    return 0;
+}
@@ -0,0 +1,517 @@
+#include "synth.h"
+#include "bench.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SYNTH_NAME_LENGTH 32
+#define SYNTH_MAX_INSTANCE_DEPTH 4 ///< Nested arrays and new objects pointed to, below that arrays are empty and Refs NULL
+
+struct SynthAtom {
+    const char *name;
+    uint16_t size;
+    uint8_t simple;
+};
+
+static const struct SynthAtom g_atoms[] = {
+        {"bool", 1, 1},
+        {"int8", 1, 1},
+        {"uint8", 1, 1},
+        {"int16", 2, 1},
+        {"uint16", 2, 1},
+        {"int", 4, 1},
+        {"int32", 4, 1},
+        {"uint", 4, 1},
+        {"uint32", 4, 1},
+        {"int64", 8, 1},
+        {"uint64", 8, 1},
+        {"float", 4, 1},
+        {"double", 8, 1},
+        {"HalfFloat", 2, 1},
+        {"String", 8, 0},
+        {"GGUUID", 16, 1},
+};
+
+static struct RTTIContainerData g_array_data = {.mTypeName = "Array", .mSize = 16, .mAlignment = 8};
+static struct RTTIPointerData g_ref_data = {.mTypeName = "Ref", .mSize = 8, .mAlignment = 8};
+static struct RTTIPointerData g_streaming_ref_data = {.mTypeName = "StreamingRef", .mSize = 8, .mAlignment = 8};
+static struct RTTIPointerData g_uuid_ref_data = {.mTypeName = "UUIDRef", .mSize = 8, .mAlignment = 8};
+
+static const char *g_strings[] = {"", "Name", "Some longer string value", "Quote \" and backslash \\", "Line\nbreak"};
+
+static char g_attr_names[256][8];
+
+static size_t Pick(uint64_t *state, size_t count) {
+    return (size_t) (BenchRandom(state) % count);
+}
+
+static uint32_t SizeOf(struct RTTI *rtti) {
+    switch (rtti->kind) {
+        case RTTIKind_Atom:
+            return ((struct RTTIAtom *) rtti)->mSize;
+        case RTTIKind_Enum:
+        case RTTIKind_EnumFlags:
+            return ((struct RTTIEnum *) rtti)->size;
+        case RTTIKind_Container:
+            return ((struct RTTIContainer *) rtti)->mContainerType->mSize;
+        case RTTIKind_Pointer:
+            return ((struct RTTIPointer *) rtti)->mPointerType->mSize;
+        case RTTIKind_Compound:
+            return ((struct RTTICompound *) rtti)->mSize;
+        default:
+            return 0;
+    }
+}
+
+static uint32_t AlignmentOf(struct RTTI *rtti) {
+    uint32_t size = SizeOf(rtti);
+    if (rtti->kind == RTTIKind_Compound)
+        return ((struct RTTICompound *) rtti)->mAlignment;
+    return size >= 8 ? 8 : size ? size : 1;
+}
+
+static uint32_t AlignUp(uint32_t value, uint32_t alignment) {
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+/// Picks the item type of a container or pointer among the types generated so far.
+static struct RTTI *PickItem(struct SynthGraph *graph, uint64_t *state, size_t num_compounds) {
+    size_t choice = Pick(state, 10);
+
+    if (choice < 4 || (choice >= 6 && num_compounds == 0))
+        return &graph->atoms[Pick(state, graph->num_atoms)].base;
+    if (choice < 6)
+        return &graph->enums[Pick(state, graph->num_enums)].base;
+    return &graph->compounds[Pick(state, num_compounds)].base;
+}
+
+_Bool SynthGenerate(struct SynthGraph *graph, size_t num_compounds, size_t attrs_per_compound, uint64_t seed) {
+    uint64_t state = seed ? seed : 0x2545F4914F6CDD1Dull;
+    size_t max_attrs = attrs_per_compound * 2 < 255 ? attrs_per_compound * 2 : 255;
+
+    memset(graph, 0, sizeof(*graph));
+
+    for (size_t i = 0; i < 256; i++)
+        snprintf(g_attr_names[i], sizeof(g_attr_names[i]), "m%zu", i);
+
+    graph->num_atoms = sizeof(g_atoms) / sizeof(*g_atoms);
+    graph->num_enums = num_compounds / 8 + 1;
+    graph->num_containers = num_compounds / 4 + 1;
+    graph->num_pointers = num_compounds / 4 + 1;
+    graph->num_compounds = num_compounds;
+    graph->count = graph->num_atoms + graph->num_enums + graph->num_containers + graph->num_pointers + graph->num_compounds;
+
+    graph->atoms = calloc(graph->num_atoms, sizeof(struct RTTIAtom));
+    graph->enums = calloc(graph->num_enums, sizeof(struct RTTIEnum));
+    graph->values = calloc(graph->num_enums * 32, sizeof(struct RTTIValue));
+    graph->containers = calloc(graph->num_containers, sizeof(struct RTTIContainer));
+    graph->pointers = calloc(graph->num_pointers, sizeof(struct RTTIPointer));
+    graph->compounds = calloc(num_compounds ? num_compounds : 1, sizeof(struct RTTICompound));
+    graph->attrs = calloc(num_compounds * max_attrs + 1, sizeof(struct RTTIAttr));
+    graph->bases = calloc(num_compounds * 2 + 1, sizeof(struct RTTIBase));
+    graph->handlers = calloc(num_compounds * 3 + 1, sizeof(struct RTTIMessageHandler));
+    graph->names = calloc(graph->count + graph->num_enums * 32, SYNTH_NAME_LENGTH);
+    graph->types = malloc(graph->count * sizeof(struct RTTI *));
+    graph->roots = malloc((graph->num_enums + num_compounds) * sizeof(struct RTTI *));
+
+    if (!graph->atoms || !graph->enums || !graph->values || !graph->containers || !graph->pointers || !graph->compounds
+        || !graph->attrs || !graph->bases || !graph->handlers || !graph->names || !graph->types || !graph->roots) {
+        SynthFree(graph);
+        return 0;
+    }
+
+    char *name = graph->names;
+    size_t num_types = 0;
+    uint32_t id = 1;
+
+    for (size_t i = 0; i < graph->num_atoms; i++) {
+        struct RTTIAtom *atom = &graph->atoms[i];
+        atom->base = (struct RTTI) {id++, RTTIKind_Atom, 0};
+        atom->mSize = g_atoms[i].size;
+        atom->mAlignment = (uint8_t) (g_atoms[i].size >= 8 ? 8 : g_atoms[i].size);
+        atom->mSimple = g_atoms[i].simple;
+        atom->mTypeName = g_atoms[i].name;
+        atom->mBaseType = &atom->base;
+        graph->types[num_types++] = &atom->base;
+    }
+
+    // Aliases of the plain integer atoms share their base type, as in the game
+    graph->atoms[6].mBaseType = &graph->atoms[5].base;
+    graph->atoms[7].mBaseType = &graph->atoms[8].base;
+
+    for (size_t i = 0; i < graph->num_enums; i++) {
+        struct RTTIEnum *enumeration = &graph->enums[i];
+        _Bool flags = Pick(&state, 4) == 0;
+        size_t num_values = 2 + Pick(&state, flags ? 15 : 30);
+
+        enumeration->base = (struct RTTI) {id++, (uint8_t) (flags ? RTTIKind_EnumFlags : RTTIKind_Enum), 0};
+        enumeration->size = (uint8_t) (flags ? 4 : 1 << Pick(&state, 3));
+        enumeration->alignment = enumeration->size;
+        enumeration->num_values = (uint16_t) num_values;
+        enumeration->values = &graph->values[i * 32];
+        snprintf(name, SYNTH_NAME_LENGTH, "%s%zu", flags ? "EFlags" : "EEnum", i);
+        enumeration->type_name = name;
+        name += SYNTH_NAME_LENGTH;
+
+        for (size_t j = 0; j < num_values; j++) {
+            struct RTTIValue *value = &enumeration->values[j];
+            value->mValue = flags ? (uint64_t) 1 << j : j * (1 + Pick(&state, 2));
+            snprintf(name, SYNTH_NAME_LENGTH, "Value%zu", j);
+            value->mName = name;
+            name += SYNTH_NAME_LENGTH;
+            if (j % 7 == 3)
+                value->mAliases[0] = g_attr_names[j];
+        }
+
+        // Keep plain enum values sorted and unique like the game does
+        for (size_t j = 1; !flags && j < num_values; j++) {
+            if (enumeration->values[j].mValue <= enumeration->values[j - 1].mValue)
+                enumeration->values[j].mValue = enumeration->values[j - 1].mValue + 1;
+        }
+
+        graph->types[num_types++] = &enumeration->base;
+        graph->roots[graph->num_roots++] = &enumeration->base;
+    }
+
+    size_t num_attrs = 0;
+    size_t num_bases = 0;
+    size_t num_handlers = 0;
+    size_t num_containers = 0;
+    size_t num_pointers = 0;
+
+    for (size_t i = 0; i < num_compounds; i++) {
+        struct RTTICompound *compound = &graph->compounds[i];
+        uint32_t size = 0;
+        uint32_t alignment = 8;
+
+        compound->base = (struct RTTI) {id++, RTTIKind_Compound, 0};
+        compound->mVersion = (uint32_t) Pick(&state, 4);
+        compound->mFlags = (uint16_t) Pick(&state, 4);
+        snprintf(name, SYNTH_NAME_LENGTH, "Compound%06zu", i);
+        compound->mTypeName = name;
+        name += SYNTH_NAME_LENGTH;
+
+        // Bases only come from earlier compounds, so the base graph is a DAG like in the game
+        size_t bases = i == 0 ? 0 : Pick(&state, 10) < 5 ? 1 : Pick(&state, 10) == 0 ? 2 : 0;
+        compound->mBases = &graph->bases[num_bases];
+        for (size_t j = 0; j < bases; j++) {
+            struct RTTICompound *base = &graph->compounds[Pick(&state, i)];
+            if (base->mSize > 1024)
+                continue;
+            size = AlignUp(size, base->mAlignment);
+            graph->bases[num_bases++] = (struct RTTIBase) {&base->base, size};
+            size += base->mSize;
+            compound->mNumBases++;
+        }
+
+        size_t attrs = max_attrs ? Pick(&state, max_attrs + 1) : 0;
+        compound->mAttrs = &graph->attrs[num_attrs];
+        for (size_t j = 0; j < attrs; j++) {
+            struct RTTIAttr *attr = &graph->attrs[num_attrs];
+            size_t choice = Pick(&state, 20);
+            struct RTTI *type;
+
+            if (choice == 0) {
+                // Categories have no type and only group the attrs that follow
+                attr->mName = "Category";
+                num_attrs++;
+                compound->mNumAttrs++;
+                continue;
+            } else if (choice < 9) {
+                type = &graph->atoms[Pick(&state, graph->num_atoms)].base;
+            } else if (choice < 11) {
+                type = &graph->enums[Pick(&state, graph->num_enums)].base;
+            } else if (choice < 14 && num_containers < graph->num_containers) {
+                struct RTTIContainer *container = &graph->containers[num_containers++];
+                container->base = (struct RTTI) {id++, RTTIKind_Container, 0};
+                container->mItemType = PickItem(graph, &state, i);
+                container->mContainerType = &g_array_data;
+                snprintf(name, SYNTH_NAME_LENGTH, "Array_%zu", num_containers);
+                container->mTypeName = name;
+                name += SYNTH_NAME_LENGTH;
+                type = &container->base;
+            } else if (choice < 17 && num_pointers < graph->num_pointers) {
+                struct RTTIPointer *pointer = &graph->pointers[num_pointers++];
+                size_t kind = Pick(&state, 3);
+                pointer->base = (struct RTTI) {id++, RTTIKind_Pointer, 0};
+                pointer->mItemType = num_compounds ? &graph->compounds[Pick(&state, num_compounds)].base : &graph->atoms[0].base;
+                pointer->mPointerType = kind == 0 ? &g_ref_data : kind == 1 ? &g_streaming_ref_data : &g_uuid_ref_data;
+                snprintf(name, SYNTH_NAME_LENGTH, "%s_%zu", pointer->mPointerType->mTypeName, num_pointers);
+                pointer->mTypeName = name;
+                name += SYNTH_NAME_LENGTH;
+                type = &pointer->base;
+            } else if (i > 0 && graph->compounds[Pick(&state, i)].mSize <= 256) {
+                type = &graph->compounds[Pick(&state, i)].base;
+                if (SizeOf(type) > 256)
+                    type = &graph->atoms[5].base;
+            } else {
+                type = &graph->atoms[Pick(&state, graph->num_atoms)].base;
+            }
+
+            uint32_t offset = AlignUp(size, AlignmentOf(type));
+            if (offset + SizeOf(type) > 0xF000)
+                break;
+
+            attr->type = type;
+            attr->mName = g_attr_names[j];
+            attr->mOffset = (uint16_t) offset;
+            attr->mFlags = (uint16_t) Pick(&state, 3);
+            if (Pick(&state, 16) == 0) {
+                attr->mMinValue = "0";
+                attr->mMaxValue = "100";
+            }
+            size = offset + SizeOf(type);
+            num_attrs++;
+            compound->mNumAttrs++;
+        }
+
+        if (Pick(&state, 10) == 0 && i > 0) {
+            size_t handlers = 1 + Pick(&state, 3);
+            compound->mMessageHandlers = &graph->handlers[num_handlers];
+            for (size_t j = 0; j < handlers; j++)
+                graph->handlers[num_handlers++].mMessage = &graph->compounds[Pick(&state, i)].base;
+            compound->mNumMessageHandlers = (uint8_t) handlers;
+        }
+
+        compound->mAlignment = (uint16_t) alignment;
+        compound->mSize = AlignUp(size ? size : 1, alignment);
+
+        graph->types[num_types++] = &compound->base;
+    }
+
+    graph->num_containers = num_containers;
+    graph->num_pointers = num_pointers;
+    graph->num_attrs = num_attrs;
+
+    for (size_t i = 0; i < num_containers; i++)
+        graph->types[num_types++] = &graph->containers[i].base;
+    for (size_t i = 0; i < num_pointers; i++)
+        graph->types[num_types++] = &graph->pointers[i].base;
+
+    graph->count = num_types;
+
+    for (size_t i = 0; i < num_compounds; i++)
+        graph->roots[graph->num_roots++] = &graph->compounds[i].base;
+
+    // Registration order in the game has nothing to do with the dependency order
+    for (size_t i = graph->num_roots; i > 1; i--) {
+        size_t j = Pick(&state, i);
+        struct RTTI *swap = graph->roots[i - 1];
+        graph->roots[i - 1] = graph->roots[j];
+        graph->roots[j] = swap;
+    }
+
+    return 1;
+}
+
+struct RTTI *SynthChain(struct SynthGraph *graph, size_t length) {
+    free(graph->chain);
+    graph->chain = calloc(length ? length : 1, sizeof(struct RTTIContainer));
+
+    if (graph->chain == NULL || length == 0)
+        return NULL;
+
+    struct RTTI *item = &graph->atoms[5].base;
+
+    for (size_t i = 0; i < length; i++) {
+        struct RTTIContainer *container = &graph->chain[i];
+        container->base = (struct RTTI) {(uint32_t) (0x80000000u + i), RTTIKind_Container, 0};
+        container->mItemType = item;
+        container->mContainerType = &g_array_data;
+        container->mTypeName = "Array_Chain";
+        item = &container->base;
+    }
+
+    return item;
+}
+
+void SynthFree(struct SynthGraph *graph) {
+    free(graph->types);
+    free(graph->roots);
+    free(graph->atoms);
+    free(graph->enums);
+    free(graph->values);
+    free(graph->containers);
+    free(graph->pointers);
+    free(graph->compounds);
+    free(graph->attrs);
+    free(graph->bases);
+    free(graph->handlers);
+    free(graph->names);
+    free(graph->chain);
+    memset(graph, 0, sizeof(*graph));
+}
+
+static void *InstanceAlloc(struct SynthInstances *instances, size_t size) {
+    if (instances->num_blocks == instances->capacity) {
+        size_t capacity = instances->capacity ? instances->capacity * 2 : 256;
+        void **blocks = realloc(instances->blocks, capacity * sizeof(void *));
+        if (blocks == NULL)
+            return NULL;
+        instances->blocks = blocks;
+        instances->capacity = capacity;
+    }
+
+    void *block = calloc(1, size ? size : 1);
+    if (block != NULL)
+        instances->blocks[instances->num_blocks++] = block;
+    return block;
+}
+
+static void WriteUnsigned(uint8_t *memory, uint64_t value, size_t size) {
+    for (size_t i = 0; i < size && i < 8; i++)
+        memory[i] = (uint8_t) (value >> i * 8);
+}
+
+static _Bool FillValue(struct SynthInstances *instances, struct RTTI *type, uint8_t *memory, uint64_t *state, int depth);
+
+static _Bool FillCompound(struct SynthInstances *instances, struct RTTICompound *compound, uint8_t *memory, uint64_t *state, int depth) {
+    _Bool filled = 1;
+
+    for (int i = 0; i < compound->mNumBases && filled; i++)
+        filled = FillCompound(instances, (struct RTTICompound *) compound->mBases[i].mType, memory + compound->mBases[i].mOffset, state, depth);
+
+    for (int i = 0; i < compound->mNumAttrs && filled; i++) {
+        if (compound->mAttrs[i].type != NULL)
+            filled = FillValue(instances, compound->mAttrs[i].type, memory + compound->mAttrs[i].mOffset, state, depth);
+    }
+
+    return filled;
+}
+
+static void *NewInstance(struct SynthInstances *instances, struct RTTICompound *compound, uint64_t *state, int depth) {
+    if (instances->count == instances->max_count) {
+        size_t max_count = instances->max_count ? instances->max_count * 2 : 256;
+        struct RTTI **types = realloc(instances->types, max_count * sizeof(struct RTTI *));
+        void **objects = types ? realloc(instances->objects, max_count * sizeof(void *)) : NULL;
+
+        if (types)
+            instances->types = types;
+        if (objects == NULL)
+            return NULL;
+
+        instances->objects = objects;
+        instances->max_count = max_count;
+    }
+
+    void *object = InstanceAlloc(instances, compound->mSize);
+    if (object == NULL)
+        return NULL;
+
+    // Known before it is filled, so that it can be pointed to from within
+    instances->types[instances->count] = &compound->base;
+    instances->objects[instances->count++] = object;
+
+    return FillCompound(instances, compound, object, state, depth) ? object : NULL;
+}
+
+/// An earlier object of the type within the instance being built, NULL when a few random picks find none.
+static void *EarlierInstance(struct SynthInstances *instances, struct RTTI *type, uint64_t *state) {
+    for (int i = 0; i < 16; i++) {
+        size_t index = instances->first + Pick(state, instances->count - instances->first);
+        if (instances->types[index] == type)
+            return instances->objects[index];
+    }
+
+    return NULL;
+}
+
+static _Bool FillAtom(struct RTTIAtom *atom, uint8_t *memory, uint64_t *state) {
+    if (strcmp(atom->mTypeName, "String") == 0) {
+        const char *string = g_strings[Pick(state, sizeof(g_strings) / sizeof(*g_strings))];
+        memcpy(memory, &string, sizeof(string));
+    } else if (strcmp(atom->mTypeName, "float") == 0) {
+        float value = (float) ((double) Pick(state, 2000001) - 1e6) / 64.0f;
+        memcpy(memory, &value, sizeof(value));
+    } else if (strcmp(atom->mTypeName, "double") == 0) {
+        double value = ((double) Pick(state, 2000001) - 1e6) / 1e3;
+        memcpy(memory, &value, sizeof(value));
+    } else if (strcmp(atom->mTypeName, "HalfFloat") == 0) {
+        // Any finite half, the exponent of infinities and NaNs is left out
+        WriteUnsigned(memory, Pick(state, 2) << 15 | Pick(state, 31) << 10 | Pick(state, 1024), 2);
+    } else if (strcmp(atom->mTypeName, "bool") == 0) {
+        memory[0] = (uint8_t) Pick(state, 2);
+    } else {
+        for (uint16_t i = 0; i < atom->mSize; i++)
+            memory[i] = (uint8_t) BenchRandom(state);
+    }
+
+    return 1;
+}
+
+static _Bool FillValue(struct SynthInstances *instances, struct RTTI *type, uint8_t *memory, uint64_t *state, int depth) {
+    struct RTTIEnum *enumeration = (struct RTTIEnum *) type;
+    struct RTTIContainer *container = (struct RTTIContainer *) type;
+    struct RTTIPointer *pointer = (struct RTTIPointer *) type;
+    uint64_t value = 0;
+
+    switch (type->kind) {
+        case RTTIKind_Atom:
+            return FillAtom((struct RTTIAtom *) type, memory, state);
+        case RTTIKind_Enum:
+            WriteUnsigned(memory, enumeration->values[Pick(state, enumeration->num_values)].mValue, enumeration->size);
+            return 1;
+        case RTTIKind_EnumFlags:
+            for (int i = 0; i < enumeration->num_values; i++)
+                value |= Pick(state, 3) == 0 ? enumeration->values[i].mValue : 0;
+            WriteUnsigned(memory, value, enumeration->size);
+            return 1;
+        case RTTIKind_Compound:
+            return FillCompound(instances, (struct RTTICompound *) type, memory, state, depth);
+        case RTTIKind_Container: {
+            uint32_t count = depth < SYNTH_MAX_INSTANCE_DEPTH ? (uint32_t) Pick(state, 4) : 0;
+            uint32_t stride = SizeOf(container->mItemType);
+            uint8_t *items = count ? InstanceAlloc(instances, (size_t) count * stride) : NULL;
+
+            if (count && items == NULL)
+                return 0;
+
+            for (uint32_t i = 0; i < count; i++) {
+                if (!FillValue(instances, container->mItemType, items + (size_t) i * stride, state, depth + 1))
+                    return 0;
+            }
+
+            WriteUnsigned(memory, count, 4);
+            WriteUnsigned(memory + 4, count, 4);
+            memcpy(memory + 8, &items, sizeof(items));
+            return 1;
+        }
+        case RTTIKind_Pointer: {
+            void *target = NULL;
+            size_t choice = Pick(state, 4);
+
+            if (strcmp(pointer->mPointerType->mTypeName, "Ref") != 0) {
+                // Never followed, any address will do
+                target = (void *) (uintptr_t) (0x10000 + Pick(state, 0x10000) * 16);
+            } else if (pointer->mItemType->kind != RTTIKind_Compound || choice == 0) {
+                target = NULL;
+            } else if (choice == 1) {
+                target = EarlierInstance(instances, pointer->mItemType, state);
+            } else if (depth < SYNTH_MAX_INSTANCE_DEPTH) {
+                target = NewInstance(instances, (struct RTTICompound *) pointer->mItemType, state, depth + 1);
+                if (target == NULL)
+                    return 0;
+            }
+
+            memcpy(memory, &target, sizeof(target));
+            return 1;
+        }
+        default:
+            return 1;
+    }
+}
+
+void *SynthInstance(struct SynthInstances *instances, struct RTTICompound *compound, uint64_t *state) {
+    instances->first = instances->count;
+    return NewInstance(instances, compound, state, 0);
+}
+
+void SynthInstancesFree(struct SynthInstances *instances) {
+    for (size_t i = 0; i < instances->num_blocks; i++)
+        free(instances->blocks[i]);
+    free(instances->blocks);
+    free(instances->types);
+    free(instances->objects);
+    memset(instances, 0, sizeof(*instances));
+}
@@ -0,0 +1,64 @@
+#ifndef DECIMA_NATIVE_SYNTH_H
+#define DECIMA_NATIVE_SYNTH_H
+
+#include "rtti.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+/// A randomly generated, internally consistent RTTI graph built from the rtti.h structs:
+/// atoms, enums and flags, containers, pointers and compounds with bases, attrs and message handlers.
+/// Offsets and sizes are laid out for real, so instances of the compounds can be built too.
+struct SynthGraph {
+    struct RTTI **types; ///< Every generated type
+    size_t count;
+    struct RTTI **roots; ///< Compounds and enums in a random "registration" order
+    size_t num_roots;
+    size_t num_attrs;
+
+    struct RTTIAtom *atoms;
+    size_t num_atoms;
+    struct RTTIEnum *enums;
+    size_t num_enums;
+    struct RTTIValue *values;
+    struct RTTIContainer *containers;
+    size_t num_containers;
+    struct RTTIPointer *pointers;
+    size_t num_pointers;
+    struct RTTICompound *compounds;
+    size_t num_compounds;
+    struct RTTIAttr *attrs;
+    struct RTTIBase *bases;
+    struct RTTIMessageHandler *handlers;
+    char *names;
+    struct RTTIContainer *chain;
+};
+
+/// Instances of synthetic compounds, every allocation is kept so that they can be freed at once.
+struct SynthInstances {
+    void **blocks;
+    size_t num_blocks;
+    size_t capacity;
+    struct RTTI **types; ///< Of every compound instance, parallel to `objects`
+    void **objects;
+    size_t count;
+    size_t max_count;
+    size_t first; ///< First object of the instance being built, only those are pointed to again
+};
+
+_Bool SynthGenerate(struct SynthGraph *graph, size_t num_compounds, size_t attrs_per_compound, uint64_t seed);
+
+void SynthFree(struct SynthGraph *graph);
+
+/// Builds `length` nested containers (Array<Array<...<int>...>>) to stress traversal depth.
+struct RTTI *SynthChain(struct SynthGraph *graph, size_t length);
+
+/// Builds a random instance of a compound where every value is valid: strings point to static strings,
+/// enums hold one of their values, arrays are {uint32_t count, uint32_t capacity, items} and Ref pointers
+/// point to NULL, to a new object or to an earlier object of the same instance, which makes for cycles.
+/// Other pointers hold an address that must not be followed. NULL when out of memory.
+void *SynthInstance(struct SynthInstances *instances, struct RTTICompound *compound, uint64_t *state);
+
+void SynthInstancesFree(struct SynthInstances *instances);
+
+#endif //DECIMA_NATIVE_SYNTH_H
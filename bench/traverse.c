@@ -0,0 +1,135 @@
+#include "bench.h"
+#include "synth.h"
+#include "traverse.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+struct Order {
+    struct RTTI **items;
+    size_t count;
+};
+
+static void Record(struct RTTI *rtti, void *context) {
+    struct Order *order = context;
+    order->items[order->count++] = rtti;
+}
+
+// The recursive walk the hook used before, extended to the same edges, kept as the baseline
+static void LegacyScanType(struct RTTI *rtti, struct TypeSet *registered, struct Order *order) {
+    union {
+        struct RTTIContainer *container;
+        struct RTTIPointer *pointer;
+        struct RTTIAtom *atom;
+        struct RTTICompound *compound;
+        struct RTTIEnum *enumeration;
+    } object;
+
+    if (rtti == NULL || !TypeSetInsert(registered, rtti))
+        return;
+
+    Record(rtti, order);
+
+    if (RTTI_AsContainer(rtti, &object.container))
+        LegacyScanType(object.container->mItemType, registered, order);
+    else if (RTTI_AsPointer(rtti, &object.pointer))
+        LegacyScanType(object.pointer->mItemType, registered, order);
+    else if (RTTI_AsAtom(rtti, &object.atom)) {
+        LegacyScanType(object.atom->mBaseType, registered, order);
+        LegacyScanType(object.atom->representation_type, registered, order);
+    } else if (RTTI_AsEnum(rtti, &object.enumeration))
+        LegacyScanType(object.enumeration->representation_type, registered, order);
+    else if (RTTI_AsCompound(rtti, &object.compound)) {
+        struct RTTICompound *compound = object.compound;
+        for (int index = 0; index < compound->mNumBases; index++)
+            LegacyScanType(compound->mBases[index].mType, registered, order);
+        for (int index = 0; index < compound->mNumAttrs; index++)
+            LegacyScanType(compound->mAttrs[index].type, registered, order);
+        for (int index = 0; index < compound->mNumMessageHandlers; index++)
+            LegacyScanType(compound->mMessageHandlers[index].mMessage, registered, order);
+        for (int index = 0; index < compound->mNumMessageOrderEntries; index++) {
+            LegacyScanType(compound->mMessageOrderEntries[index].mMessage, registered, order);
+            LegacyScanType(compound->mMessageOrderEntries[index].mCompound, registered, order);
+        }
+        LegacyScanType(compound->representation_type, registered, order);
+    }
+}
+
+int BenchTraverse(int argc, char **argv) {
+    size_t num_compounds = argc > 0 ? strtoull(argv[0], NULL, 10) : 100000;
+    int iterations = argc > 1 ? atoi(argv[1]) : 5;
+    size_t chain_length = argc > 2 ? strtoull(argv[2], NULL, 10) : 1000000;
+    struct SynthGraph graph;
+    struct Order legacy = {0};
+    struct Order worklist = {0};
+    double legacy_time = 0;
+    double worklist_time = 0;
+
+    if (!SynthGenerate(&graph, num_compounds, 12, 0x9E3779B97F4A7C15ull)) {
+        fprintf(stderr, "Unable to generate %zu compounds\n", num_compounds);
+        return 1;
+    }
+
+    legacy.items = malloc(graph.count * sizeof(struct RTTI *));
+    worklist.items = malloc(graph.count * sizeof(struct RTTI *));
+
+    printf("Traversing %zu types (%zu roots, %zu attrs), %d iterations\n", graph.count, graph.num_roots, graph.num_attrs, iterations);
+
+    for (int i = 0; i < iterations; i++) {
+        struct TypeSet registered;
+        struct Traversal traversal;
+
+        legacy.count = 0;
+        TypeSetInit(&registered, graph.count);
+        double start = BenchNow();
+        for (size_t j = 0; j < graph.num_roots; j++)
+            LegacyScanType(graph.roots[j], &registered, &legacy);
+        legacy_time += BenchNow() - start;
+        TypeSetFree(&registered);
+
+        worklist.count = 0;
+        TraversalInit(&traversal, graph.count, Record, &worklist);
+        start = BenchNow();
+        for (size_t j = 0; j < graph.num_roots; j++)
+            TraversalAdd(&traversal, graph.roots[j]);
+        worklist_time += BenchNow() - start;
+        TraversalFree(&traversal);
+    }
+
+    if (legacy.count != graph.count || worklist.count != legacy.count
+        || memcmp(legacy.items, worklist.items, legacy.count * sizeof(struct RTTI *)) != 0) {
+        fprintf(stderr, "Visit order differs (%zu recursive, %zu worklist, %zu generated)\n", legacy.count, worklist.count, graph.count);
+        free(legacy.items);
+        free(worklist.items);
+        SynthFree(&graph);
+        return 1;
+    }
+
+    legacy_time /= iterations;
+    worklist_time /= iterations;
+    printf("recursive: %8.2f ms (%6.1f ns/type)\n", legacy_time * 1e3, legacy_time * 1e9 / (double) graph.count);
+    printf("worklist:  %8.2f ms (%6.1f ns/type), x%.2f\n", worklist_time * 1e3, worklist_time * 1e9 / (double) graph.count, legacy_time / worklist_time);
+
+    free(legacy.items);
+    free(worklist.items);
+
+    // Only the worklist survives this, the recursive walk would need one frame per level
+    struct RTTI *chain = SynthChain(&graph, chain_length);
+    if (chain_length && chain != NULL) {
+        struct Traversal traversal;
+        struct Order order = {malloc((chain_length + 1) * sizeof(struct RTTI *)), 0};
+
+        TraversalInit(&traversal, chain_length + 1, Record, &order);
+        double start = BenchNow();
+        TraversalAdd(&traversal, chain);
+        double time = BenchNow() - start;
+        TraversalFree(&traversal);
+
+        printf("chain:     %8.2f ms for %zu nested containers (%zu visited)\n", time * 1e3, chain_length, order.count);
+        free(order.items);
+    }
+
+    SynthFree(&graph);
+    return 0;
+}
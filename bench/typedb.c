@@ -0,0 +1,431 @@
+#include "bench.h"
+#include "synth.h"
+#include "traverse.h"
+#include "sort.h"
+#include "export.h"
+#include "typedb.h"
+#include "arena.h"
+#include "typehash.h"
+#include "layout.h"
+#include "plan.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BENCH_TYPEDB_PATH "decima_bench.typedb.bin"
+#define BENCH_MAX_REPORTED 10
+
+/// Just enough of a JSON reader for hfw_types.json. Strings are unescaped in place in the document,
+/// numbers point at their text in it.
+struct JsonNode {
+    char kind; ///< One of "{[snbz": object, array, string, number, bool, null
+    const char *text;
+    const char *key; ///< Name of the member, objects only
+    struct JsonNode *items;
+    size_t count;
+};
+
+static void SkipSpace(char **cursor) {
+    while (**cursor == ' ' || **cursor == '\t' || **cursor == '\n' || **cursor == '\r')
+        (*cursor)++;
+}
+
+static void PutUtf8(char **out, unsigned code) {
+    if (code < 0x80) {
+        *(*out)++ = (char) code;
+    } else if (code < 0x800) {
+        *(*out)++ = (char) (0xC0 | code >> 6);
+        *(*out)++ = (char) (0x80 | (code & 0x3F));
+    } else {
+        *(*out)++ = (char) (0xE0 | code >> 12);
+        *(*out)++ = (char) (0x80 | (code >> 6 & 0x3F));
+        *(*out)++ = (char) (0x80 | (code & 0x3F));
+    }
+}
+
+static char *ParseString(char **cursor) {
+    char *start = ++*cursor;
+    char *out = start;
+
+    while (**cursor != '"') {
+        char c = *(*cursor)++;
+
+        if (c == '\0')
+            return NULL;
+        if (c != '\\') {
+            *out++ = c;
+            continue;
+        }
+
+        switch (c = *(*cursor)++) {
+            case 'b': *out++ = '\b'; break;
+            case 'f': *out++ = '\f'; break;
+            case 'n': *out++ = '\n'; break;
+            case 'r': *out++ = '\r'; break;
+            case 't': *out++ = '\t'; break;
+            case 'u': {
+                char digits[5] = {0};
+                memcpy(digits, *cursor, 4);
+                *cursor += 4;
+                PutUtf8(&out, (unsigned) strtoul(digits, NULL, 16));
+                break;
+            }
+            case '\0': return NULL;
+            default: *out++ = c; break;
+        }
+    }
+
+    (*cursor)++;
+    *out = '\0';
+    return start;
+}
+
+static void FreeNode(struct JsonNode *node) {
+    for (size_t i = 0; i < node->count; i++)
+        FreeNode(&node->items[i]);
+    free(node->items);
+    node->items = NULL;
+    node->count = 0;
+}
+
+static _Bool ParseValue(char **cursor, struct JsonNode *node);
+
+static _Bool ParseItems(char **cursor, struct JsonNode *node, char close) {
+    size_t capacity = 0;
+
+    (*cursor)++;
+    SkipSpace(cursor);
+
+    if (**cursor == close) {
+        (*cursor)++;
+        return 1;
+    }
+
+    for (;;) {
+        const char *key = NULL;
+
+        if (close == '}') {
+            if (**cursor != '"' || (key = ParseString(cursor)) == NULL)
+                return 0;
+            SkipSpace(cursor);
+            if (*(*cursor)++ != ':')
+                return 0;
+            SkipSpace(cursor);
+        }
+
+        if (node->count == capacity) {
+            struct JsonNode *items = realloc(node->items, (capacity = capacity ? capacity * 2 : 8) * sizeof(*items));
+            if (items == NULL)
+                return 0;
+            node->items = items;
+        }
+
+        struct JsonNode *item = &node->items[node->count++];
+        memset(item, 0, sizeof(*item));
+        item->key = key;
+
+        if (!ParseValue(cursor, item))
+            return 0;
+
+        SkipSpace(cursor);
+        if (**cursor == close) {
+            (*cursor)++;
+            return 1;
+        }
+        if (*(*cursor)++ != ',')
+            return 0;
+        SkipSpace(cursor);
+    }
+}
+
+static _Bool ParseValue(char **cursor, struct JsonNode *node) {
+    node->text = *cursor;
+
+    switch (**cursor) {
+        case '{':
+            node->kind = '{';
+            return ParseItems(cursor, node, '}');
+        case '[':
+            node->kind = '[';
+            return ParseItems(cursor, node, ']');
+        case '"':
+            node->kind = 's';
+            return (node->text = ParseString(cursor)) != NULL;
+        case 't':
+        case 'f':
+            node->kind = 'b';
+            *cursor += **cursor == 't' ? 4 : 5;
+            return 1;
+        case 'n':
+            node->kind = 'z';
+            *cursor += 4;
+            return 1;
+        default:
+            node->kind = 'n';
+            while (**cursor == '-' || **cursor == '+' || **cursor == '.' || **cursor == 'e' || **cursor == 'E'
+                   || (**cursor >= '0' && **cursor <= '9'))
+                (*cursor)++;
+            return *cursor != node->text;
+    }
+}
+
+static const struct JsonNode *Member(const struct JsonNode *node, const char *key) {
+    for (size_t i = 0; node != NULL && node->kind == '{' && i < node->count; i++) {
+        if (strcmp(node->items[i].key, key) == 0)
+            return &node->items[i];
+    }
+
+    return NULL;
+}
+
+static size_t Length(const struct JsonNode *node) {
+    return node != NULL && node->kind == '[' ? node->count : 0;
+}
+
+/// A missing member matches only TYPEDB_NONE.
+static _Bool SameString(const struct TypeDb *db, const struct JsonNode *node, uint32_t offset) {
+    if (node == NULL || node->kind != 's')
+        return node == NULL && offset == TYPEDB_NONE;
+
+    const char *string = TypeDbString(db, offset);
+    return string != NULL && strcmp(string, node->text) == 0;
+}
+
+static _Bool SameSigned(const struct JsonNode *node, int64_t value) {
+    return node != NULL && node->kind == 'n' && strtoll(node->text, NULL, 10) == value;
+}
+
+static _Bool SameUnsigned(const struct JsonNode *node, uint64_t value) {
+    return node != NULL && node->kind == 'n' && strtoull(node->text, NULL, 10) == value;
+}
+
+static _Bool SameAttr(const struct TypeDb *db, const struct JsonNode *node, const struct TypeDbAttr *attr) {
+    const struct JsonNode *category = Member(node, "category");
+
+    if (category != NULL)
+        return attr->type == TYPEDB_NONE && SameString(db, category, attr->name);
+
+    const struct JsonNode *property = Member(node, "property");
+
+    return attr->type != TYPEDB_NONE
+           && SameString(db, Member(node, "mTypeName"), attr->name)
+           && SameString(db, Member(node, "mType"), attr->type)
+           && SameUnsigned(Member(node, "mOffset"), attr->offset)
+           && SameUnsigned(Member(node, "mFlags"), attr->flags)
+           && SameString(db, Member(node, "min"), attr->min)
+           && SameString(db, Member(node, "max"), attr->max)
+           && (property != NULL && property->text[0] == 't') == ((attr->attributes & TYPEDB_ATTR_PROPERTY) != 0);
+}
+
+static _Bool SameValue(const struct TypeDb *db, const struct JsonNode *node, const struct TypeDbType *type,
+                       const struct TypeDbValue *value) {
+    const struct JsonNode *aliases = Member(node, "alias");
+    const struct JsonNode *number = Member(node, "mValue");
+    size_t num_aliases = Length(aliases);
+    _Bool same = type->attributes & TYPEDB_TYPE_SIGNED ? SameSigned(number, (int64_t) value->value)
+                                                       : SameUnsigned(number, value->value) && number->text[0] != '-';
+
+    if (num_aliases > 4 || !same || !SameString(db, Member(node, "mTypeName"), value->name))
+        return 0;
+
+    // The export stops at the first missing alias
+    for (size_t i = 0; i < 4; i++) {
+        if (!SameString(db, i < num_aliases ? &aliases->items[i] : NULL, value->aliases[i]))
+            return 0;
+    }
+
+    return 1;
+}
+
+/// Compares everything the export writes about the type except "hash", which is TypeHash rather than the
+/// hash of the record. Only enums carry their size in the export.
+static _Bool SameType(const struct TypeDb *db, const struct JsonNode *node, const struct TypeDbType *type) {
+    const struct JsonNode *messages = Member(node, "messages");
+    const struct JsonNode *bases = Member(node, "mBases");
+    const struct JsonNode *attrs = Member(node, "mAttrs");
+    const struct JsonNode *values = Member(node, "values");
+    const struct JsonNode *kind = Member(node, "kind");
+
+    const char *name = TypeDbString(db, type->name);
+
+    if (name == NULL || strcmp(node->key, name) != 0)
+        return 0;
+    if (kind == NULL || kind->kind != 's' || strcmp(kind->text, RTTIKind_Name(type->kind)) != 0)
+        return 0;
+
+    switch (type->kind) {
+        case RTTIKind_Compound:
+            if (!SameSigned(Member(node, "mVersion"), (int32_t) type->version)
+                || !SameUnsigned(Member(node, "mFlags"), type->flags)
+                || Length(messages) != type->num_messages || Length(bases) != type->num_bases
+                || Length(attrs) != type->num_attrs)
+                return 0;
+
+            for (uint32_t i = 0; i < type->num_messages; i++) {
+                if (!SameString(db, &messages->items[i], db->messages[type->first_message + i]))
+                    return 0;
+            }
+
+            for (uint32_t i = 0; i < type->num_bases; i++) {
+                const struct TypeDbBase *base = &db->bases[type->first_base + i];
+                if (!SameString(db, Member(&bases->items[i], "mTypeName"), base->type)
+                    || !SameUnsigned(Member(&bases->items[i], "mOffset"), base->offset))
+                    return 0;
+            }
+
+            for (uint32_t i = 0; i < type->num_attrs; i++) {
+                if (!SameAttr(db, &attrs->items[i], &db->attrs[type->first_attr + i]))
+                    return 0;
+            }
+
+            return 1;
+        case RTTIKind_Enum:
+        case RTTIKind_EnumFlags:
+            if (!SameUnsigned(Member(node, "mSize"), type->size) || Length(values) != type->num_values)
+                return 0;
+
+            for (uint32_t i = 0; i < type->num_values; i++) {
+                if (!SameValue(db, &values->items[i], type, &db->values[type->first_value + i]))
+                    return 0;
+            }
+
+            return 1;
+        case RTTIKind_Atom:
+            return SameString(db, Member(node, "mBaseType"), type->base_type);
+        default:
+            return 1;
+    }
+}
+
+/// Reads back everything ExportTypes wrote, NULL when the file cannot be read.
+static char *ReadAll(FILE *file) {
+    long size = ftell(file);
+    char *text = size > 0 ? malloc((size_t) size + 1) : NULL;
+
+    if (text == NULL)
+        return NULL;
+
+    rewind(file);
+    text[fread(text, 1, (size_t) size, file)] = '\0';
+    return text;
+}
+
+/// Goes through hfw_types.json one type at a time next to the records of the type database written from the
+/// same types. Records and types are in the same order, and every type must also be found by its name.
+static size_t CompareRecords(const struct TypeDb *db, char *document, size_t *num_types) {
+    char *cursor = document;
+    size_t mismatches = 0;
+
+    *num_types = 0;
+    SkipSpace(&cursor);
+    if (*cursor++ != '{')
+        return 1;
+
+    for (SkipSpace(&cursor); *cursor == '"';) {
+        struct JsonNode node = {0};
+        _Bool parsed;
+
+        node.key = ParseString(&cursor);
+        SkipSpace(&cursor);
+        parsed = node.key != NULL && *cursor++ == ':';
+        SkipSpace(&cursor);
+        parsed = parsed && ParseValue(&cursor, &node);
+
+        if (!parsed) {
+            fprintf(stderr, "Unable to parse the export after %zu types\n", *num_types);
+            FreeNode(&node);
+            return mismatches + 1;
+        }
+
+        if (node.key[0] != '$') {
+            size_t index = (*num_types)++;
+            const struct TypeDbType *found = TypeDbFind(db, node.key);
+            _Bool same = index < db->header->num_types && SameType(db, &node, &db->types[index])
+                         && found != NULL && strcmp(TypeDbString(db, found->name), node.key) == 0;
+
+            if (!same && mismatches++ < BENCH_MAX_REPORTED)
+                fprintf(stderr, "Type %zu '%s' differs from its record\n", index, node.key);
+        }
+
+        FreeNode(&node);
+        SkipSpace(&cursor);
+        if (*cursor == ',')
+            cursor++;
+        SkipSpace(&cursor);
+    }
+
+    if (*num_types != db->header->num_types) {
+        fprintf(stderr, "%zu types exported, %u records\n", *num_types, db->header->num_types);
+        mismatches++;
+    }
+
+    return mismatches;
+}
+
+/// Writes the type database of a synthetic graph, maps it again and checks every record against hfw_types.json
+/// of the same types: kind, version, flags, size, name, messages, bases, attrs, enum values and their aliases.
+int BenchTypeDb(int argc, char **argv) {
+    size_t num_compounds = argc > 0 ? strtoull(argv[0], NULL, 10) : 20000;
+    struct SynthGraph graph;
+    struct Traversal traversal;
+    struct TypeDb db;
+    size_t num_types = 0;
+    size_t mismatches;
+
+    if (num_compounds == 0 || !SynthGenerate(&graph, num_compounds, 12, 0x9E3779B97F4A7C15ull)) {
+        fprintf(stderr, "Unable to generate %zu compounds\n", num_compounds);
+        return 1;
+    }
+
+    TraversalInit(&traversal, 1 << 16, NULL, NULL);
+    for (size_t i = 0; i < graph.num_roots; i++)
+        TraversalAdd(&traversal, graph.roots[i]);
+
+    size_t count = traversal.visited.count;
+    struct RTTI **sorted = malloc(count * sizeof(struct RTTI *));
+    memcpy(sorted, traversal.visited.items, count * sizeof(struct RTTI *));
+    SortTypes(sorted, count);
+
+    FILE *file = fopen(BENCH_TYPEDB_PATH, "wb");
+    double start = BenchNow();
+    _Bool written = file != NULL && TypeDbWrite(file, sorted, count);
+    double write = BenchNow() - start;
+    if (file != NULL)
+        fclose(file);
+
+    FILE *json = tmpfile();
+    char *document = NULL;
+    if (json != NULL) {
+        ExportTypes(json, sorted, count, 1);
+        document = ReadAll(json);
+        fclose(json);
+    }
+
+    start = BenchNow();
+    _Bool opened = written && TypeDbOpen(BENCH_TYPEDB_PATH, &db);
+    double open = BenchNow() - start;
+
+    if (!opened || document == NULL) {
+        fprintf(stderr, "Unable to write the type database and the export\n");
+        mismatches = 1;
+    } else {
+        printf("Wrote %u records in %.2f ms, mapped in %.3f ms\n", db.header->num_types, write * 1e3, open * 1e3);
+        mismatches = CompareRecords(&db, document, &num_types);
+        printf("%zu exported types compared, %zu mismatches\n", num_types, mismatches);
+        TypeDbClose(&db);
+    }
+
+    free(document);
+    free(sorted);
+    TraversalFree(&traversal);
+    remove(BENCH_TYPEDB_PATH);
+    RTTI_ResetDisplayNames();
+    RTTI_ResetEnumTables();
+    TypeHashReset();
+    LayoutReset();
+    PlanReset();
+    SessionReset();
+    SynthFree(&graph);
+    return mismatches ? 1 : 0;
+}
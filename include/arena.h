@@ -0,0 +1,53 @@
+#ifndef DECIMA_NATIVE_ARENA_H
+#define DECIMA_NATIVE_ARENA_H
+
+#include <stddef.h>
+
+#define ARENA_BLOCK_SIZE (64 * 1024)
+
+struct ArenaBlock {
+    struct ArenaBlock *next;
+    size_t size;
+    size_t used;
+};
+
+struct ArenaStats {
+    size_t used; ///< Bytes handed out since the last reset
+    size_t reserved; ///< Bytes held in blocks right now
+    size_t peak; ///< Highest `reserved` ever reached
+    size_t total; ///< Bytes handed out over the lifetime of the arena
+    size_t num_blocks; ///< Blocks held right now
+};
+
+/// Bump allocator, everything allocated from it lives until `ArenaReset`.
+/// Allocations never move, so pointers into it stay valid. A zeroed arena is ready to use.
+struct Arena {
+    struct ArenaBlock *head;
+    size_t block_size; ///< 0 for ARENA_BLOCK_SIZE
+    struct ArenaStats stats;
+};
+
+void *ArenaAlloc(struct Arena *arena, size_t size, size_t alignment);
+
+char *ArenaCopyString(struct Arena *arena, const char *string, size_t length);
+
+/// Releases every block at once. Peak and total statistics are kept.
+void ArenaReset(struct Arena *arena);
+
+/// The dump session: one arena shared by everything allocated for a dump, released by a single `SessionReset`.
+/// All session functions are thread-safe.
+void *SessionAlloc(size_t size, size_t alignment);
+
+/// malloc/realloc/free lookalikes over the session, for hashmap_new_with_allocator.
+/// Freeing does nothing, the memory is reclaimed by `SessionReset`.
+void *SessionMalloc(size_t size);
+
+void *SessionRealloc(void *memory, size_t size);
+
+void SessionFree(void *memory);
+
+struct ArenaStats SessionStats(void);
+
+void SessionReset(void);
+
+#endif //DECIMA_NATIVE_ARENA_H
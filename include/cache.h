@@ -0,0 +1,21 @@
+#ifndef DECIMA_NATIVE_CACHE_H
+#define DECIMA_NATIVE_CACHE_H
+
+#include "pe.h"
+#include "scan.h"
+
+#include <stdint.h>
+
+/// Identity of an executable as far as the signature cache is concerned.
+struct SignatureCacheKey {
+    uint32_t time_date_stamp;
+    uint32_t size_of_image;
+    uint64_t section_hash; ///< FNV-1a of the scanned section's header
+};
+
+_Bool SignatureCacheKeyOf(const struct PeImage *image, const char *section, struct SignatureCacheKey *key);
+
+_Bool ResolveSignatures(const char *path, const struct PeImage *image, const char *section,
+                        struct Signature *signatures, size_t count, _Bool *cached);
+
+#endif //DECIMA_NATIVE_CACHE_H
@@ -0,0 +1,21 @@
+#ifndef DECIMA_NATIVE_DIFF_H
+#define DECIMA_NATIVE_DIFF_H
+
+#include "typedb.h"
+
+#include <stdio.h>
+#include <stddef.h>
+
+struct DiffSummary {
+    size_t added;
+    size_t removed;
+    size_t changed;
+    size_t unchanged;
+};
+
+/// Writes the types added, removed and changed between two dumps as JSON, with attr, base, value
+/// and message level changes for the changed ones. Types are matched by name, a type whose version
+/// and content hash are both unchanged is skipped without comparing its contents.
+_Bool DiffTypes(FILE *file, const struct TypeDb *previous, const struct TypeDb *current, struct DiffSummary *summary);
+
+#endif //DECIMA_NATIVE_DIFF_H
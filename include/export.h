@@ -0,0 +1,29 @@
+#ifndef DECIMA_NATIVE_EXPORT_H
+#define DECIMA_NATIVE_EXPORT_H
+
+#include "json.h"
+#include "rtti.h"
+
+#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/// Writes hfw_types.json, `types` are expected in `SortTypes` order. The types are written in chunks on
+/// `threads` threads, all of them for 0, and the output is the same whatever the number of threads.
+void ExportTypes(FILE *file, struct RTTI **types, size_t count, unsigned threads);
+
+/// Writes the flattened layout of every compound (see layout.h), keyed by name like in `ExportTypes`.
+void ExportLayouts(FILE *file, struct RTTI **types, size_t count);
+
+/// Appends a self-contained single-line record for the type to the streamed NDJSON dump.
+void StreamType(struct JsonContext *ctx, struct RTTI *rtti);
+
+/// Writes an IDA script naming and typing the RTTI objects and their tables.
+void ExportIda(FILE *file, struct RTTI **types, size_t count);
+
+/// Same annotations as `ExportIda`, packed into fixed-width rows in strings that one loop in the script
+/// decodes and applies, with addresses relative to the image base, which the script gets from IDA. Container
+/// and pointer infos are annotated once. Annotations outside of [image_base, image_base + image_size) are left out.
+void ExportIdaCompact(FILE *file, struct RTTI **types, size_t count, uintptr_t image_base, size_t image_size);
+
+#endif //DECIMA_NATIVE_EXPORT_H
@@ -4,9 +4,15 @@
 #include <stdio.h>
 #include <stdint.h>
 
+#define JSON_MAX_DEPTH 32 ///< Open objects and arrays, the document included
+
 #define JsonValueStr(_Ctx, _Value) JsonValue(_Ctx, (struct JsonValue) {.type = JsonType_String, .string = (_Value)})
 #define JsonValueNum(_Ctx, _Value) JsonValue(_Ctx, (struct JsonValue) {.type = JsonType_Integer, .integer = (_Value)})
+#define JsonValueUnsigned(_Ctx, _Value) JsonValue(_Ctx, (struct JsonValue) {.type = JsonType_Unsigned, .unsigned_integer = (_Value)})
 #define JsonValueBool(_Ctx, _Value) JsonValue(_Ctx, (struct JsonValue) {.type = JsonType_Bool, .integer = (_Value)})
+#define JsonValueFloat(_Ctx, _Value) JsonValue(_Ctx, (struct JsonValue) {.type = JsonType_Float, .floating = (_Value)})
+#define JsonValueDouble(_Ctx, _Value) JsonValue(_Ctx, (struct JsonValue) {.type = JsonType_Double, .floating = (_Value)})
+#define JsonValueNull(_Ctx) JsonValue(_Ctx, (struct JsonValue) {.type = JsonType_Null})
 
 #define JsonBeginCompactObject(_Ctx) do { JsonBeginObject(_Ctx); JsonCompact(_Ctx, 1); } while (0)
 #define JsonEndCompactObject(_Ctx) do { JsonEndObject(_Ctx); JsonCompact(_Ctx, 0); } while (0)
@@ -25,6 +31,12 @@
         JsonValueNum(_Ctx, _Value);           \
     } while (0)
 
+#define JsonNameValueUnsigned(_Ctx, _Name, _Value) \
+    do {                                           \
+        JsonName(_Ctx, _Name);                     \
+        JsonValueUnsigned(_Ctx, _Value);           \
+    } while (0)
+
 #define JsonNameValueBool(_Ctx, _Name, _Value) \
     do {                                       \
         JsonName(_Ctx, _Name);                 \
@@ -55,30 +67,56 @@
         JsonBeginCompactArray(_Ctx);      \
     } while (0)
 
+/// Output is accumulated in `buffer` and written to `stream` in large blocks.
+/// Without a stream the whole document stays in memory until `JsonFinish`.
 struct JsonContext {
     FILE *stream;
+    char *buffer;
+    size_t length;
+    size_t capacity;
     int compact;
+    int single_line; ///< Never break lines, regardless of `compact`
     const char *name;
     size_t index;
-    int scopes[32];
+    int scopes[JSON_MAX_DEPTH];
 };
 
 enum JsonType {
     JsonType_String,
     JsonType_Integer,
-    JsonType_Bool
+    JsonType_Unsigned,
+    JsonType_Bool,
+    JsonType_Float, ///< Written with the precision of a float, non-finite values as null
+    JsonType_Double,
+    JsonType_Null
 };
 
 struct JsonValue {
     enum JsonType type;
     union {
         const char *string;
-        int integer;
+        int64_t integer;
+        uint64_t unsigned_integer;
+        double floating;
     };
 };
 
 void JsonInit(struct JsonContext *ctx, FILE *);
 
+void JsonFinish(struct JsonContext *ctx);
+
+/// Starts an in-memory context that continues the document of `parent` at its current scope, for writing
+/// part of it on another thread. The scope must already hold a value, so that any number of nested contexts
+/// started from the same state can be appended one after the other.
+void JsonInitNested(struct JsonContext *ctx, const struct JsonContext *parent);
+
+/// Writes out what was written to `nested`, which must be back at the scope it started at, and finishes it.
+void JsonAppend(struct JsonContext *ctx, struct JsonContext *nested);
+
+void JsonFlush(struct JsonContext *ctx);
+
+void JsonNextRecord(struct JsonContext *ctx);
+
 void JsonBeginObject(struct JsonContext *ctx);
 
 void JsonEndObject(struct JsonContext *ctx);
@@ -93,4 +131,6 @@ void JsonValue(struct JsonContext *ctx, struct JsonValue value);
 
 void JsonCompact(struct JsonContext *ctx, int compact);
 
+void JsonSingleLine(struct JsonContext *ctx, int single_line);
+
 #endif //DECIMA_NATIVE_JSON_H
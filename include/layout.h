@@ -0,0 +1,31 @@
+#ifndef DECIMA_NATIVE_LAYOUT_H
+#define DECIMA_NATIVE_LAYOUT_H
+
+#include "rtti.h"
+
+#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
+
+struct LayoutField {
+    struct RTTIAttr *attr;
+    struct RTTICompound *owner; ///< The compound declaring the attr, the one the layout is of or one of its bases
+    uint32_t offset; ///< From the start of the compound the layout is of
+};
+
+/// Every attr of a compound including the inherited ones, at absolute offsets. Bases come first, in declaration
+/// order and each laid out the same way, then the attrs of the compound itself. Category markers are left out.
+struct Layout {
+    uint32_t num_fields;
+    struct LayoutField fields[];
+};
+
+/// Computed once per compound and kept in the dump session (see arena.h). The layout of a compound is built
+/// from the layouts of its bases, so a base shared by many compounds is only laid out once.
+/// Safe to call from several threads at once. NULL when out of memory.
+const struct Layout *LayoutOf(struct RTTICompound *compound);
+
+/// Forgets every cached layout, must be called before the session is reset.
+void LayoutReset(void);
+
+#endif //DECIMA_NATIVE_LAYOUT_H
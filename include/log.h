@@ -0,0 +1,57 @@
+#ifndef DECIMA_NATIVE_LOG_H
+#define DECIMA_NATIVE_LOG_H
+
+#include <stdio.h>
+#include <stdint.h>
+
+#define LOG_LEVEL_ERROR 0
+#define LOG_LEVEL_WARNING 1
+#define LOG_LEVEL_INFO 2
+#define LOG_LEVEL_DEBUG 3
+#define LOG_LEVEL_TRACE 4
+
+/// Messages above this level are compiled out, arguments included.
+#ifndef DECIMA_LOG_LEVEL
+#define DECIMA_LOG_LEVEL LOG_LEVEL_INFO
+#endif
+
+#define LOG_MAX_ARGS 8
+#define LOG_RING_SIZE 4096 ///< Records, must be a power of two
+
+/// Starts the thread that formats and writes records to `stream`. Until then, and after `LogStop`,
+/// messages are formatted and written synchronously by the caller.
+_Bool LogStart(FILE *stream);
+
+/// Waits until every record logged so far is written out.
+void LogFlush(void);
+
+void LogStop(void);
+
+/// Queues a message without formatting it. `format` is a printf format string that must outlive the logger,
+/// and so must the strings passed for its %s conversions, only the pointers are stored.
+/// Supports the d, i, u, x, X, o, c, s, p, f, e and g conversions with flags, width, precision and the
+/// hh, h, l, ll, z, j and t modifiers, up to LOG_MAX_ARGS of them.
+void LogWrite(int level, const char *format, ...);
+
+#define LogError(...) LogWrite(LOG_LEVEL_ERROR, __VA_ARGS__)
+#define LogWarning(...) LogWrite(LOG_LEVEL_WARNING, __VA_ARGS__)
+
+#if DECIMA_LOG_LEVEL >= LOG_LEVEL_INFO
+#define LogInfo(...) LogWrite(LOG_LEVEL_INFO, __VA_ARGS__)
+#else
+#define LogInfo(...) ((void) 0)
+#endif
+
+#if DECIMA_LOG_LEVEL >= LOG_LEVEL_DEBUG
+#define LogDebug(...) LogWrite(LOG_LEVEL_DEBUG, __VA_ARGS__)
+#else
+#define LogDebug(...) ((void) 0)
+#endif
+
+#if DECIMA_LOG_LEVEL >= LOG_LEVEL_TRACE
+#define LogTrace(...) LogWrite(LOG_LEVEL_TRACE, __VA_ARGS__)
+#else
+#define LogTrace(...) ((void) 0)
+#endif
+
+#endif //DECIMA_NATIVE_LOG_H
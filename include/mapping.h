@@ -0,0 +1,19 @@
+#ifndef DECIMA_NATIVE_MAPPING_H
+#define DECIMA_NATIVE_MAPPING_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/// A whole file mapped read-only into memory.
+struct FileMapping {
+    uint8_t *data;
+    size_t size;
+    void *file;
+    void *mapping;
+};
+
+_Bool MapFile(const char *path, struct FileMapping *mapping);
+
+void UnmapFile(struct FileMapping *mapping);
+
+#endif //DECIMA_NATIVE_MAPPING_H
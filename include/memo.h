@@ -0,0 +1,25 @@
+#ifndef DECIMA_NATIVE_MEMO_H
+#define DECIMA_NATIVE_MEMO_H
+
+#include "thread.h"
+
+#include <stddef.h>
+
+/// Open-addressing map from objects to word-sized values computed for them once per dump.
+/// Lookups take no lock, inserts are made while holding `lock`. Tables live in the dump session
+/// (see arena.h), the ones replaced by a bigger table stay there so that readers still holding them are safe.
+/// A zeroed memo is empty and ready to use.
+struct Memo {
+    struct SpinLock lock;
+    volatile size_t table;
+};
+
+_Bool MemoFind(struct Memo *memo, const void *key, size_t *value);
+
+/// The key must not be in the memo yet. Must be called with `lock` held.
+_Bool MemoInsert(struct Memo *memo, const void *key, size_t value);
+
+/// Forgets every value, must be called before the session is reset.
+void MemoReset(struct Memo *memo);
+
+#endif //DECIMA_NATIVE_MEMO_H
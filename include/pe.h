@@ -0,0 +1,60 @@
+#ifndef DECIMA_NATIVE_PE_H
+#define DECIMA_NATIVE_PE_H
+
+#include "mapping.h"
+#include "scan.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define PE_SECTION_NAME_LENGTH 8
+
+#pragma pack(push, 1)
+/// On-disk layout of a section header, matches IMAGE_SECTION_HEADER.
+struct PeSectionHeader {
+    char mName[PE_SECTION_NAME_LENGTH];
+    uint32_t mVirtualSize;
+    uint32_t mVirtualAddress;
+    uint32_t mSizeOfRawData;
+    uint32_t mPointerToRawData;
+    uint32_t mPointerToRelocations;
+    uint32_t mPointerToLinenumbers;
+    uint16_t mNumberOfRelocations;
+    uint16_t mNumberOfLinenumbers;
+    uint32_t mCharacteristics;
+};
+#pragma pack(pop)
+
+/// A PE image, either an executable mapped from disk by `PeOpen` (raw file layout)
+/// or a module already loaded by the OS and attached with `PeAttach` (virtual layout).
+struct PeImage {
+    uint8_t *data;
+    size_t size;
+    _Bool loaded; ///< Sections live at their virtual addresses rather than at their raw offsets
+    uint64_t image_base;
+    uint32_t size_of_image;
+    uint32_t time_date_stamp;
+    uint16_t num_sections;
+    const struct PeSectionHeader *sections;
+    struct FileMapping mapping; ///< Only set for images opened from disk
+};
+
+_Bool PeOpen(const char *path, struct PeImage *image);
+
+_Bool PeAttach(void *module, struct PeImage *image);
+
+void PeClose(struct PeImage *image);
+
+const struct PeSectionHeader *PeFindSectionHeader(const struct PeImage *image, const char *name);
+
+_Bool PeFindSection(const struct PeImage *image, const char *name, struct Section *section);
+
+_Bool PeOffsetToRva(const struct PeImage *image, uint32_t offset, uint32_t *rva);
+
+_Bool PeRvaToOffset(const struct PeImage *image, uint32_t rva, uint32_t *offset);
+
+_Bool PeAddressOf(const struct PeImage *image, const void *position, uint64_t *address);
+
+_Bool PeRvaToPointer(const struct PeImage *image, uint32_t rva, void **position);
+
+#endif //DECIMA_NATIVE_PE_H
@@ -0,0 +1,32 @@
+#ifndef DECIMA_NATIVE_PERFECTHASH_H
+#define DECIMA_NATIVE_PERFECTHASH_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define PERFECT_HASH_NONE 0xFFFFFFFF
+#define PERFECT_HASH_DIRECT 0x80000000 ///< Set on the displacement of a bucket holding one key, the rest is its slot
+
+/// Minimal perfect hash over a fixed set of strings, built with hash-and-displace (CHD).
+/// Keys are spread over buckets of about four, every bucket stores the displacement that sends all of
+/// its keys to free slots. There are exactly as many slots as distinct keys, each holding the index of its key.
+///
+/// A lookup is one string hash and two array reads, and yields the only key the string could be.
+/// Strings outside of the set yield some key as well, so the caller compares the names.
+struct PerfectHash {
+    uint64_t seed;
+    uint32_t num_buckets;
+    uint32_t num_slots;
+    const uint32_t *buckets; ///< Displacement of every bucket
+    const uint32_t *slots; ///< Index of the key in every slot
+};
+
+/// Repeated keys get a slot once, for their first occurrence. Owns the tables until `PerfectHashFree`.
+_Bool PerfectHashBuild(struct PerfectHash *hash, const char *const *keys, uint32_t count);
+
+void PerfectHashFree(struct PerfectHash *hash);
+
+/// Index of the only key that may be equal to `key`, PERFECT_HASH_NONE for an empty set.
+uint32_t PerfectHashLookup(const struct PerfectHash *hash, const char *key);
+
+#endif //DECIMA_NATIVE_PERFECTHASH_H
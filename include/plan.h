@@ -0,0 +1,78 @@
+#ifndef DECIMA_NATIVE_PLAN_H
+#define DECIMA_NATIVE_PLAN_H
+
+#include "json.h"
+#include "rtti.h"
+
+#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define PLAN_MAX_DEPTH 24 ///< Pointers followed from the object being written
+
+enum PlanOp {
+    PlanOp_Bool,
+    PlanOp_Int,
+    PlanOp_Uint,
+    PlanOp_Float,
+    PlanOp_Double,
+    PlanOp_Half,
+    PlanOp_String, ///< Pointer to the characters, NULL for an empty string
+    PlanOp_Bytes, ///< Simple atoms without a known representation, copied as they are
+    PlanOp_Enum,
+    PlanOp_Flags,
+    PlanOp_Compound, ///< Nested compound, runs `plan` at the offset
+    PlanOp_Pointer, ///< Runs `plan` on the object pointed to when `follow` is set, writes the address otherwise
+    PlanOp_Array, ///< uint32_t count, uint32_t capacity, items; runs `plan` on every item
+    PlanOp_Skip, ///< Values without a known representation
+};
+
+struct PlanStep {
+    uint8_t op; ///< enum PlanOp
+    uint8_t follow;
+    uint16_t size; ///< Of the value at `offset`
+    uint32_t offset;
+    const char *name; ///< Of the attr, NULL for the only step of a plan that is not of a compound
+    union {
+        struct RTTIEnum *enumeration;
+        const struct Plan *plan;
+    };
+};
+
+/// Lowered form of a type for serializing instances of it: one step per value, compounds laid out
+/// with their bases at absolute offsets (see layout.h). Plans of other types have a single unnamed step.
+struct Plan {
+    struct RTTI *type;
+    uint32_t size; ///< Distance between items of an array
+    uint32_t num_steps;
+    struct PlanStep steps[];
+};
+
+/// Controls which pointers are followed, objects deeper than PLAN_MAX_DEPTH pointers are written as addresses.
+/// A zeroed writer follows Ref and cptr with the static type of their item.
+struct PlanWriter {
+    /// Type of the object pointed to, for pointers to objects of a derived type. NULL keeps the static type.
+    struct RTTI *(*resolve)(const void *object, struct RTTI *type, void *context);
+    void *context;
+    _Bool no_follow; ///< Write the address of every pointer instead
+};
+
+/// Compiled once per type along with every type reachable from it, kept in the dump session (see arena.h).
+/// Safe to call from several threads at once. NULL when out of memory.
+const struct Plan *PlanOf(struct RTTI *type);
+
+/// Forgets every compiled plan, must be called before the session is reset.
+void PlanReset(void);
+
+/// Writes the object as a JSON value. Compounds become objects keyed by attr name, enums their value name,
+/// flags an array of value names, pointers that are not followed their address. A followed compound is written
+/// once with an "$id" and its "$type", later pointers to it become {"$ref": id}.
+void PlanWriteJson(struct JsonContext *ctx, const struct Plan *plan, const void *object, const struct PlanWriter *writer);
+
+/// Writes the object as little-endian values in step order: atoms and enums as they are in memory,
+/// strings and arrays as a uint32_t count and their contents, pointers as a tag byte that is 0 for NULL,
+/// 1 before the name of the type (as a string) and the followed object, 2 before the uint32_t id of an object
+/// written earlier and 3 before a uint64_t address. Compounds are numbered in the order they are written.
+_Bool PlanWriteBinary(FILE *file, const struct Plan *plan, const void *object, const struct PlanWriter *writer);
+
+#endif //DECIMA_NATIVE_PLAN_H
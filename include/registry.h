@@ -0,0 +1,19 @@
+#ifndef DECIMA_NATIVE_REGISTRY_H
+#define DECIMA_NATIVE_REGISTRY_H
+
+#include "rtti.h"
+
+#include <stddef.h>
+
+/// Frozen name lookup over the types captured by a dump, for tools running inside the game.
+/// Names are display names, as in the dumps. Built once with a minimal perfect hash (see perfecthash.h),
+/// so a lookup is one hash and one string comparison.
+_Bool RegistryBuild(struct RTTI **types, size_t count);
+
+/// Forgets the registry, must be called before the session is reset and when no lookups are in flight.
+void RegistryReset(void);
+
+/// NULL when the name is unknown or no registry has been built. Safe to call from several threads at once.
+struct RTTI *RTTI_FindByName(const char *name);
+
+#endif //DECIMA_NATIVE_REGISTRY_H
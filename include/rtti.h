@@ -3,6 +3,7 @@
 
 #ifdef RTTI_STANDALONE
 
+#include <stddef.h>
 #include <stdint.h>
 #include <stdbool.h>
 #include <assert.h>
@@ -204,8 +205,39 @@ const char *RTTIKind_Name(enum RTTIKind);
 
 const char *RTTI_Name(struct RTTI *);
 
+/// Names containers and pointers after their item type, e.g. `Array<Ref<Entity>>`.
+/// The result is computed once per object and lives in the dump session (see arena.h).
+/// Safe to call from several threads at once.
 const char *RTTI_DisplayName(struct RTTI *);
 
+/// Forgets every cached display name, must be called before the session is reset.
+void RTTI_ResetDisplayNames(void);
+
+/// Name of the first value equal to `value`, NULL when there is none.
+///
+/// Enum lookups go through tables built once per enum and kept in the dump session (see arena.h):
+/// values indexed directly when they are nearly contiguous or sorted for a binary search otherwise,
+/// the value of every bit for flags and a hash index of names and aliases. Safe to call from several threads at once.
+const char *RTTI_EnumName(struct RTTIEnum *, uint64_t value);
+
+/// Splits flags into the values they are made of, taking every value whose bits are all set and not taken yet
+/// in declaration order. Stores at most 64 names and returns their number, `rest` receives the bits no value has.
+size_t RTTI_EnumFlags(struct RTTIEnum *, uint64_t value, const char **names, uint64_t *rest);
+
+/// Value of the first value named or aliased `name`.
+_Bool RTTI_EnumValue(struct RTTIEnum *, const char *name, uint64_t *value);
+
+/// Whether the values of the enum are signed, going by the name of its representation type.
+/// Without one, plain enums are taken as signed and flags as unsigned.
+_Bool RTTI_EnumSigned(struct RTTIEnum *);
+
+/// The value cut to the `size` bytes of the enum and sign-extended when the enum is signed,
+/// so that -1 reads the same however wide it was stored.
+uint64_t RTTI_EnumNormalize(struct RTTIEnum *, uint64_t value);
+
+/// Forgets every enum table, must be called before the session is reset.
+void RTTI_ResetEnumTables(void);
+
 _Bool RTTI_AsCompound(struct RTTI *, struct RTTICompound **);
 
 _Bool RTTI_AsContainer(struct RTTI *, struct RTTIContainer **);
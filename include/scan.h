@@ -1,13 +1,52 @@
 #ifndef DECIMA_NATIVE_SCAN_H
 #define DECIMA_NATIVE_SCAN_H
 
+#include <stddef.h>
+#include <stdint.h>
+
+#define PATTERN_MAX_LENGTH 128
+#define SIGNATURE_MAX_MATCHES 8
+
 struct Section {
     void *start;
     void *end;
 };
 
-_Bool FindSection(void* module, const char *name, struct Section *section);
+/// A signature compiled from its textual form (e.g. "48 8B ? ? 0F") into a byte array and a mask.
+/// Wildcard positions have a zero mask and a zero byte, so a match is `(data[i] & mask[i]) == bytes[i]`.
+struct Pattern {
+    uint8_t bytes[PATTERN_MAX_LENGTH];
+    uint8_t mask[PATTERN_MAX_LENGTH];
+    size_t length;
+    size_t anchor; ///< Offset of the rarest non-wildcard byte, searched for first
+    size_t second; ///< Offset of the second rarest non-wildcard byte, used to filter anchor hits
+    size_t shift[256]; ///< Horspool skip table used when SIMD is unavailable
+};
+
+/// A named signature resolved by `FindPatterns`. Every match is counted so that
+/// an ambiguous signature can be rejected instead of silently taking the first hit.
+struct Signature {
+    const char *name;
+    const char *pattern;
+    struct Pattern compiled;
+    void *matches[SIGNATURE_MAX_MATCHES]; ///< The first matches, lowest address first
+    size_t count; ///< Total number of matches, may exceed SIGNATURE_MAX_MATCHES
+};
+
+_Bool FindSection(void *module, const char *name, struct Section *section);
+
+_Bool CompilePattern(const char *pattern, struct Pattern *result);
+
+_Bool MatchPattern(const void *position, const struct Pattern *pattern);
+
+_Bool FindCompiledPattern(const void *start, const void *end, const struct Pattern *pattern, void **position);
 
 _Bool FindPattern(void *start, const void *end, const char *pattern, void **position);
 
+_Bool FindCompiledPatternParallel(const void *start, const void *end, const struct Pattern *pattern, unsigned threads, void **position);
+
+_Bool FindPatternParallel(void *start, const void *end, const char *pattern, unsigned threads, void **position);
+
+_Bool FindPatterns(const struct Section *section, struct Signature *signatures, size_t count);
+
 #endif //DECIMA_NATIVE_SCAN_H
@@ -0,0 +1,19 @@
+#ifndef DECIMA_NATIVE_SORT_H
+#define DECIMA_NATIVE_SORT_H
+
+#include "rtti.h"
+
+#include <stddef.h>
+
+/// Position of a kind in the dumps: compounds, enums, enum flags, atoms, then everything else.
+int RTTIKind_Order(struct RTTI *rtti);
+
+/// qsort comparator of two struct RTTI * by `RTTIKind_Order` and then by name.
+int RTTIKind_CompareLexical(const void *a, const void *b);
+
+/// Orders types exactly like qsort with `RTTIKind_CompareLexical`. Names are gathered once into contiguous
+/// keys that are radix sorted in the dump session, only the types sharing their first 8 name bytes look further
+/// into their names. Returns 0 without touching the types when the keys cannot be allocated.
+_Bool SortTypes(struct RTTI **types, size_t count);
+
+#endif //DECIMA_NATIVE_SORT_H
@@ -0,0 +1,39 @@
+#ifndef DECIMA_NATIVE_STATS_H
+#define DECIMA_NATIVE_STATS_H
+
+#include "json.h"
+
+#include <stdio.h>
+#include <stdint.h>
+
+#define STATS_MAX_PHASES 32
+#define STATS_MAX_COUNTERS 64
+#define STATS_MAX_EVENTS 65536
+
+/// Timing of the dump phases and named counters, reported as `$stats` in hfw_types.json
+/// and optionally as a Chrome trace (chrome://tracing, Perfetto). Names must be string literals.
+/// Not thread-safe, only the dumping thread records into it.
+struct StatsTimer {
+    const char *name;
+    uint64_t start;
+};
+
+/// Monotonic time in nanoseconds.
+uint64_t StatsNow(void);
+
+struct StatsTimer StatsBegin(const char *name);
+
+/// Adds the time since `StatsBegin` to the phase; a phase may run any number of times.
+void StatsEnd(struct StatsTimer timer);
+
+void StatsSet(const char *name, uint64_t value);
+
+void StatsAdd(const char *name, uint64_t value);
+
+/// Writes every phase and counter as one object value.
+void StatsExport(struct JsonContext *ctx);
+
+/// Writes every recorded phase run as a trace event.
+void StatsWriteTrace(FILE *file);
+
+#endif //DECIMA_NATIVE_STATS_H
@@ -0,0 +1,88 @@
+#ifndef DECIMA_NATIVE_THREAD_H
+#define DECIMA_NATIVE_THREAD_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+#define THREAD_MAX_WORKERS 64
+
+struct Thread {
+    void *handle;
+};
+
+/// Lock for short critical sections, a zeroed one is unlocked.
+struct SpinLock {
+    volatile size_t locked;
+};
+
+_Bool ThreadStart(struct Thread *thread, void (*proc)(void *), void *argument);
+
+void ThreadJoin(struct Thread *thread);
+
+unsigned ThreadCount(void);
+
+/// Gives up the rest of the time slice when `milliseconds` is 0.
+void ThreadSleep(unsigned milliseconds);
+
+/// Runs `proc` on `threads` threads (the calling one included) and waits for all of them.
+/// Each invocation receives its own index in [0, threads).
+void ThreadRunParallel(unsigned threads, void (*proc)(void *context, unsigned index), void *context);
+
+static inline size_t AtomicLoad(volatile size_t *value) {
+#ifdef _MSC_VER
+    return (size_t) _InterlockedCompareExchange64((volatile __int64 *) value, 0, 0);
+#else
+    return __atomic_load_n(value, __ATOMIC_ACQUIRE);
+#endif
+}
+
+static inline void AtomicStore(volatile size_t *value, size_t desired) {
+#ifdef _MSC_VER
+    _InterlockedExchange64((volatile __int64 *) value, (__int64) desired);
+#else
+    __atomic_store_n(value, desired, __ATOMIC_RELEASE);
+#endif
+}
+
+static inline size_t AtomicFetchAdd(volatile size_t *value, size_t addend) {
+#ifdef _MSC_VER
+    return (size_t) _InterlockedExchangeAdd64((volatile __int64 *) value, (__int64) addend);
+#else
+    return __atomic_fetch_add(value, addend, __ATOMIC_ACQ_REL);
+#endif
+}
+
+static inline _Bool AtomicCompareExchange(volatile size_t *value, size_t expected, size_t desired) {
+#ifdef _MSC_VER
+    return (size_t) _InterlockedCompareExchange64((volatile __int64 *) value, (__int64) desired, (__int64) expected) == expected;
+#else
+    return __atomic_compare_exchange_n(value, &expected, desired, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+#endif
+}
+
+static inline void SpinLockAcquire(struct SpinLock *lock) {
+    while (!AtomicCompareExchange(&lock->locked, 0, 1)) {
+        while (AtomicLoad(&lock->locked)) {
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+            _mm_pause();
+#elif defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+            __builtin_ia32_pause();
+#endif
+        }
+    }
+}
+
+/// Takes the lock only if nobody holds it.
+static inline _Bool SpinLockTryAcquire(struct SpinLock *lock) {
+    return AtomicCompareExchange(&lock->locked, 0, 1);
+}
+
+static inline void SpinLockRelease(struct SpinLock *lock) {
+    AtomicStore(&lock->locked, 0);
+}
+
+#endif //DECIMA_NATIVE_THREAD_H
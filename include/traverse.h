@@ -0,0 +1,30 @@
+#ifndef DECIMA_NATIVE_TRAVERSE_H
+#define DECIMA_NATIVE_TRAVERSE_H
+
+#include "rtti.h"
+#include "typeset.h"
+
+#include <stddef.h>
+
+/// Walks the RTTI graph with an explicit stack instead of recursion, so that arbitrarily
+/// deep container/compound chains cannot exhaust the stack of the thread it runs on.
+/// Types are reported in the same pre-order a recursive walk would produce.
+struct Traversal {
+    struct TypeSet visited;
+    struct RTTI **stack;
+    size_t depth;
+    size_t capacity;
+    void (*visit)(struct RTTI *rtti, void *context);
+    void *context;
+    _Bool failed; ///< Ran out of memory, `visited` lacks types and nothing more is added
+};
+
+_Bool TraversalInit(struct Traversal *traversal, size_t capacity, void (*visit)(struct RTTI *, void *), void *context);
+
+void TraversalFree(struct Traversal *traversal);
+
+/// Visits the root and everything reachable from it that was not visited yet. Returns 0 when out of memory,
+/// the walk is abandoned then and every later call fails too.
+_Bool TraversalAdd(struct Traversal *traversal, struct RTTI *root);
+
+#endif //DECIMA_NATIVE_TRAVERSE_H
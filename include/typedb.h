@@ -0,0 +1,109 @@
+#ifndef DECIMA_NATIVE_TYPEDB_H
+#define DECIMA_NATIVE_TYPEDB_H
+
+#include "mapping.h"
+#include "rtti.h"
+#include "perfecthash.h"
+
+#include <stdio.h>
+#include <stdint.h>
+
+#define TYPEDB_MAGIC 0x4454444E // 'NDTD'
+#define TYPEDB_VERSION 4
+#define TYPEDB_NONE 0xFFFFFFFF
+
+#define TYPEDB_ATTR_PROPERTY 0x1
+
+#define TYPEDB_TYPE_SIGNED 0x1 ///< Enums whose values are signed, see RTTI_EnumSigned
+
+/// Binary counterpart of hfw_types.json that can be mapped and used without parsing.
+/// All strings are offsets into the interned string table, so equal strings have equal offsets.
+/// Every array is referenced from the type records by a (first, count) index range.
+/// Types are found by name through a minimal perfect hash over their names, see perfecthash.h.
+struct TypeDbHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t num_types;
+    uint32_t num_attrs;
+    uint32_t num_bases;
+    uint32_t num_values;
+    uint32_t num_messages;
+    uint32_t strings_size;
+    uint64_t types_offset;
+    uint64_t attrs_offset;
+    uint64_t bases_offset;
+    uint64_t values_offset;
+    uint64_t messages_offset;
+    uint64_t strings_offset;
+    uint32_t num_buckets;
+    uint32_t num_slots;
+    uint64_t hash_seed;
+    uint64_t buckets_offset;
+    uint64_t slots_offset; ///< Type index of every slot
+};
+
+struct TypeDbType {
+    uint32_t name;
+    uint8_t kind; ///< enum RTTIKind
+    uint8_t attributes; ///< TYPEDB_TYPE_*
+    uint16_t flags;
+    uint32_t version;
+    uint32_t size;
+    uint32_t base_type; ///< Atoms only, name of the base type
+    uint32_t first_attr;
+    uint32_t num_attrs;
+    uint32_t first_base;
+    uint32_t num_bases;
+    uint32_t first_value;
+    uint32_t num_values;
+    uint32_t first_message;
+    uint32_t num_messages;
+    uint64_t hash; ///< Of the contents with strings rather than offsets, equal across dumps for an unchanged type
+};
+
+struct TypeDbAttr {
+    uint32_t name;
+    uint32_t type; ///< TYPEDB_NONE for a category marker
+    uint16_t offset;
+    uint16_t flags;
+    uint32_t min;
+    uint32_t max;
+    uint32_t attributes; ///< TYPEDB_ATTR_*
+};
+
+struct TypeDbBase {
+    uint32_t type;
+    uint32_t offset;
+};
+
+struct TypeDbValue {
+    uint64_t value; ///< Normalized to the size of the enum, see RTTI_EnumNormalize
+    uint32_t name;
+    uint32_t aliases[4];
+    uint32_t reserved;
+};
+
+struct TypeDb {
+    const struct TypeDbHeader *header;
+    const struct TypeDbType *types;
+    const struct TypeDbAttr *attrs;
+    const struct TypeDbBase *bases;
+    const struct TypeDbValue *values;
+    const uint32_t *messages; ///< Names of the handled message types
+    const char *strings;
+    struct PerfectHash names; ///< Points into the mapping
+    struct FileMapping mapping;
+};
+
+_Bool TypeDbWrite(FILE *file, struct RTTI **types, size_t count);
+
+_Bool TypeDbOpen(const char *path, struct TypeDb *db);
+
+void TypeDbClose(struct TypeDb *db);
+
+const char *TypeDbString(const struct TypeDb *db, uint32_t offset);
+
+/// One hash and one string comparison, see perfecthash.h.
+const struct TypeDbType *TypeDbFind(const struct TypeDb *db, const char *name);
+
+#endif //DECIMA_NATIVE_TYPEDB_H
@@ -0,0 +1,23 @@
+#ifndef DECIMA_NATIVE_TYPEHASH_H
+#define DECIMA_NATIVE_TYPEHASH_H
+
+#include "rtti.h"
+
+#include <stdint.h>
+
+/// Structural hash of a type over its kind, name and size, the offsets and hashes of its bases,
+/// the names, offsets and hashes of the types of its attrs, the hash of the item type of containers,
+/// and the values of enums. Handled messages and the version are left out.
+///
+/// Types held by value contribute their own structural hash, so a layout change anywhere below
+/// a type changes its hash too. Pointers only contribute the kind and display name of their item,
+/// as do types that still reach each other through a cycle of containers, which keeps the result
+/// the same no matter which member of the cycle is hashed first.
+///
+/// Computed once per object and kept in the dump session (see arena.h). Safe to call from several threads at once.
+uint64_t TypeHash(struct RTTI *rtti);
+
+/// Forgets every cached hash, must be called before the session is reset.
+void TypeHashReset(void);
+
+#endif //DECIMA_NATIVE_TYPEHASH_H
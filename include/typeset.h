@@ -0,0 +1,31 @@
+#ifndef DECIMA_NATIVE_TYPESET_H
+#define DECIMA_NATIVE_TYPESET_H
+
+#include "rtti.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+/// Open-addressing set of RTTI objects keyed by pointer identity.
+/// Members are also kept in insertion order in `items`.
+struct TypeSet {
+    struct RTTI **slots;
+    size_t capacity; ///< Number of slots, always a power of two
+    unsigned shift; ///< 64 - log2(capacity)
+    struct RTTI **items;
+    size_t count;
+    size_t probes; ///< Total number of slots inspected, for statistics
+    _Bool failed; ///< An insert ran out of memory, the set lacks that member
+};
+
+_Bool TypeSetInit(struct TypeSet *set, size_t capacity);
+
+void TypeSetFree(struct TypeSet *set);
+
+/// 1 when the type was added, 0 when it was already present or when the set could not grow,
+/// which also sets `failed`.
+_Bool TypeSetInsert(struct TypeSet *set, struct RTTI *rtti);
+
+_Bool TypeSetContains(struct TypeSet *set, struct RTTI *rtti);
+
+#endif //DECIMA_NATIVE_TYPESET_H
@@ -0,0 +1,132 @@
+#include "arena.h"
+#include "thread.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/// Precedes every SessionMalloc allocation, so that SessionRealloc knows how much to copy.
+struct SessionHeader {
+    size_t size;
+    size_t reserved;
+};
+
+static struct Arena g_session;
+static struct SpinLock g_session_lock;
+
+void *ArenaAlloc(struct Arena *arena, size_t size, size_t alignment) {
+    struct ArenaBlock *block = arena->head;
+
+    if (block != NULL) {
+        uintptr_t data = (uintptr_t) (block + 1);
+        size_t offset = ((data + block->used + alignment - 1) & ~(uintptr_t) (alignment - 1)) - data;
+
+        if (offset <= block->size && block->size - offset >= size) {
+            block->used = offset + size;
+            arena->stats.used += size;
+            arena->stats.total += size;
+            return (void *) (data + offset);
+        }
+    }
+
+    // Oversized allocations get a block of their own
+    size_t block_size = arena->block_size ? arena->block_size : ARENA_BLOCK_SIZE;
+    if (block_size < size + alignment)
+        block_size = size + alignment;
+
+    block = malloc(sizeof(struct ArenaBlock) + block_size);
+    if (block == NULL)
+        return NULL;
+
+    block->next = arena->head;
+    block->size = block_size;
+    block->used = 0;
+    arena->head = block;
+
+    arena->stats.reserved += sizeof(struct ArenaBlock) + block_size;
+    arena->stats.num_blocks++;
+    if (arena->stats.peak < arena->stats.reserved)
+        arena->stats.peak = arena->stats.reserved;
+
+    return ArenaAlloc(arena, size, alignment);
+}
+
+char *ArenaCopyString(struct Arena *arena, const char *string, size_t length) {
+    char *copy = ArenaAlloc(arena, length + 1, 1);
+
+    if (copy != NULL) {
+        memcpy(copy, string, length);
+        copy[length] = '\0';
+    }
+
+    return copy;
+}
+
+void ArenaReset(struct Arena *arena) {
+    struct ArenaBlock *block = arena->head;
+
+    while (block != NULL) {
+        struct ArenaBlock *next = block->next;
+        free(block);
+        block = next;
+    }
+
+    arena->head = NULL;
+    arena->stats.used = 0;
+    arena->stats.reserved = 0;
+    arena->stats.num_blocks = 0;
+}
+
+void *SessionAlloc(size_t size, size_t alignment) {
+    SpinLockAcquire(&g_session_lock);
+    void *memory = ArenaAlloc(&g_session, size, alignment);
+    SpinLockRelease(&g_session_lock);
+
+    return memory;
+}
+
+void *SessionMalloc(size_t size) {
+    struct SessionHeader *header = SessionAlloc(sizeof(struct SessionHeader) + size, sizeof(struct SessionHeader));
+
+    if (header == NULL)
+        return NULL;
+
+    header->size = size;
+    return header + 1;
+}
+
+void *SessionRealloc(void *memory, size_t size) {
+    if (memory == NULL)
+        return SessionMalloc(size);
+
+    struct SessionHeader *header = (struct SessionHeader *) memory - 1;
+
+    if (header->size >= size) {
+        header->size = size;
+        return memory;
+    }
+
+    void *grown = SessionMalloc(size);
+    if (grown != NULL)
+        memcpy(grown, memory, header->size);
+
+    return grown;
+}
+
+void SessionFree(void *memory) {
+    (void) memory;
+}
+
+struct ArenaStats SessionStats(void) {
+    SpinLockAcquire(&g_session_lock);
+    struct ArenaStats stats = g_session.stats;
+    SpinLockRelease(&g_session_lock);
+
+    return stats;
+}
+
+void SessionReset(void) {
+    SpinLockAcquire(&g_session_lock);
+    ArenaReset(&g_session);
+    SpinLockRelease(&g_session_lock);
+}
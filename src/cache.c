@@ -0,0 +1,158 @@
+#include "cache.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#define CACHE_MAGIC 0x4353444E // 'NDSC'
+#define CACHE_VERSION 1
+#define CACHE_MAX_ENTRIES 64
+
+struct CacheHeader {
+    uint32_t magic;
+    uint32_t version;
+    struct SignatureCacheKey key;
+    uint32_t count;
+    uint32_t reserved;
+};
+
+struct CacheEntry {
+    uint64_t pattern_hash; ///< Hash of the signature text, so editing a signature invalidates its entry
+    uint32_t rva;
+    uint32_t reserved;
+};
+
+static uint64_t Fnv1a(const void *data, size_t size) {
+    const uint8_t *bytes = data;
+    uint64_t hash = 0xCBF29CE484222325ull;
+
+    for (size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= 0x100000001B3ull;
+    }
+
+    return hash;
+}
+
+_Bool SignatureCacheKeyOf(const struct PeImage *image, const char *section, struct SignatureCacheKey *key) {
+    const struct PeSectionHeader *header = PeFindSectionHeader(image, section);
+
+    if (header == NULL)
+        return 0;
+
+    memset(key, 0, sizeof(*key));
+    key->time_date_stamp = image->time_date_stamp;
+    key->size_of_image = image->size_of_image;
+    key->section_hash = Fnv1a(header, sizeof(*header));
+
+    return 1;
+}
+
+static size_t LoadCache(const char *path, const struct SignatureCacheKey *key, struct CacheEntry *entries) {
+    struct CacheHeader header;
+    FILE *file = fopen(path, "rb");
+
+    if (file == NULL)
+        return 0;
+
+    if (fread(&header, sizeof(header), 1, file) != 1
+        || header.magic != CACHE_MAGIC
+        || header.version != CACHE_VERSION
+        || memcmp(&header.key, key, sizeof(*key)) != 0
+        || header.count > CACHE_MAX_ENTRIES
+        || fread(entries, sizeof(*entries), header.count, file) != header.count) {
+        fclose(file);
+        return 0;
+    }
+
+    fclose(file);
+    return header.count;
+}
+
+static void StoreCache(const char *path, const struct SignatureCacheKey *key, const struct CacheEntry *entries, size_t count) {
+    struct CacheHeader header = {CACHE_MAGIC, CACHE_VERSION, *key, (uint32_t) count, 0};
+    FILE *file = fopen(path, "wb");
+
+    if (file == NULL)
+        return;
+
+    fwrite(&header, sizeof(header), 1, file);
+    fwrite(entries, sizeof(*entries), count, file);
+    fclose(file);
+}
+
+/// Checks every signature against the RVA remembered for it; all of them must still match.
+static _Bool VerifyCached(const struct PeImage *image, const struct Section *section, struct Signature *signatures, size_t count,
+                          const struct CacheEntry *entries, size_t num_entries) {
+    for (size_t i = 0; i < count; i++) {
+        struct Signature *signature = &signatures[i];
+        uint64_t pattern_hash = Fnv1a(signature->pattern, strlen(signature->pattern));
+        const struct CacheEntry *entry = NULL;
+        void *position;
+
+        for (size_t j = 0; j < num_entries && entry == NULL; j++) {
+            if (entries[j].pattern_hash == pattern_hash)
+                entry = &entries[j];
+        }
+
+        if (entry == NULL || !PeRvaToPointer(image, entry->rva, &position))
+            return 0;
+
+        // A stale RVA may now point into another section, past the end the distance below would wrap
+        if (position < section->start || position > section->end
+            || (size_t) ((uint8_t *) section->end - (uint8_t *) position) < signature->compiled.length)
+            return 0;
+
+        if (!MatchPattern(position, &signature->compiled))
+            return 0;
+
+        signature->matches[0] = position;
+        signature->count = 1;
+    }
+
+    return 1;
+}
+
+_Bool ResolveSignatures(const char *path, const struct PeImage *image, const char *section_name,
+                        struct Signature *signatures, size_t count, _Bool *cached) {
+    struct SignatureCacheKey key;
+    struct Section section;
+    struct CacheEntry entries[CACHE_MAX_ENTRIES];
+
+    *cached = 0;
+
+    if (!PeFindSection(image, section_name, &section) || !SignatureCacheKeyOf(image, section_name, &key))
+        return 0;
+
+    for (size_t i = 0; i < count; i++) {
+        signatures[i].count = 0;
+        if (!CompilePattern(signatures[i].pattern, &signatures[i].compiled))
+            return 0;
+    }
+
+    size_t num_entries = LoadCache(path, &key, entries);
+    if (num_entries && VerifyCached(image, &section, signatures, count, entries, num_entries)) {
+        *cached = 1;
+        return 1;
+    }
+
+    if (!FindPatterns(&section, signatures, count))
+        return 0;
+
+    // Only unambiguous results are worth remembering
+    if (count > CACHE_MAX_ENTRIES)
+        return 1;
+
+    for (size_t i = 0; i < count; i++) {
+        uint64_t address;
+
+        if (signatures[i].count != 1 || !PeAddressOf(image, signatures[i].matches[0], &address))
+            return 1;
+
+        entries[i].pattern_hash = Fnv1a(signatures[i].pattern, strlen(signatures[i].pattern));
+        entries[i].rva = (uint32_t) (address - image->image_base);
+        entries[i].reserved = 0;
+    }
+
+    StoreCache(path, &key, entries, count);
+    return 1;
+}
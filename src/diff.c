@@ -0,0 +1,454 @@
+#include "diff.h"
+#include "json.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define DIFF_MAX_ENTRIES 65536 ///< Per type, every count in the RTTI fits in 16 bits
+#define DIFF_UNCHANGED (TYPEDB_NONE - 1)
+
+struct Diff {
+    struct JsonContext ctx;
+    const struct TypeDb *previous;
+    const struct TypeDb *current;
+    uint8_t *matched; ///< Previous entries of the type being compared that have been paired
+    uint32_t *pairs; ///< Paired previous entry of every current one, or TYPEDB_NONE
+};
+
+static _Bool StringsEqual(const char *a, const char *b) {
+    if (a == NULL || b == NULL)
+        return a == b;
+
+    return strcmp(a, b) == 0;
+}
+
+static const char *OrEmpty(const char *string) {
+    return string ? string : "";
+}
+
+/// Previous and current values are written as a pair, which may sit inside a compact object.
+static void DiffNumber(struct JsonContext *ctx, const char *name, uint64_t previous, uint64_t current) {
+    int compact = ctx->compact;
+
+    if (previous == current)
+        return;
+
+    JsonNameCompactArray(ctx, name);
+    JsonValueUnsigned(ctx, previous);
+    JsonValueUnsigned(ctx, current);
+    JsonEndArray(ctx);
+    JsonCompact(ctx, compact);
+}
+
+static void DiffString(struct JsonContext *ctx, const char *name, const char *previous, const char *current) {
+    int compact = ctx->compact;
+
+    if (StringsEqual(previous, current))
+        return;
+
+    JsonNameCompactArray(ctx, name);
+    JsonValueStr(ctx, OrEmpty(previous));
+    JsonValueStr(ctx, OrEmpty(current));
+    JsonEndArray(ctx);
+    JsonCompact(ctx, compact);
+}
+
+/// Pairs every entry of a type with the first unpaired previous entry of the same name. The same position
+/// is tried first since most entries stay where they were. Entries without a name are never paired.
+/// Returns whether anything was left unpaired on either side.
+static _Bool PairByName(struct Diff *diff, const uint8_t *previous, uint32_t num_previous, const uint8_t *current,
+                        uint32_t num_current, size_t stride, const char *(*name_of)(const struct TypeDb *, const void *)) {
+    _Bool unpaired = 0;
+
+    memset(diff->matched, 0, num_previous);
+
+    for (uint32_t i = 0; i < num_current; i++) {
+        const char *name = name_of(diff->current, current + i * stride);
+        diff->pairs[i] = TYPEDB_NONE;
+
+        if (name == NULL)
+            continue;
+
+        for (uint32_t n = 0; n < num_previous; n++) {
+            uint32_t j = n == 0 ? (i < num_previous ? i : 0) : n - (n <= i && i < num_previous);
+
+            if (!diff->matched[j] && StringsEqual(name_of(diff->previous, previous + j * stride), name)) {
+                diff->matched[j] = 1;
+                diff->pairs[i] = j;
+                break;
+            }
+        }
+
+        unpaired |= diff->pairs[i] == TYPEDB_NONE;
+    }
+
+    for (uint32_t j = 0; j < num_previous && !unpaired; j++)
+        unpaired = !diff->matched[j] && name_of(diff->previous, previous + j * stride) != NULL;
+
+    return unpaired;
+}
+
+static const char *AttrName(const struct TypeDb *db, const void *entry) {
+    const struct TypeDbAttr *attr = entry;
+    return attr->type == TYPEDB_NONE ? NULL : TypeDbString(db, attr->name);
+}
+
+static const char *ValueName(const struct TypeDb *db, const void *entry) {
+    return TypeDbString(db, ((const struct TypeDbValue *) entry)->name);
+}
+
+static _Bool AttrsEqual(const struct Diff *diff, const struct TypeDbAttr *previous, const struct TypeDbAttr *current) {
+    return previous->offset == current->offset && previous->flags == current->flags && previous->attributes == current->attributes
+           && StringsEqual(TypeDbString(diff->previous, previous->type), TypeDbString(diff->current, current->type))
+           && StringsEqual(TypeDbString(diff->previous, previous->min), TypeDbString(diff->current, current->min))
+           && StringsEqual(TypeDbString(diff->previous, previous->max), TypeDbString(diff->current, current->max));
+}
+
+static _Bool AliasesEqual(const struct Diff *diff, const struct TypeDbValue *previous, const struct TypeDbValue *current) {
+    for (size_t i = 0; i < 4; i++) {
+        if (!StringsEqual(TypeDbString(diff->previous, previous->aliases[i]), TypeDbString(diff->current, current->aliases[i])))
+            return 0;
+    }
+
+    return 1;
+}
+
+static _Bool ValuesEqual(const struct Diff *diff, const struct TypeDbValue *previous, const struct TypeDbValue *current) {
+    return previous->value == current->value && AliasesEqual(diff, previous, current);
+}
+
+static void WriteAttr(struct JsonContext *ctx, const struct TypeDb *db, const struct TypeDbAttr *attr) {
+    JsonBeginCompactObject(ctx);
+    JsonNameValueStr(ctx, "mTypeName", OrEmpty(TypeDbString(db, attr->name)));
+    JsonNameValueStr(ctx, "mType", OrEmpty(TypeDbString(db, attr->type)));
+    JsonNameValueNum(ctx, "mOffset", attr->offset);
+    JsonNameValueNum(ctx, "mFlags", attr->flags);
+    if (attr->min != TYPEDB_NONE)
+        JsonNameValueStr(ctx, "min", OrEmpty(TypeDbString(db, attr->min)));
+    if (attr->max != TYPEDB_NONE)
+        JsonNameValueStr(ctx, "max", OrEmpty(TypeDbString(db, attr->max)));
+    if (attr->attributes & TYPEDB_ATTR_PROPERTY)
+        JsonNameValueBool(ctx, "property", 1);
+    JsonEndCompactObject(ctx);
+}
+
+/// Only written inside of compact objects.
+static void WriteAliases(struct JsonContext *ctx, const struct TypeDb *db, const struct TypeDbValue *value) {
+    JsonBeginArray(ctx);
+    for (size_t j = 0; j < 4 && value->aliases[j] != TYPEDB_NONE; j++)
+        JsonValueStr(ctx, OrEmpty(TypeDbString(db, value->aliases[j])));
+    JsonEndArray(ctx);
+}
+
+/// Signed like in hfw_types.json, so that both write the same number for a value.
+static void WriteNumber(struct JsonContext *ctx, const struct TypeDbType *type, uint64_t value) {
+    if (type->attributes & TYPEDB_TYPE_SIGNED)
+        JsonValueNum(ctx, (int64_t) value);
+    else
+        JsonValueUnsigned(ctx, value);
+}
+
+static void WriteValue(struct JsonContext *ctx, const struct TypeDb *db, const struct TypeDbType *type,
+                       const struct TypeDbValue *value) {
+    JsonBeginCompactObject(ctx);
+    JsonName(ctx, "mValue");
+    WriteNumber(ctx, type, value->value);
+    JsonNameValueStr(ctx, "mTypeName", OrEmpty(TypeDbString(db, value->name)));
+    if (value->aliases[0] != TYPEDB_NONE) {
+        JsonName(ctx, "alias");
+        WriteAliases(ctx, db, value);
+    }
+    JsonEndCompactObject(ctx);
+}
+
+/// Attrs are paired by name, category markers only group attrs and are left out.
+static void DiffAttrs(struct Diff *diff, const struct TypeDbType *previous, const struct TypeDbType *current) {
+    struct JsonContext *ctx = &diff->ctx;
+    const struct TypeDbAttr *old_attrs = &diff->previous->attrs[previous->first_attr];
+    const struct TypeDbAttr *new_attrs = &diff->current->attrs[current->first_attr];
+    _Bool unpaired = PairByName(diff, (const uint8_t *) old_attrs, previous->num_attrs, (const uint8_t *) new_attrs,
+                                current->num_attrs, sizeof(struct TypeDbAttr), AttrName);
+    _Bool changed = 0;
+
+    for (uint32_t i = 0; i < current->num_attrs && !changed; i++)
+        changed = diff->pairs[i] != TYPEDB_NONE && !AttrsEqual(diff, &old_attrs[diff->pairs[i]], &new_attrs[i]);
+
+    if (!unpaired && !changed)
+        return;
+
+    JsonNameObject(ctx, "mAttrs");
+
+    JsonNameArray(ctx, "added");
+    for (uint32_t i = 0; i < current->num_attrs; i++) {
+        if (new_attrs[i].type != TYPEDB_NONE && diff->pairs[i] == TYPEDB_NONE)
+            WriteAttr(ctx, diff->current, &new_attrs[i]);
+    }
+    JsonEndArray(ctx);
+
+    JsonNameArray(ctx, "removed");
+    for (uint32_t j = 0; j < previous->num_attrs; j++) {
+        if (old_attrs[j].type != TYPEDB_NONE && !diff->matched[j])
+            WriteAttr(ctx, diff->previous, &old_attrs[j]);
+    }
+    JsonEndArray(ctx);
+
+    JsonNameArray(ctx, "changed");
+    for (uint32_t i = 0; i < current->num_attrs; i++) {
+        if (diff->pairs[i] == TYPEDB_NONE || AttrsEqual(diff, &old_attrs[diff->pairs[i]], &new_attrs[i]))
+            continue;
+
+        const struct TypeDbAttr *old_attr = &old_attrs[diff->pairs[i]];
+        const struct TypeDbAttr *new_attr = &new_attrs[i];
+
+        JsonBeginCompactObject(ctx);
+        JsonNameValueStr(ctx, "mTypeName", OrEmpty(TypeDbString(diff->current, new_attr->name)));
+        DiffString(ctx, "mType", TypeDbString(diff->previous, old_attr->type), TypeDbString(diff->current, new_attr->type));
+        DiffNumber(ctx, "mOffset", old_attr->offset, new_attr->offset);
+        DiffNumber(ctx, "mFlags", old_attr->flags, new_attr->flags);
+        DiffString(ctx, "min", TypeDbString(diff->previous, old_attr->min), TypeDbString(diff->current, new_attr->min));
+        DiffString(ctx, "max", TypeDbString(diff->previous, old_attr->max), TypeDbString(diff->current, new_attr->max));
+        DiffNumber(ctx, "property", old_attr->attributes & TYPEDB_ATTR_PROPERTY, new_attr->attributes & TYPEDB_ATTR_PROPERTY);
+        JsonEndCompactObject(ctx);
+    }
+    JsonEndArray(ctx);
+
+    JsonEndObject(ctx);
+}
+
+/// Values are paired by name, so a renamed value shows up as removed and added.
+static void DiffValues(struct Diff *diff, const struct TypeDbType *previous, const struct TypeDbType *current) {
+    struct JsonContext *ctx = &diff->ctx;
+    const struct TypeDbValue *old_values = &diff->previous->values[previous->first_value];
+    const struct TypeDbValue *new_values = &diff->current->values[current->first_value];
+    _Bool unpaired = PairByName(diff, (const uint8_t *) old_values, previous->num_values, (const uint8_t *) new_values,
+                                current->num_values, sizeof(struct TypeDbValue), ValueName);
+    _Bool changed = 0;
+
+    for (uint32_t i = 0; i < current->num_values && !changed; i++)
+        changed = diff->pairs[i] != TYPEDB_NONE && !ValuesEqual(diff, &old_values[diff->pairs[i]], &new_values[i]);
+
+    if (!unpaired && !changed)
+        return;
+
+    JsonNameObject(ctx, "values");
+
+    JsonNameArray(ctx, "added");
+    for (uint32_t i = 0; i < current->num_values; i++) {
+        if (diff->pairs[i] == TYPEDB_NONE)
+            WriteValue(ctx, diff->current, current, &new_values[i]);
+    }
+    JsonEndArray(ctx);
+
+    JsonNameArray(ctx, "removed");
+    for (uint32_t j = 0; j < previous->num_values; j++) {
+        if (!diff->matched[j])
+            WriteValue(ctx, diff->previous, previous, &old_values[j]);
+    }
+    JsonEndArray(ctx);
+
+    JsonNameArray(ctx, "changed");
+    for (uint32_t i = 0; i < current->num_values; i++) {
+        if (diff->pairs[i] == TYPEDB_NONE || ValuesEqual(diff, &old_values[diff->pairs[i]], &new_values[i]))
+            continue;
+
+        const struct TypeDbValue *old_value = &old_values[diff->pairs[i]];
+        const struct TypeDbValue *new_value = &new_values[i];
+
+        JsonBeginCompactObject(ctx);
+        JsonNameValueStr(ctx, "mTypeName", OrEmpty(TypeDbString(diff->current, new_value->name)));
+        if (old_value->value != new_value->value) {
+            JsonNameArray(ctx, "mValue");
+            WriteNumber(ctx, previous, old_value->value);
+            WriteNumber(ctx, current, new_value->value);
+            JsonEndArray(ctx);
+        }
+        if (!AliasesEqual(diff, old_value, new_value)) {
+            JsonNameArray(ctx, "alias");
+            WriteAliases(ctx, diff->previous, old_value);
+            WriteAliases(ctx, diff->current, new_value);
+            JsonEndArray(ctx);
+        }
+        JsonEndCompactObject(ctx);
+    }
+    JsonEndArray(ctx);
+
+    JsonEndObject(ctx);
+}
+
+/// Bases are ordered, any difference writes the previous and the current list.
+static void DiffBases(struct Diff *diff, const struct TypeDbType *previous, const struct TypeDbType *current) {
+    struct JsonContext *ctx = &diff->ctx;
+    const struct TypeDbBase *old_bases = &diff->previous->bases[previous->first_base];
+    const struct TypeDbBase *new_bases = &diff->current->bases[current->first_base];
+    _Bool equal = previous->num_bases == current->num_bases;
+
+    for (uint32_t i = 0; equal && i < current->num_bases; i++) {
+        equal = old_bases[i].offset == new_bases[i].offset
+                && StringsEqual(TypeDbString(diff->previous, old_bases[i].type), TypeDbString(diff->current, new_bases[i].type));
+    }
+
+    if (equal)
+        return;
+
+    JsonNameArray(ctx, "mBases");
+    for (int side = 0; side < 2; side++) {
+        const struct TypeDb *db = side ? diff->current : diff->previous;
+        const struct TypeDbBase *bases = side ? new_bases : old_bases;
+        uint32_t count = side ? current->num_bases : previous->num_bases;
+
+        JsonBeginArray(ctx);
+        for (uint32_t i = 0; i < count; i++) {
+            JsonBeginCompactObject(ctx);
+            JsonNameValueStr(ctx, "mTypeName", OrEmpty(TypeDbString(db, bases[i].type)));
+            JsonNameValueNum(ctx, "mOffset", bases[i].offset);
+            JsonEndCompactObject(ctx);
+        }
+        JsonEndArray(ctx);
+    }
+    JsonEndArray(ctx);
+}
+
+/// Handled messages are a set, only the ones present on one side are written.
+static void DiffMessages(struct Diff *diff, const struct TypeDbType *previous, const struct TypeDbType *current) {
+    struct JsonContext *ctx = &diff->ctx;
+    const uint32_t *old_messages = &diff->previous->messages[previous->first_message];
+    const uint32_t *new_messages = &diff->current->messages[current->first_message];
+    _Bool equal = previous->num_messages == current->num_messages;
+
+    for (uint32_t i = 0; equal && i < current->num_messages; i++)
+        equal = StringsEqual(TypeDbString(diff->previous, old_messages[i]), TypeDbString(diff->current, new_messages[i]));
+
+    if (equal)
+        return;
+
+    JsonNameObject(ctx, "messages");
+    for (int side = 0; side < 2; side++) {
+        const struct TypeDb *db = side ? diff->previous : diff->current;
+        const struct TypeDb *other_db = side ? diff->current : diff->previous;
+        const uint32_t *messages = side ? old_messages : new_messages;
+        const uint32_t *other = side ? new_messages : old_messages;
+        uint32_t count = side ? previous->num_messages : current->num_messages;
+        uint32_t other_count = side ? current->num_messages : previous->num_messages;
+
+        JsonNameCompactArray(ctx, side ? "removed" : "added");
+        for (uint32_t i = 0; i < count; i++) {
+            const char *name = TypeDbString(db, messages[i]);
+            _Bool found = 0;
+
+            for (uint32_t j = 0; j < other_count && !found; j++)
+                found = StringsEqual(TypeDbString(other_db, other[j]), name);
+
+            if (!found)
+                JsonValueStr(ctx, OrEmpty(name));
+        }
+        JsonEndCompactArray(ctx);
+    }
+    JsonEndObject(ctx);
+}
+
+static void DiffType(struct Diff *diff, const struct TypeDbType *previous, const struct TypeDbType *current) {
+    struct JsonContext *ctx = &diff->ctx;
+
+    JsonNameObject(ctx, TypeDbString(diff->current, current->name));
+    DiffString(ctx, "kind", RTTIKind_Name(previous->kind), RTTIKind_Name(current->kind));
+    DiffNumber(ctx, "mVersion", previous->version, current->version);
+    DiffNumber(ctx, "mFlags", previous->flags, current->flags);
+    DiffNumber(ctx, "mSize", previous->size, current->size);
+    DiffString(ctx, "mBaseType", TypeDbString(diff->previous, previous->base_type), TypeDbString(diff->current, current->base_type));
+    DiffMessages(diff, previous, current);
+    DiffBases(diff, previous, current);
+
+    // Counts come from the file, entries beyond what the RTTI can hold are not paired
+    if (previous->num_attrs <= DIFF_MAX_ENTRIES && current->num_attrs <= DIFF_MAX_ENTRIES)
+        DiffAttrs(diff, previous, current);
+    if (previous->num_values <= DIFF_MAX_ENTRIES && current->num_values <= DIFF_MAX_ENTRIES)
+        DiffValues(diff, previous, current);
+
+    JsonEndObject(ctx);
+}
+
+_Bool DiffTypes(FILE *file, const struct TypeDb *previous, const struct TypeDb *current, struct DiffSummary *summary) {
+    struct Diff diff = {.previous = previous, .current = current};
+    uint32_t num_types = current->header->num_types;
+    uint32_t *paired = malloc(((size_t) num_types + 1) * sizeof(uint32_t)); ///< Previous type of every current one
+    uint8_t *seen = calloc(previous->header->num_types + 1, 1); ///< Previous types that still exist
+
+    diff.matched = malloc(DIFF_MAX_ENTRIES);
+    diff.pairs = malloc(DIFF_MAX_ENTRIES * sizeof(uint32_t));
+    memset(summary, 0, sizeof(*summary));
+
+    if (paired == NULL || seen == NULL || diff.matched == NULL || diff.pairs == NULL) {
+        free(paired);
+        free(seen);
+        free(diff.matched);
+        free(diff.pairs);
+        return 0;
+    }
+
+    // The version is bumped with most layout changes and is checked first, the hash catches the rest
+    for (uint32_t i = 0; i < num_types; i++) {
+        const struct TypeDbType *type = &current->types[i];
+        const char *name = TypeDbString(current, type->name);
+
+        const struct TypeDbType *old_type = name ? TypeDbFind(previous, name) : NULL;
+
+        paired[i] = old_type ? (uint32_t) (old_type - previous->types) : TYPEDB_NONE;
+
+        if (paired[i] == TYPEDB_NONE) {
+            summary->added++;
+            continue;
+        }
+
+        seen[paired[i]] = 1;
+
+        if (old_type->version == type->version && old_type->hash == type->hash) {
+            paired[i] = DIFF_UNCHANGED;
+            summary->unchanged++;
+        } else {
+            summary->changed++;
+        }
+    }
+
+    JsonInit(&diff.ctx, file);
+    JsonBeginObject(&diff.ctx);
+
+    JsonNameCompactObject(&diff.ctx, "$spec");
+    JsonNameValueStr(&diff.ctx, "mVersion", "5.0");
+    JsonEndCompactObject(&diff.ctx);
+
+    JsonNameArray(&diff.ctx, "added");
+    for (uint32_t i = 0; i < num_types; i++) {
+        if (paired[i] == TYPEDB_NONE)
+            JsonValueStr(&diff.ctx, OrEmpty(TypeDbString(current, current->types[i].name)));
+    }
+    JsonEndArray(&diff.ctx);
+
+    JsonNameArray(&diff.ctx, "removed");
+    for (uint32_t i = 0; i < previous->header->num_types; i++) {
+        if (seen[i])
+            continue;
+
+        // Counted from the list itself, several current types may pair with one previous type of a duplicate name
+        JsonValueStr(&diff.ctx, OrEmpty(TypeDbString(previous, previous->types[i].name)));
+        summary->removed++;
+    }
+    JsonEndArray(&diff.ctx);
+
+    JsonNameObject(&diff.ctx, "changed");
+    for (uint32_t i = 0; i < num_types; i++) {
+        if (paired[i] < DIFF_UNCHANGED)
+            DiffType(&diff, &previous->types[paired[i]], &current->types[i]);
+    }
+    JsonEndObject(&diff.ctx);
+
+    JsonNameValueUnsigned(&diff.ctx, "unchanged", summary->unchanged);
+
+    JsonEndObject(&diff.ctx);
+    JsonFinish(&diff.ctx);
+
+    free(paired);
+    free(seen);
+    free(diff.matched);
+    free(diff.pairs);
+    return 1;
+}
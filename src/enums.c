@@ -0,0 +1,330 @@
+#include "rtti.h"
+#include "arena.h"
+#include "memo.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+#define ENUM_NO_VALUE 0xFFFF
+#define ENUM_MAX_ALIASES (sizeof(((struct RTTIValue *) 0)->mAliases) / sizeof(const char *))
+#define ENUM_DIRECT_SLACK 16 ///< Holes a direct table may have on top of one per value
+
+/// Value tables of enums, keyed by the RTTI object.
+static struct Memo g_enums;
+
+struct EnumEntry {
+    uint64_t value;
+    uint32_t index;
+};
+
+struct EnumKey {
+    const char *name;
+    uint32_t hash;
+    uint16_t index;
+};
+
+/// Lookup structures of one enum, every index is into `values` of the enum.
+struct EnumTable {
+    uint64_t min; ///< Value of the first entry of `direct`
+    uint64_t range; ///< Entries of `direct`, 0 when the values are looked up in `sorted` instead
+    const uint16_t *direct; ///< Index of the first value equal to min + entry, ENUM_NO_VALUE for holes
+    const struct EnumEntry *sorted; ///< Distinct values in ascending order with the first index of each
+    uint32_t num_sorted;
+    _Bool single_bits; ///< Every value other than 0 is a single bit, flags are split with `bits`
+    uint16_t bits[64]; ///< Index of the first value that is this bit alone
+    const struct EnumKey *keys; ///< Open-addressing index of names and aliases
+    uint32_t key_mask;
+};
+
+static uint32_t HashName(const char *name) {
+    uint32_t hash = 0x811C9DC5;
+
+    while (*name) {
+        hash ^= (uint8_t) *name++;
+        hash *= 0x01000193;
+    }
+
+    return hash;
+}
+
+static unsigned LowestBit(uint64_t bits) {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward64(&index, bits);
+    return index;
+#else
+    return (unsigned) __builtin_ctzll(bits);
+#endif
+}
+
+static int CompareEntries(const void *a, const void *b) {
+    const struct EnumEntry *x = a;
+    const struct EnumEntry *y = b;
+
+    if (x->value != y->value)
+        return (x->value > y->value) - (x->value < y->value);
+    return (x->index > y->index) - (x->index < y->index);
+}
+
+static uint16_t FindKey(const struct EnumTable *table, const char *name, uint32_t hash) {
+    for (uint32_t slot = hash & table->key_mask; table->keys[slot].name; slot = (slot + 1) & table->key_mask) {
+        if (table->keys[slot].hash == hash && strcmp(table->keys[slot].name, name) == 0)
+            return table->keys[slot].index;
+    }
+
+    return ENUM_NO_VALUE;
+}
+
+/// Indexes names and aliases in declaration order, keeping the first value for a string used twice,
+/// which is what a scan over the values would find.
+static _Bool BuildKeys(struct EnumTable *table, struct RTTIEnum *enumeration) {
+    uint32_t num_slots = 16;
+
+    while (num_slots < (uint32_t) enumeration->num_values * (1 + ENUM_MAX_ALIASES))
+        num_slots *= 2;
+
+    struct EnumKey *keys = SessionAlloc(num_slots * sizeof(struct EnumKey), sizeof(void *));
+    if (keys == NULL)
+        return 0;
+
+    memset(keys, 0, num_slots * sizeof(struct EnumKey));
+    table->keys = keys;
+    table->key_mask = num_slots - 1;
+
+    for (uint16_t i = 0; i < enumeration->num_values; i++) {
+        const struct RTTIValue *value = &enumeration->values[i];
+
+        for (size_t j = 0; j <= ENUM_MAX_ALIASES; j++) {
+            const char *name = j == 0 ? value->mName : value->mAliases[j - 1];
+            if (name == NULL)
+                continue;
+
+            uint32_t hash = HashName(name);
+            if (FindKey(table, name, hash) != ENUM_NO_VALUE)
+                continue;
+
+            uint32_t slot = hash & table->key_mask;
+            while (keys[slot].name)
+                slot = (slot + 1) & table->key_mask;
+            keys[slot] = (struct EnumKey) {.name = name, .hash = hash, .index = i};
+        }
+    }
+
+    return 1;
+}
+
+/// Contiguous values get a table indexed by value, sparse ones a sorted table for a binary search.
+static _Bool BuildValues(struct EnumTable *table, struct RTTIEnum *enumeration) {
+    uint32_t count = enumeration->num_values;
+    struct EnumEntry *entries = malloc((count ? count : 1) * sizeof(struct EnumEntry));
+    uint32_t unique = 0;
+
+    if (entries == NULL)
+        return 0;
+
+    for (uint32_t i = 0; i < count; i++)
+        entries[i] = (struct EnumEntry) {.value = enumeration->values[i].mValue, .index = i};
+
+    qsort(entries, count, sizeof(struct EnumEntry), CompareEntries);
+
+    for (uint32_t i = 0; i < count; i++) {
+        if (unique == 0 || entries[unique - 1].value != entries[i].value)
+            entries[unique++] = entries[i];
+    }
+
+    uint64_t span = unique ? entries[unique - 1].value - entries[0].value : 0;
+    _Bool built;
+
+    if (unique && span < (uint64_t) unique * 2 + ENUM_DIRECT_SLACK) {
+        uint16_t *direct = SessionAlloc((span + 1) * sizeof(uint16_t), sizeof(uint16_t));
+
+        if ((built = direct != NULL)) {
+            memset(direct, 0xFF, (span + 1) * sizeof(uint16_t));
+            for (uint32_t i = 0; i < unique; i++)
+                direct[entries[i].value - entries[0].value] = (uint16_t) entries[i].index;
+
+            table->min = entries[0].value;
+            table->range = span + 1;
+            table->direct = direct;
+        }
+    } else {
+        struct EnumEntry *sorted = SessionAlloc((unique ? unique : 1) * sizeof(struct EnumEntry), sizeof(uint64_t));
+
+        if ((built = sorted != NULL)) {
+            memcpy(sorted, entries, unique * sizeof(struct EnumEntry));
+            table->sorted = sorted;
+            table->num_sorted = unique;
+        }
+    }
+
+    free(entries);
+    return built;
+}
+
+static void BuildBits(struct EnumTable *table, struct RTTIEnum *enumeration) {
+    table->single_bits = 1;
+    memset(table->bits, 0xFF, sizeof(table->bits));
+
+    for (uint16_t i = 0; i < enumeration->num_values; i++) {
+        uint64_t mask = enumeration->values[i].mValue;
+
+        if (mask == 0)
+            continue;
+
+        if (mask & (mask - 1)) {
+            table->single_bits = 0;
+            continue;
+        }
+
+        if (table->bits[LowestBit(mask)] == ENUM_NO_VALUE)
+            table->bits[LowestBit(mask)] = i;
+    }
+}
+
+static const struct EnumTable *FindTable(struct RTTIEnum *enumeration) {
+    size_t table;
+    return MemoFind(&g_enums, enumeration, &table) ? (const struct EnumTable *) table : NULL;
+}
+
+static const struct EnumTable *TableOf(struct RTTIEnum *enumeration) {
+    const struct EnumTable *table = FindTable(enumeration);
+
+    if (table != NULL)
+        return table;
+
+    SpinLockAcquire(&g_enums.lock);
+
+    if ((table = FindTable(enumeration)) == NULL) {
+        struct EnumTable *built = SessionAlloc(sizeof(struct EnumTable), sizeof(uint64_t));
+
+        if (built != NULL) {
+            memset(built, 0, sizeof(*built));
+            BuildBits(built, enumeration);
+
+            if (BuildValues(built, enumeration) && BuildKeys(built, enumeration)
+                && MemoInsert(&g_enums, enumeration, (size_t) (uintptr_t) built))
+                table = built;
+        }
+    }
+
+    SpinLockRelease(&g_enums.lock);
+
+    assert(table != NULL && "Out of memory");
+    return table;
+}
+
+/// First index of the value, ENUM_NO_VALUE when no value is equal.
+static uint32_t IndexOf(const struct EnumTable *table, uint64_t value) {
+    if (table->range)
+        return value - table->min < table->range ? table->direct[value - table->min] : ENUM_NO_VALUE;
+
+    const struct EnumEntry *entry = table->sorted;
+    uint32_t count = table->num_sorted;
+
+    if (count == 0)
+        return ENUM_NO_VALUE;
+
+    // Narrows down to the last entry not above the value without a branch to mispredict
+    while (count > 1) {
+        uint32_t half = count / 2;
+        entry = entry[half].value <= value ? entry + half : entry;
+        count -= half;
+    }
+
+    return entry->value == value ? entry->index : ENUM_NO_VALUE;
+}
+
+const char *RTTI_EnumName(struct RTTIEnum *enumeration, uint64_t value) {
+    const struct EnumTable *table = TableOf(enumeration);
+    uint32_t index;
+
+    if (table == NULL || (index = IndexOf(table, value)) == ENUM_NO_VALUE)
+        return NULL;
+
+    return enumeration->values[index].mName;
+}
+
+size_t RTTI_EnumFlags(struct RTTIEnum *enumeration, uint64_t value, const char **names, uint64_t *rest) {
+    const struct EnumTable *table = TableOf(enumeration);
+    size_t count = 0;
+
+    if (table != NULL && table->single_bits) {
+        uint16_t indices[64];
+
+        for (uint64_t bits = value; bits; bits &= bits - 1) {
+            uint16_t index = table->bits[LowestBit(bits)];
+            if (index == ENUM_NO_VALUE)
+                continue;
+
+            // Declaration order, as the values would be taken by a scan
+            size_t position = count++;
+            for (; position > 0 && indices[position - 1] > index; position--)
+                indices[position] = indices[position - 1];
+            indices[position] = index;
+            value &= ~enumeration->values[index].mValue;
+        }
+
+        for (size_t i = 0; i < count; i++)
+            names[i] = enumeration->values[indices[i]].mName;
+    } else {
+        for (int i = 0; i < enumeration->num_values && value; i++) {
+            uint64_t mask = enumeration->values[i].mValue;
+            if (mask != 0 && (value & mask) == mask) {
+                names[count++] = enumeration->values[i].mName;
+                value &= ~mask;
+            }
+        }
+    }
+
+    *rest = value;
+    return count;
+}
+
+_Bool RTTI_EnumValue(struct RTTIEnum *enumeration, const char *name, uint64_t *value) {
+    const struct EnumTable *table = TableOf(enumeration);
+    uint16_t index;
+
+    if (table == NULL || (index = FindKey(table, name, HashName(name))) == ENUM_NO_VALUE)
+        return 0;
+
+    *value = enumeration->values[index].mValue;
+    return 1;
+}
+
+_Bool RTTI_EnumSigned(struct RTTIEnum *enumeration) {
+    struct RTTIAtom *atom;
+
+    if (enumeration->representation_type != NULL && RTTI_AsAtom(enumeration->representation_type, &atom)) {
+        while (atom->mBaseType != NULL && atom->mBaseType != &atom->base && RTTI_AsAtom(atom->mBaseType, &atom))
+            continue;
+
+        if (strncmp(atom->mTypeName, "uint", 4) == 0)
+            return 0;
+        if (strncmp(atom->mTypeName, "int", 3) == 0)
+            return 1;
+    }
+
+    return enumeration->base.kind == RTTIKind_Enum;
+}
+
+uint64_t RTTI_EnumNormalize(struct RTTIEnum *enumeration, uint64_t value) {
+    unsigned bits = enumeration->size * 8;
+
+    if (bits == 0 || bits >= 64)
+        return value;
+
+    value &= ((uint64_t) 1 << bits) - 1;
+
+    if (RTTI_EnumSigned(enumeration) && value >> (bits - 1))
+        value |= ~(uint64_t) 0 << bits;
+
+    return value;
+}
+
+void RTTI_ResetEnumTables(void) {
+    MemoReset(&g_enums);
+}
@@ -0,0 +1,663 @@
+#include "export.h"
+#include "log.h"
+#include "stats.h"
+#include "typeset.h"
+#include "typehash.h"
+#include "layout.h"
+#include "thread.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define IDC_BUFFER_SIZE (256 * 1024)
+#define IDC_CHUNK_ROWS 1024
+#define IDC_LINE_ROWS 16 ///< Rows per string literal of a chunk
+#define IDC_RVA_DIGITS 12
+#define IDC_ROW_HEADER (11 + IDC_RVA_DIGITS) ///< Op, RVA, argument, count and length of the name
+#define EXPORT_CHUNK_TYPES 1024
+
+static _Bool IsExported(struct RTTI *rtti) {
+    return rtti->kind != RTTIKind_Pointer && rtti->kind != RTTIKind_Container && rtti->kind != RTTIKind_POD;
+}
+
+/// Written as 16 hex digits, consumers that read every JSON number as a double would lose bits otherwise.
+static void ExportHash(struct JsonContext *ctx, uint64_t hash) {
+    static const char digits[] = "0123456789abcdef";
+    char text[17];
+
+    for (int i = 15; i >= 0; i--, hash >>= 4)
+        text[i] = digits[hash & 0xF];
+    text[16] = '\0';
+
+    JsonNameValueStr(ctx, "hash", text);
+}
+
+static void ExportTypeBody(struct JsonContext *ctx, struct RTTI *rtti) {
+    struct RTTICompound *rtti_class;
+    struct RTTIEnum *rtti_enum;
+    struct RTTIAtom *rtti_Atom;
+
+    JsonNameValueStr(ctx, "kind", RTTIKind_Name(rtti->kind));
+    ExportHash(ctx, TypeHash(rtti));
+
+    if (RTTI_AsCompound(rtti, &rtti_class)) {
+        JsonNameValueNum(ctx, "mVersion", rtti_class->mVersion);
+        JsonNameValueNum(ctx, "mFlags", rtti_class->mFlags);
+
+        if (rtti_class->mNumMessageHandlers) {
+            JsonNameArray(ctx, "messages");
+
+            LogTrace("mMessageHandlers (pointer: %p, count: %d)\n", rtti_class->mMessageHandlers,
+                     rtti_class->mNumMessageHandlers);
+            for (int i = 0; i < rtti_class->mNumMessageHandlers; i++) {
+                struct RTTIMessageHandler *handler = &rtti_class->mMessageHandlers[i];
+                LogTrace("  message_handler %d: %p '%s'\n", i, handler->mMessage, RTTI_Name(handler->mMessage));
+                JsonValueStr(ctx, RTTI_DisplayName(handler->mMessage));
+            }
+
+            JsonEndArray(ctx);
+        }
+
+        if (rtti_class->mNumBases) {
+            JsonNameArray(ctx, "mBases");
+
+            LogTrace("mBases (pointer: %p, count: %d)\n", rtti_class->mBases, rtti_class->mNumBases);
+            for (int i = 0; i < rtti_class->mNumBases; i++) {
+                struct RTTIBase *base = &rtti_class->mBases[i];
+                LogTrace("  base %d: %p '%s'\n", i, base->mType, RTTI_Name(base->mType));
+                JsonBeginCompactObject(ctx);
+                JsonNameValueStr(ctx, "mTypeName", RTTI_DisplayName(base->mType));
+                JsonNameValueNum(ctx, "mOffset", base->mOffset);
+                JsonEndCompactObject(ctx);
+            }
+
+            JsonEndArray(ctx);
+        }
+
+        if (rtti_class->mNumAttrs) {
+            JsonNameArray(ctx, "mAttrs");
+
+            LogTrace("mAttrs (pointer: %p, count: %d)\n", rtti_class->mAttrs, rtti_class->mNumAttrs);
+            for (int i = 0; i < rtti_class->mNumAttrs; i++) {
+                struct RTTIAttr *attr = &rtti_class->mAttrs[i];
+
+                if (attr->type == NULL) {
+                    JsonBeginCompactObject(ctx);
+                    JsonNameValueStr(ctx, "category", attr->mName);
+                    JsonEndCompactObject(ctx);
+                    continue;
+                }
+
+                LogTrace("  attr %d: %p %s ('%s')\n", i, attr->type, attr->mName, RTTI_Name(attr->type));
+                JsonBeginCompactObject(ctx);
+                JsonNameValueStr(ctx, "mTypeName", attr->mName);
+                JsonNameValueStr(ctx, "mType", RTTI_DisplayName(attr->type));
+                JsonNameValueNum(ctx, "mOffset", attr->mOffset);
+                JsonNameValueNum(ctx, "mFlags", attr->mFlags);
+                if (attr->mMinValue)
+                    JsonNameValueStr(ctx, "min", attr->mMinValue);
+                if (attr->mMaxValue)
+                    JsonNameValueStr(ctx, "max", attr->mMaxValue);
+                if (attr->mGetter || attr->mSetter)
+                    JsonNameValueBool(ctx, "property", 1);
+                JsonEndCompactObject(ctx);
+            }
+
+            JsonEndArray(ctx);
+        }
+    } else if (RTTI_AsEnum(rtti, &rtti_enum)) {
+        _Bool is_signed = RTTI_EnumSigned(rtti_enum);
+
+        JsonNameValueNum(ctx, "mSize", rtti_enum->size);
+        JsonNameArray(ctx, "values");
+
+        for (int i = 0; i < rtti_enum->num_values; i++) {
+            struct RTTIValue *m = &rtti_enum->values[i];
+
+            // Written as the enum reads it, a None of -1 stays -1 rather than becoming 2^64 - 1
+            uint64_t value = RTTI_EnumNormalize(rtti_enum, m->mValue);
+
+            JsonBeginCompactObject(ctx);
+            if (is_signed)
+                JsonNameValueNum(ctx, "mValue", (int64_t) value);
+            else
+                JsonNameValueUnsigned(ctx, "mValue", value);
+            JsonNameValueStr(ctx, "mTypeName", m->mName);
+
+            if (m->mAliases[0]) {
+                JsonNameCompactArray(ctx, "alias");
+                for (size_t j = 0; j < 4 && m->mAliases[j]; j++)
+                    JsonValueStr(ctx, m->mAliases[j]);
+                JsonEndArray(ctx);
+            }
+
+            JsonEndCompactObject(ctx);
+        }
+
+        JsonEndArray(ctx);
+    } else if (RTTI_AsAtom(rtti, &rtti_Atom)) {
+        JsonNameValueStr(ctx, "mBaseType", RTTI_DisplayName(rtti_Atom->mBaseType));
+    }
+}
+
+static void ExportType(struct JsonContext *ctx, struct RTTI *rtti) {
+    if (!IsExported(rtti))
+        return;
+
+    JsonNameObject(ctx, RTTI_DisplayName(rtti));
+    ExportTypeBody(ctx, rtti);
+    JsonEndObject(ctx);
+}
+
+void StreamType(struct JsonContext *ctx, struct RTTI *rtti) {
+    if (!IsExported(rtti))
+        return;
+
+    JsonBeginObject(ctx);
+    JsonNameValueStr(ctx, "name", RTTI_DisplayName(rtti));
+    ExportTypeBody(ctx, rtti);
+    JsonEndObject(ctx);
+    JsonNextRecord(ctx);
+
+    // Keep the file usable up to the last discovered type if the game goes down mid-registration
+    JsonFlush(ctx);
+    fflush(ctx->stream);
+}
+
+/// Types split into chunks that are written on several threads, each into a context of its own.
+/// Finished chunks are appended to the document in order by whichever thread holds `lock`.
+struct ExportJob {
+    struct RTTI **types;
+    size_t count;
+    size_t num_chunks;
+    struct JsonContext *document;
+    struct JsonContext start; ///< State of the document before the first chunk, which every chunk starts from
+    struct JsonContext *chunks;
+    volatile size_t *done; ///< Per chunk, set once its context is complete
+    volatile size_t next_chunk;
+    volatile size_t next_append;
+    struct SpinLock lock;
+};
+
+/// Appends every finished chunk that is next in line. Threads finding the lock held move on, the holder
+/// checks again after releasing it, so a chunk that finishes meanwhile is never left behind.
+static void AppendChunks(struct ExportJob *job) {
+    size_t next;
+
+    do {
+        if (!SpinLockTryAcquire(&job->lock))
+            return;
+
+        for (next = job->next_append; next < job->num_chunks && AtomicLoad(&job->done[next]); next++)
+            JsonAppend(job->document, &job->chunks[next]);
+
+        AtomicStore(&job->next_append, next);
+        SpinLockRelease(&job->lock);
+    } while (next < job->num_chunks && AtomicLoad(&job->done[next]));
+}
+
+static void ExportChunks(void *context, unsigned index) {
+    struct ExportJob *job = context;
+    (void) index;
+
+    for (;;) {
+        size_t chunk = AtomicFetchAdd(&job->next_chunk, 1);
+        if (chunk >= job->num_chunks)
+            return;
+
+        size_t first = chunk * EXPORT_CHUNK_TYPES;
+        size_t last = first + EXPORT_CHUNK_TYPES < job->count ? first + EXPORT_CHUNK_TYPES : job->count;
+
+        JsonInitNested(&job->chunks[chunk], &job->start);
+        for (size_t i = first; i < last; i++)
+            ExportType(&job->chunks[chunk], job->types[i]);
+
+        AtomicStore(&job->done[chunk], 1);
+        AppendChunks(job);
+    }
+}
+
+/// Falls back to the calling thread alone when there is too little to split or no memory for the chunks.
+static void ExportTypesParallel(struct JsonContext *ctx, struct RTTI **types, size_t count, unsigned threads) {
+    struct ExportJob job = {.types = types, .count = count, .document = ctx};
+
+    job.num_chunks = (count + EXPORT_CHUNK_TYPES - 1) / EXPORT_CHUNK_TYPES;
+
+    if (threads == 0)
+        threads = ThreadCount();
+    if (threads > job.num_chunks)
+        threads = (unsigned) job.num_chunks;
+
+    if (threads > 1) {
+        job.chunks = malloc(job.num_chunks * sizeof(struct JsonContext));
+        job.done = calloc(job.num_chunks, sizeof(size_t));
+    }
+
+    if (job.chunks == NULL || job.done == NULL) {
+        threads = 1;
+        for (size_t index = 0; index < count; index++)
+            ExportType(ctx, types[index]);
+    } else {
+        job.start = *ctx;
+        ThreadRunParallel(threads, ExportChunks, &job);
+        AppendChunks(&job);
+        assert(job.next_append == job.num_chunks);
+    }
+
+    StatsSet("export_threads", threads);
+
+    free(job.chunks);
+    free((void *) job.done);
+}
+
+void ExportTypes(FILE *file, struct RTTI **types, size_t count, unsigned threads) {
+    struct StatsTimer timer = StatsBegin("export_json");
+    struct JsonContext ctx;
+    JsonInit(&ctx, file);
+    JsonBeginObject(&ctx);
+
+    JsonNameCompactObject(&ctx, "$spec");
+    JsonNameValueStr(&ctx, "mVersion", "5.0");
+    JsonEndCompactObject(&ctx);
+
+    ExportTypesParallel(&ctx, types, count, threads);
+
+    // Written last, so that it also covers this export up to here
+    StatsSet("bytes.hfw_types.json", (uint64_t) ftell(file) + ctx.length);
+    StatsEnd(timer);
+    JsonName(&ctx, "$stats");
+    StatsExport(&ctx);
+
+    JsonEndObject(&ctx);
+    JsonFinish(&ctx);
+}
+
+void ExportLayouts(FILE *file, struct RTTI **types, size_t count) {
+    struct StatsTimer timer = StatsBegin("export_layouts");
+    struct RTTICompound *compound;
+    struct JsonContext ctx;
+    JsonInit(&ctx, file);
+    JsonBeginObject(&ctx);
+
+    JsonNameCompactObject(&ctx, "$spec");
+    JsonNameValueStr(&ctx, "mVersion", "5.0");
+    JsonEndCompactObject(&ctx);
+
+    for (size_t index = 0; index < count; index++) {
+        if (!RTTI_AsCompound(types[index], &compound))
+            continue;
+
+        const struct Layout *layout = LayoutOf(compound);
+        if (layout == NULL) {
+            LogWarning("Unable to lay out '%s'\n", compound->mTypeName);
+            continue;
+        }
+
+        JsonNameObject(&ctx, compound->mTypeName);
+        JsonNameValueNum(&ctx, "mSize", compound->mSize);
+        JsonNameArray(&ctx, "fields");
+
+        for (uint32_t i = 0; i < layout->num_fields; i++) {
+            const struct LayoutField *field = &layout->fields[i];
+
+            JsonBeginCompactObject(&ctx);
+            JsonNameValueStr(&ctx, "mTypeName", field->attr->mName);
+            JsonNameValueStr(&ctx, "mType", RTTI_DisplayName(field->attr->type));
+            JsonNameValueNum(&ctx, "mOffset", field->offset);
+            if (field->owner != compound)
+                JsonNameValueStr(&ctx, "owner", field->owner->mTypeName);
+            if (field->attr->mGetter || field->attr->mSetter)
+                JsonNameValueBool(&ctx, "property", 1);
+            JsonEndCompactObject(&ctx);
+        }
+
+        JsonEndArray(&ctx);
+        JsonEndObject(&ctx);
+    }
+
+    JsonEndObject(&ctx);
+    JsonFinish(&ctx);
+    StatsEnd(timer);
+}
+
+static const char *RTTIKind_IDAName(enum RTTIKind kind) {
+    switch (kind) {
+        case RTTIKind_Atom:
+            return "RTTIAtom";
+        case RTTIKind_Pointer:
+            return "RTTIPointer";
+        case RTTIKind_Container:
+            return "RTTIContainer";
+        case RTTIKind_Enum:
+        case RTTIKind_EnumFlags:
+            return "RTTIEnum";
+        case RTTIKind_Compound:
+            return "RTTICompound";
+        case RTTIKind_POD:
+            return "RTTIPod";
+        default:
+            assert(0 && "Unexpected RTTIKind");
+            return NULL;
+    }
+}
+
+void ExportIda(FILE *file, struct RTTI **types, size_t count) {
+    fputs("#include <idc.idc>\n\nstatic main()\n{", file);
+
+    struct RTTICompound *type_compound;
+    struct RTTIEnum *type_enum;
+    struct RTTIContainer *type_container;
+    struct RTTIPointer *type_pointer;
+
+    for (size_t index = 0; index < count; index++) {
+        struct RTTI *type = types[index];
+        fprintf(file, "\n\t// %s %s\n", RTTIKind_Name(type->kind), RTTI_Name(type));
+        fprintf(file, "\tset_name(0x%p, \"RTTI_%s\");\n", type, RTTI_Name(type));
+        fprintf(file, "\tapply_type(0x%p, \"%s\");\n", type, RTTIKind_IDAName(type->kind));
+
+        if (RTTI_AsCompound(type, &type_compound)) {
+            struct RTTIBase *bases = type_compound->mBases;
+            if (bases) {
+                uint8_t bases_count = type_compound->mNumBases;
+                fprintf(file, "\tdel_items(0x%p, DELIT_SIMPLE, %zu);\n", bases, bases_count * sizeof(struct RTTIBase));
+                fprintf(file, "\tapply_type(0x%p, \"RTTIBase[%d]\");\n", bases, bases_count);
+                fprintf(file, "\tset_name(0x%p, \"%s::sBases\");\n", bases, RTTI_Name(type));
+            }
+            struct RTTIAttr *attrs = type_compound->mAttrs;
+            if (attrs) {
+                uint8_t attrs_count = type_compound->mNumAttrs;
+                fprintf(file, "\tdel_items(0x%p, DELIT_SIMPLE, %zu);\n", attrs, attrs_count * sizeof(struct RTTIAttr));
+                fprintf(file, "\tset_name(0x%p, \"%s::sAttrs\");\n", attrs, RTTI_Name(type));
+                fprintf(file, "\tapply_type(0x%p, \"RTTIAttr[%d]\");\n", attrs, attrs_count);
+            }
+            struct RTTIMessageHandler *messages = type_compound->mMessageHandlers;
+            if (messages) {
+                uint8_t messages_count = type_compound->mNumMessageHandlers;
+                fprintf(file, "\tdel_items(0x%p, DELIT_SIMPLE, %zu);\n", messages, messages_count * sizeof(struct RTTIMessageHandler));
+                fprintf(file, "\tset_name(0x%p, \"%s::sMessageHandlers\");\n", messages, RTTI_Name(type));
+                fprintf(file, "\tapply_type(0x%p, \"RTTIMessageHandler[%d]\");\n", messages, messages_count);
+
+                for (uint8_t i = 0; i < messages_count; ++i) {
+                    struct RTTIMessageHandler *message = &messages[i];
+                    if (strcmp(RTTI_Name(message->mMessage), "MsgReadBinary") == 0) {
+                        fprintf(file, "\tset_name(0x%p, \"%s::OnReadBinary\");\n", message->mHandler, RTTI_Name(type));
+                        fprintf(file, "\tapply_type(0x%p, \"__int64 __fastcall f(void* this, MsgReadBinary* msg)\");\n", message->mHandler);
+                    }
+                }
+            }
+            struct RTTIMessageOrderEntry* message_order_entries = type_compound->mMessageOrderEntries;
+            if (message_order_entries) {
+                uint8_t entry_count = type_compound->mNumMessageOrderEntries;
+                fprintf(file, "\tdel_items(0x%p, DELIT_SIMPLE, %zu);\n", message_order_entries, entry_count * sizeof(struct RTTIMessageOrderEntry));
+                fprintf(file, "\tset_name(0x%p, \"%s::sInheritedMessageHandlers\");\n", message_order_entries, RTTI_Name(type));
+                fprintf(file, "\tapply_type(0x%p, \"RTTIInheritedMessageHandler[%d]\");\n", message_order_entries, entry_count);
+            }
+            if (type_compound->mGetExportedSymbols) {
+                fprintf(file, "\tset_name(0x%p, \"%s::GetExportedSymbols\");\n", type_compound->mGetExportedSymbols, RTTI_Name(type));
+            }
+        } else if (RTTI_AsEnum(type, &type_enum)) {
+            if (type_enum->values) {
+                fprintf(file, "\tdel_items(0x%p, DELIT_SIMPLE, %zu);\n", type_enum->values,
+                        type_enum->num_values * sizeof(struct RTTIValue));
+                fprintf(file, "\tset_name(0x%p, \"%s::sValues\");\n", type_enum->values, RTTI_Name(type));
+                fprintf(file, "\tapply_type(0x%p, \"RTTIValue[%d]\");", type_enum->values, type_enum->num_values);
+            }
+        } else if (RTTI_AsContainer(type, &type_container)) {
+            const char *container_name;
+            if (strcmp(type_container->mContainerType->mTypeName, "Array") == 0) {
+                // Arrays share the same info
+                container_name = type_container->mContainerType->mTypeName;
+            } else {
+                container_name = type_container->mTypeName;
+            }
+            fprintf(file, "\tset_name(0x%p, \"%s::sInfo\");\n", type_container->mContainerType, container_name);
+            fprintf(file, "\tapply_type(0x%p, \"RTTIContainerData\");\n", type_container->mContainerType);
+        } else if (RTTI_AsPointer(type, &type_pointer)) {
+            fprintf(file, "\tset_name(0x%p, \"%s::sInfo\");\n", type_pointer->mPointerType, type_pointer->mPointerType->mTypeName);
+            fprintf(file, "\tapply_type(0x%p, \"RTTIPointerData\");\n", type_pointer->mPointerType);
+        }
+    }
+
+    fputs("}", file);
+}
+
+enum IdcTable {
+    IdcTable_Bases,
+    IdcTable_Attrs,
+    IdcTable_MessageHandlers,
+    IdcTable_MessageOrderEntries,
+    IdcTable_Values,
+};
+
+struct IdcWriter {
+    FILE *file;
+    uintptr_t image_base;
+    size_t image_size;
+    size_t rows; ///< Rows in the current chunk function
+    size_t chunks;
+    size_t skipped; ///< Annotations outside of the image
+    size_t length;
+    char buffer[IDC_BUFFER_SIZE];
+};
+
+/// Annotations are packed into one string per chunk function and applied by the loop in D. A row is an op letter,
+/// the RVA in IDC_RVA_DIGITS hex digits, an argument in 2, a count in 4, the length of the name in 4 and the name.
+/// Fixed widths let D take every field with substr without searching for separators.
+static const char g_idc_helpers[] =
+        "#include <idc.idc>\n"
+        "\n"
+        "static K(k) {\n"
+        "\tif (k == 0) return \"RTTIAtom\";\n"
+        "\tif (k == 1) return \"RTTIPointer\";\n"
+        "\tif (k == 2) return \"RTTIContainer\";\n"
+        "\tif (k == 4) return \"RTTICompound\";\n"
+        "\tif (k == 6) return \"RTTIPod\";\n"
+        "\treturn \"RTTIEnum\";\n"
+        "}\n"
+        "\n"
+        "static A(b, r, t, c, n) {\n"
+        "\tauto s, y, x;\n"
+        "\tif (t == 0) { s = %zu; y = \"RTTIBase\"; x = \"::sBases\"; }\n"
+        "\telse if (t == 1) { s = %zu; y = \"RTTIAttr\"; x = \"::sAttrs\"; }\n"
+        "\telse if (t == 2) { s = %zu; y = \"RTTIMessageHandler\"; x = \"::sMessageHandlers\"; }\n"
+        "\telse if (t == 3) { s = %zu; y = \"RTTIInheritedMessageHandler\"; x = \"::sInheritedMessageHandlers\"; }\n"
+        "\telse { s = %zu; y = \"RTTIValue\"; x = \"::sValues\"; }\n"
+        "\tdel_items(b + r, DELIT_SIMPLE, c * s);\n"
+        "\tset_name(b + r, n + x);\n"
+        "\tapply_type(b + r, sprintf(\"%%s[%%d]\", y, c));\n"
+        "}\n"
+        "\n"
+        "static D(b, t) {\n"
+        "\tauto i, e, o, r, a, c, l, n;\n"
+        "\te = strlen(t);\n"
+        "\tfor (i = 0; i < e; i = i + %d + l) {\n"
+        "\t\to = substr(t, i, i + 1);\n"
+        "\t\tr = b + xtol(substr(t, i + 1, i + %d));\n"
+        "\t\ta = xtol(substr(t, i + %d, i + %d));\n"
+        "\t\tc = xtol(substr(t, i + %d, i + %d));\n"
+        "\t\tl = xtol(substr(t, i + %d, i + %d));\n"
+        "\t\tn = substr(t, i + %d, i + %d + l);\n"
+        "\t\tif (o == \"T\") { set_name(r, \"RTTI_\" + n); apply_type(r, K(a)); }\n"
+        "\t\telse if (o == \"A\") A(b, r, a, c, n);\n"
+        "\t\telse if (o == \"I\") { set_name(r, n + \"::sInfo\"); apply_type(r, a ? \"RTTIPointerData\" : \"RTTIContainerData\"); }\n"
+        "\t\telse if (o == \"R\") { set_name(r, n + \"::OnReadBinary\"); apply_type(r, \"__int64 __fastcall f(void* this, MsgReadBinary* msg)\"); }\n"
+        "\t\telse set_name(r, n);\n"
+        "\t}\n"
+        "}\n";
+
+static void IdcFlush(struct IdcWriter *writer) {
+    fwrite(writer->buffer, 1, writer->length, writer->file);
+    writer->length = 0;
+}
+
+static void IdcWrite(struct IdcWriter *writer, const char *data, size_t size) {
+    if (IDC_BUFFER_SIZE - writer->length < size) {
+        IdcFlush(writer);
+
+        if (size > IDC_BUFFER_SIZE) {
+            fwrite(data, 1, size, writer->file);
+            return;
+        }
+    }
+
+    memcpy(writer->buffer + writer->length, data, size);
+    writer->length += size;
+}
+
+static void IdcWriteString(struct IdcWriter *writer, const char *string) {
+    IdcWrite(writer, string, strlen(string));
+}
+
+/// Writes the value as hexadecimal digits, without leading zeros when `width` is 0 and padded to `width` otherwise.
+static void IdcWriteHex(struct IdcWriter *writer, uint64_t value, unsigned width) {
+    static const char digits[] = "0123456789ABCDEF";
+    char text[16];
+    char *end = text + sizeof(text);
+    char *ptr = end;
+
+    do {
+        *--ptr = digits[value & 0xF];
+        value >>= 4;
+    } while (value || end - ptr < (ptrdiff_t) width);
+
+    IdcWrite(writer, ptr, (size_t) (end - ptr));
+}
+
+/// Writes the name into the string literal, quotes and backslashes escaped.
+static void IdcWriteEscaped(struct IdcWriter *writer, const char *name) {
+    for (const char *special; (special = strpbrk(name, "\"\\")) != NULL; name = special + 1) {
+        IdcWrite(writer, name, (size_t) (special - name));
+        IdcWrite(writer, "\\", 1);
+        IdcWrite(writer, special, 1);
+    }
+
+    IdcWriteString(writer, name);
+}
+
+/// Appends a row to the string of the current chunk, or returns 0 when the address lies outside of the image
+/// and cannot be annotated relative to it.
+static _Bool IdcRow(struct IdcWriter *writer, char op, const void *address, unsigned argument, size_t count,
+                    const char *name, const char *suffix) {
+    uintptr_t rva = (uintptr_t) address - writer->image_base;
+
+    if ((uintptr_t) address < writer->image_base || rva >= writer->image_size || (uint64_t) rva >> IDC_RVA_DIGITS * 4) {
+        writer->skipped++;
+        return 0;
+    }
+
+    // IDA compiles huge functions and literals slowly, rows are spread over functions of IDC_CHUNK_ROWS
+    // and over literals of IDC_LINE_ROWS that are concatenated
+    if (writer->rows == IDC_CHUNK_ROWS) {
+        IdcWriteString(writer, "\");\n}\n");
+        writer->rows = 0;
+    }
+    if (writer->rows == 0) {
+        IdcWriteString(writer, "\nstatic p");
+        IdcWriteHex(writer, writer->chunks++, 0);
+        IdcWriteString(writer, "(b) {\n\tD(b, \"");
+    } else if (writer->rows % IDC_LINE_ROWS == 0) {
+        IdcWriteString(writer, "\"\n\t\t+ \"");
+    }
+    writer->rows++;
+
+    IdcWrite(writer, &op, 1);
+    IdcWriteHex(writer, rva, IDC_RVA_DIGITS);
+    IdcWriteHex(writer, argument, 2);
+    IdcWriteHex(writer, count, 4);
+    IdcWriteHex(writer, strlen(name) + strlen(suffix), 4);
+    IdcWriteEscaped(writer, name);
+    IdcWriteEscaped(writer, suffix);
+    return 1;
+}
+
+static void IdcTable(struct IdcWriter *writer, const void *table, enum IdcTable kind, size_t count, const char *name) {
+    if (table != NULL)
+        IdcRow(writer, 'A', table, kind, count, name, "");
+}
+
+void ExportIdaCompact(FILE *file, struct RTTI **types, size_t count, uintptr_t image_base, size_t image_size) {
+    struct IdcWriter *writer = malloc(sizeof(struct IdcWriter));
+    struct TypeSet infos;
+    struct RTTICompound *type_compound;
+    struct RTTIEnum *type_enum;
+    struct RTTIContainer *type_container;
+    struct RTTIPointer *type_pointer;
+
+    if (writer == NULL || !TypeSetInit(&infos, 256)) {
+        free(writer);
+        return;
+    }
+
+    writer->file = file;
+    writer->image_base = image_base;
+    writer->image_size = image_size;
+    writer->rows = 0;
+    writer->chunks = 0;
+    writer->skipped = 0;
+    writer->length = 0;
+
+    fprintf(file, g_idc_helpers, sizeof(struct RTTIBase), sizeof(struct RTTIAttr), sizeof(struct RTTIMessageHandler),
+            sizeof(struct RTTIMessageOrderEntry), sizeof(struct RTTIValue), IDC_ROW_HEADER,
+            1 + IDC_RVA_DIGITS, 1 + IDC_RVA_DIGITS, 3 + IDC_RVA_DIGITS, 3 + IDC_RVA_DIGITS, 7 + IDC_RVA_DIGITS,
+            7 + IDC_RVA_DIGITS, IDC_ROW_HEADER, IDC_ROW_HEADER, IDC_ROW_HEADER);
+
+    for (size_t index = 0; index < count; index++) {
+        struct RTTI *type = types[index];
+        const char *name = RTTI_Name(type);
+
+        IdcRow(writer, 'T', type, type->kind, 0, name, "");
+
+        if (RTTI_AsCompound(type, &type_compound)) {
+            IdcTable(writer, type_compound->mBases, IdcTable_Bases, type_compound->mNumBases, name);
+            IdcTable(writer, type_compound->mAttrs, IdcTable_Attrs, type_compound->mNumAttrs, name);
+            IdcTable(writer, type_compound->mMessageHandlers, IdcTable_MessageHandlers, type_compound->mNumMessageHandlers, name);
+
+            for (uint8_t i = 0; type_compound->mMessageHandlers && i < type_compound->mNumMessageHandlers; ++i) {
+                struct RTTIMessageHandler *message = &type_compound->mMessageHandlers[i];
+                if (strcmp(RTTI_Name(message->mMessage), "MsgReadBinary") == 0)
+                    IdcRow(writer, 'R', message->mHandler, 0, 0, name, "");
+            }
+
+            IdcTable(writer, type_compound->mMessageOrderEntries, IdcTable_MessageOrderEntries, type_compound->mNumMessageOrderEntries, name);
+
+            if (type_compound->mGetExportedSymbols)
+                IdcRow(writer, 'N', type_compound->mGetExportedSymbols, 0, 0, name, "::GetExportedSymbols");
+        } else if (RTTI_AsEnum(type, &type_enum)) {
+            IdcTable(writer, type_enum->values, IdcTable_Values, type_enum->num_values, name);
+        }
+    }
+
+    // Infos are shared between many containers and annotated once. The verbose script names them
+    // after the last type using them, so they are taken from the last type backwards here.
+    for (size_t index = count; index-- > 0;) {
+        struct RTTI *type = types[index];
+
+        if (RTTI_AsContainer(type, &type_container)) {
+            if (TypeSetInsert(&infos, (struct RTTI *) type_container->mContainerType))
+                IdcRow(writer, 'I', type_container->mContainerType, 0, 0,
+                       strcmp(type_container->mContainerType->mTypeName, "Array") == 0
+                       ? type_container->mContainerType->mTypeName : type_container->mTypeName, "");
+        } else if (RTTI_AsPointer(type, &type_pointer)) {
+            if (TypeSetInsert(&infos, (struct RTTI *) type_pointer->mPointerType))
+                IdcRow(writer, 'I', type_pointer->mPointerType, 1, 0, type_pointer->mPointerType->mTypeName, "");
+        }
+    }
+
+    if (writer->rows)
+        IdcWriteString(writer, "\");\n}\n");
+
+    IdcWriteString(writer, "\nstatic main() {\n\tauto b = get_imagebase();\n");
+    for (size_t chunk = 0; chunk < writer->chunks; chunk++) {
+        IdcWriteString(writer, "\tp");
+        IdcWriteHex(writer, chunk, 0);
+        IdcWriteString(writer, "(b);\n");
+    }
+    IdcWriteString(writer, "}\n");
+    IdcFlush(writer);
+
+    if (writer->skipped)
+        LogWarning("%zu IDA annotations lie outside of the image and were left out\n", writer->skipped);
+
+    TypeSetFree(&infos);
+    free(writer);
+}
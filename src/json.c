@@ -1,9 +1,22 @@
 #include "json.h"
 
 #include <assert.h>
+#include <math.h>
 #include <stdarg.h>
+#include <stdlib.h>
 #include <string.h>
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define JSON_SSE2
+#include <emmintrin.h>
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+#define JSON_BUFFER_SIZE (1 << 20)
+
 enum JsonScope {
     JsonScope_DanglingName,
     JsonScope_EmptyArray,
@@ -14,26 +27,210 @@ enum JsonScope {
     JsonScope_NonEmptyObject,
 };
 
+static void Flush(struct JsonContext *ctx) {
+    if (ctx->stream && ctx->length) {
+        fwrite(ctx->buffer, 1, ctx->length, ctx->stream);
+        ctx->length = 0;
+    }
+}
+
+/// Makes room for `size` more bytes, flushing to the stream first when there is one.
+static char *Reserve(struct JsonContext *ctx, size_t size) {
+    if (ctx->capacity - ctx->length >= size)
+        return ctx->buffer + ctx->length;
+
+    Flush(ctx);
+
+    if (ctx->capacity - ctx->length < size) {
+        size_t capacity = ctx->capacity ? ctx->capacity : JSON_BUFFER_SIZE;
+        while (capacity - ctx->length < size)
+            capacity *= 2;
+
+        char *buffer = realloc(ctx->buffer, capacity);
+        assert(buffer != NULL && "Out of memory");
+        ctx->buffer = buffer;
+        ctx->capacity = capacity;
+    }
+
+    return ctx->buffer + ctx->length;
+}
+
+static void Write(struct JsonContext *ctx, const char *data, size_t size) {
+    memcpy(Reserve(ctx, size), data, size);
+    ctx->length += size;
+}
+
+static void WriteChar(struct JsonContext *ctx, char ch) {
+    *Reserve(ctx, 1) = ch;
+    ctx->length++;
+}
+
+static void WriteLiteral(struct JsonContext *ctx, const char *string) {
+    Write(ctx, string, strlen(string));
+}
+
+static const char g_digit_pairs[201] =
+        "00010203040506070809"
+        "10111213141516171819"
+        "20212223242526272829"
+        "30313233343536373839"
+        "40414243444546474849"
+        "50515253545556575859"
+        "60616263646566676869"
+        "70717273747576777879"
+        "80818283848586878889"
+        "90919293949596979899";
+
+/// Formats the value right-aligned into the 20 bytes ending at `end`, two digits at a time.
+static char *FormatUnsigned(char *end, uint64_t value) {
+    while (value >= 100) {
+        const char *pair = &g_digit_pairs[(value % 100) * 2];
+        value /= 100;
+        *--end = pair[1];
+        *--end = pair[0];
+    }
+
+    if (value >= 10) {
+        const char *pair = &g_digit_pairs[value * 2];
+        *--end = pair[1];
+        *--end = pair[0];
+    } else {
+        *--end = (char) ('0' + value);
+    }
+
+    return end;
+}
+
+static void WriteUnsigned(struct JsonContext *ctx, uint64_t value) {
+    char buffer[20];
+    char *start = FormatUnsigned(buffer + sizeof(buffer), value);
+    Write(ctx, start, (size_t) (buffer + sizeof(buffer) - start));
+}
+
+static void WriteInteger(struct JsonContext *ctx, int64_t value) {
+    if (value < 0) {
+        WriteChar(ctx, '-');
+        WriteUnsigned(ctx, 0 - (uint64_t) value);
+    } else {
+        WriteUnsigned(ctx, (uint64_t) value);
+    }
+}
+
+/// The shortest precision that round-trips is left to printf, floats are rare next to integers.
+static void WriteFloat(struct JsonContext *ctx, double value, int precision) {
+    char text[32];
+
+    if (!isfinite(value)) {
+        WriteLiteral(ctx, "null");
+        return;
+    }
+
+    int length = snprintf(text, sizeof(text), "%.*g", precision, value);
+    Write(ctx, text, (size_t) length);
+}
+
 static void NewLine(struct JsonContext *ctx) {
-    if (ctx->compact)
+    if (ctx->compact || ctx->single_line)
         return;
 
-    putc('\n', ctx->stream);
+    size_t depth = ctx->index > 1 ? ctx->index - 1 : 0;
+    char *out = Reserve(ctx, depth + 1);
+
+    out[0] = '\n';
+    memset(out + 1, '\t', depth);
+    ctx->length += depth + 1;
+}
+
+/// Returns the length of the leading run of bytes that can be copied into a string literal as is.
+static size_t SafeRun(const char *string, size_t length) {
+    size_t offset = 0;
+
+#ifdef JSON_SSE2
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i control = _mm_set1_epi8(0x1F);
+
+    for (; offset + 16 <= length; offset += 16) {
+        __m128i data = _mm_loadu_si128((const __m128i *) (string + offset));
+        __m128i special = _mm_or_si128(
+                _mm_or_si128(_mm_cmpeq_epi8(data, quote), _mm_cmpeq_epi8(data, backslash)),
+                _mm_cmpeq_epi8(_mm_max_epu8(data, control), control));
+        unsigned mask = (unsigned) _mm_movemask_epi8(special);
 
-    for (size_t i = 1; i < ctx->index; i++) {
-        putc('\t', ctx->stream);
+        if (mask) {
+#ifdef _MSC_VER
+            unsigned long index;
+            _BitScanForward(&index, mask);
+            return offset + index;
+#else
+            return offset + (size_t) __builtin_ctz(mask);
+#endif
+        }
+    }
+#endif
+
+    for (; offset < length; offset++) {
+        unsigned char ch = (unsigned char) string[offset];
+        if (ch == '"' || ch == '\\' || ch < 0x20)
+            break;
+    }
+
+    return offset;
+}
+
+static void WriteEscape(struct JsonContext *ctx, unsigned char ch) {
+    static const char hex[] = "0123456789abcdef";
+
+    switch (ch) {
+        case '"':
+            Write(ctx, "\\\"", 2);
+            break;
+        case '\\':
+            Write(ctx, "\\\\", 2);
+            break;
+        case '\n':
+            Write(ctx, "\\n", 2);
+            break;
+        case '\r':
+            Write(ctx, "\\r", 2);
+            break;
+        case '\t':
+            Write(ctx, "\\t", 2);
+            break;
+        case '\b':
+            Write(ctx, "\\b", 2);
+            break;
+        case '\f':
+            Write(ctx, "\\f", 2);
+            break;
+        default: {
+            char escape[6] = {'\\', 'u', '0', '0', hex[ch >> 4], hex[ch & 15]};
+            Write(ctx, escape, sizeof(escape));
+            break;
+        }
     }
 }
 
 static void WriteString(struct JsonContext *ctx, const char *string) {
-    putc('"', ctx->stream);
-    for (size_t i = 0, len = strlen(string); i < len; i++) {
-        char ch = string[i];
-        if (ch == '"' || ch == '\\')
-            putc('\\', ctx->stream);
-        putc(ch, ctx->stream);
+    size_t length = strlen(string);
+
+    WriteChar(ctx, '"');
+
+    while (length) {
+        size_t run = SafeRun(string, length);
+
+        Write(ctx, string, run);
+        string += run;
+        length -= run;
+
+        if (length) {
+            WriteEscape(ctx, (unsigned char) *string);
+            string++;
+            length--;
+        }
     }
-    putc('"', ctx->stream);
+
+    WriteChar(ctx, '"');
 }
 
 static void ReplaceTop(struct JsonContext *ctx, enum JsonScope scope) {
@@ -48,7 +245,7 @@ static void BeforeName(struct JsonContext *ctx) {
     enum JsonScope scope = ctx->scopes[ctx->index - 1];
 
     if (scope == JsonScope_NonEmptyObject) {
-        fputs(ctx->compact ? ", " : ",", ctx->stream);
+        WriteLiteral(ctx, ctx->compact || ctx->single_line ? ", " : ",");
     } else if (scope != JsonScope_EmptyObject) {
         assert(0 && "Nesting problem");
     }
@@ -70,12 +267,12 @@ static void BeforeValue(struct JsonContext *ctx) {
             NewLine(ctx);
             break;
         case JsonScope_NonEmptyArray:
-            fputs(ctx->compact ? ", " : ",", ctx->stream);
+            WriteLiteral(ctx, ctx->compact || ctx->single_line ? ", " : ",");
             NewLine(ctx);
             break;
         case JsonScope_DanglingName:
             ReplaceTop(ctx, JsonScope_NonEmptyObject);
-            fputs(": ", ctx->stream);
+            Write(ctx, ": ", 2);
             break;
         default:
             assert(0 && "Nesting problem");
@@ -86,7 +283,7 @@ static void BeforeValue(struct JsonContext *ctx) {
 static void Open(struct JsonContext *ctx, enum JsonScope empty, int bracket) {
     BeforeValue(ctx);
     Push(ctx, empty);
-    putc(bracket, ctx->stream);
+    WriteChar(ctx, (char) bracket);
 }
 
 static void Close(struct JsonContext *ctx, enum JsonScope empty, enum JsonScope nonempty, int bracket) {
@@ -100,7 +297,7 @@ static void Close(struct JsonContext *ctx, enum JsonScope empty, enum JsonScope
     if (scope == nonempty)
         NewLine(ctx);
 
-    putc(bracket, ctx->stream);
+    WriteChar(ctx, (char) bracket);
 }
 
 static void WriteDeferredName(struct JsonContext *ctx) {
@@ -113,13 +310,62 @@ static void WriteDeferredName(struct JsonContext *ctx) {
 
 void JsonInit(struct JsonContext *ctx, FILE *stream) {
     ctx->stream = stream;
+    ctx->buffer = NULL;
+    ctx->length = 0;
+    ctx->capacity = 0;
     ctx->compact = 0;
+    ctx->single_line = 0;
     ctx->index = 0;
     ctx->name = NULL;
 
     Push(ctx, JsonScope_EmptyDocument);
 }
 
+void JsonFinish(struct JsonContext *ctx) {
+    Flush(ctx);
+    free(ctx->buffer);
+    ctx->buffer = NULL;
+    ctx->length = 0;
+    ctx->capacity = 0;
+}
+
+void JsonInitNested(struct JsonContext *ctx, const struct JsonContext *parent) {
+    assert(parent->name == NULL);
+    assert(parent->scopes[parent->index - 1] == JsonScope_NonEmptyObject
+           || parent->scopes[parent->index - 1] == JsonScope_NonEmptyArray);
+
+    *ctx = *parent;
+    ctx->stream = NULL;
+    ctx->buffer = NULL;
+    ctx->length = 0;
+    ctx->capacity = 0;
+}
+
+void JsonAppend(struct JsonContext *ctx, struct JsonContext *nested) {
+    assert(nested->index == ctx->index && nested->name == NULL);
+
+    // Big parts go to the stream as they are instead of through the buffer
+    if (ctx->stream && nested->length >= ctx->capacity - ctx->length) {
+        Flush(ctx);
+        fwrite(nested->buffer, 1, nested->length, ctx->stream);
+    } else if (nested->length) {
+        Write(ctx, nested->buffer, nested->length);
+    }
+
+    JsonFinish(nested);
+}
+
+void JsonFlush(struct JsonContext *ctx) {
+    Flush(ctx);
+}
+
+void JsonNextRecord(struct JsonContext *ctx) {
+    assert(ctx->index == 1 && ctx->scopes[0] == JsonScope_NonEmptyDocument);
+
+    WriteChar(ctx, '\n');
+    ReplaceTop(ctx, JsonScope_EmptyDocument);
+}
+
 void JsonBeginObject(struct JsonContext *ctx) {
     WriteDeferredName(ctx);
     Open(ctx, JsonScope_EmptyObject, '{');
@@ -142,6 +388,10 @@ void JsonCompact(struct JsonContext *ctx, int compact) {
     ctx->compact = compact;
 }
 
+void JsonSingleLine(struct JsonContext *ctx, int single_line) {
+    ctx->single_line = single_line;
+}
+
 void JsonName(struct JsonContext *ctx, const char *name) {
     assert(ctx->name == NULL);
     assert(ctx->index > 0);
@@ -158,10 +408,22 @@ void JsonValue(struct JsonContext *ctx, struct JsonValue value) {
             WriteString(ctx, value.string);
             break;
         case JsonType_Integer:
-            fprintf(ctx->stream, "%d", value.integer);
+            WriteInteger(ctx, value.integer);
+            break;
+        case JsonType_Unsigned:
+            WriteUnsigned(ctx, value.unsigned_integer);
             break;
         case JsonType_Bool:
-            fputs(value.integer ? "true" : "false", ctx->stream);
+            WriteLiteral(ctx, value.integer ? "true" : "false");
+            break;
+        case JsonType_Float:
+            WriteFloat(ctx, value.floating, 9);
+            break;
+        case JsonType_Double:
+            WriteFloat(ctx, value.floating, 17);
+            break;
+        case JsonType_Null:
+            WriteLiteral(ctx, "null");
             break;
     }
 }
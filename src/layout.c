@@ -0,0 +1,123 @@
+#include "layout.h"
+#include "arena.h"
+#include "memo.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define LAYOUT_MAX_DEPTH 4096 ///< Deeper base chains than this can only come from corrupt data
+
+static struct Memo g_layouts;
+
+static struct RTTICompound *BaseAt(struct RTTICompound *compound, int index) {
+    struct RTTICompound *base;
+    return RTTI_AsCompound(compound->mBases[index].mType, &base) ? base : NULL;
+}
+
+static const struct Layout *FindLayout(struct RTTICompound *compound) {
+    size_t layout;
+    return MemoFind(&g_layouts, compound, &layout) ? (const struct Layout *) layout : NULL;
+}
+
+/// Must only be called once the layouts of all bases are known.
+static const struct Layout *BuildLayout(struct RTTICompound *compound) {
+    size_t count = 0;
+
+    for (int i = 0; i < compound->mNumBases; i++) {
+        struct RTTICompound *base = BaseAt(compound, i);
+        if (base != NULL)
+            count += FindLayout(base)->num_fields;
+    }
+
+    for (int i = 0; i < compound->mNumAttrs; i++)
+        count += compound->mAttrs[i].type != NULL;
+
+    struct Layout *layout = SessionAlloc(sizeof(struct Layout) + count * sizeof(struct LayoutField), sizeof(void *));
+    struct LayoutField *field;
+
+    if (layout == NULL)
+        return NULL;
+
+    layout->num_fields = (uint32_t) count;
+    field = layout->fields;
+
+    for (int i = 0; i < compound->mNumBases; i++) {
+        struct RTTICompound *base = BaseAt(compound, i);
+        if (base == NULL)
+            continue;
+
+        const struct Layout *inherited = FindLayout(base);
+        for (uint32_t j = 0; j < inherited->num_fields; j++, field++) {
+            *field = inherited->fields[j];
+            field->offset += compound->mBases[i].mOffset;
+        }
+    }
+
+    for (int i = 0; i < compound->mNumAttrs; i++) {
+        if (compound->mAttrs[i].type != NULL)
+            *field++ = (struct LayoutField) {.attr = &compound->mAttrs[i], .owner = compound, .offset = compound->mAttrs[i].mOffset};
+    }
+
+    return layout;
+}
+
+/// Lays out the bases before the compounds deriving from them with an explicit stack.
+static const struct Layout *Build(struct RTTICompound *root) {
+    struct RTTICompound **stack = malloc(LAYOUT_MAX_DEPTH * sizeof(struct RTTICompound *));
+    _Bool failed = stack == NULL;
+    size_t depth = 0;
+
+    if (!failed)
+        stack[depth++] = root;
+
+    while (depth && !failed) {
+        struct RTTICompound *compound = stack[depth - 1];
+        _Bool ready = 1;
+
+        if (FindLayout(compound) != NULL) {
+            depth--;
+            continue;
+        }
+
+        for (int i = compound->mNumBases - 1; i >= 0 && !failed; i--) {
+            struct RTTICompound *base = BaseAt(compound, i);
+            if (base == NULL || FindLayout(base) != NULL)
+                continue;
+
+            failed = depth == LAYOUT_MAX_DEPTH;
+            if (!failed)
+                stack[depth++] = base;
+            ready = 0;
+        }
+
+        if (!ready || failed)
+            continue;
+
+        const struct Layout *layout = BuildLayout(compound);
+        failed = layout == NULL || !MemoInsert(&g_layouts, compound, (size_t) (uintptr_t) layout);
+        depth--;
+    }
+
+    free(stack);
+    return FindLayout(root);
+}
+
+const struct Layout *LayoutOf(struct RTTICompound *compound) {
+    const struct Layout *layout = FindLayout(compound);
+
+    if (layout != NULL)
+        return layout;
+
+    SpinLockAcquire(&g_layouts.lock);
+
+    if ((layout = FindLayout(compound)) == NULL)
+        layout = Build(compound);
+
+    SpinLockRelease(&g_layouts.lock);
+
+    return layout;
+}
+
+void LayoutReset(void) {
+    MemoReset(&g_layouts);
+}
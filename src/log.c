@@ -0,0 +1,352 @@
+#include "log.h"
+#include "thread.h"
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <string.h>
+
+#define LOG_LINE_LENGTH 1024
+
+enum LogArg {
+    LogArg_None,
+    LogArg_Signed,
+    LogArg_Unsigned,
+    LogArg_Char,
+    LogArg_Double,
+    LogArg_String,
+    LogArg_Pointer,
+};
+
+/// One conversion of a format string, rewritten for snprintf with integers widened to long long.
+struct LogSpec {
+    char text[32];
+    size_t length; ///< Characters of the format string it spans, the '%' included
+    enum LogArg arg;
+    char modifier; ///< 'H' for hh, 'L' for ll, else the modifier itself or 0
+};
+
+struct LogRecord {
+    volatile size_t sequence; ///< Position + 1 once written by a producer, position + LOG_RING_SIZE once free again
+    const char *format;
+    uint64_t args[LOG_MAX_ARGS];
+    int level;
+};
+
+struct Logger {
+    struct LogRecord records[LOG_RING_SIZE];
+    volatile size_t tail; ///< Next position claimed by a producer
+    volatile size_t written; ///< Positions written out to the stream so far
+    volatile size_t running;
+    size_t head; ///< Next position to write, only touched by the logger thread
+    FILE *stream;
+    struct Thread thread;
+};
+
+static struct Logger g_logger;
+
+static _Bool ParseSpec(const char *format, struct LogSpec *spec) {
+    const char *start = format;
+    size_t length = 0;
+
+    memset(spec, 0, sizeof(*spec));
+    spec->text[length++] = *format++;
+
+    if (*format == '%') {
+        spec->text[length++] = '%';
+        spec->length = 2;
+        return 1;
+    }
+
+    while (*format && strchr("-+ #0", *format) && length < 8)
+        spec->text[length++] = *format++;
+    while (*format >= '0' && *format <= '9' && length < 12)
+        spec->text[length++] = *format++;
+    if (*format == '.') {
+        spec->text[length++] = *format++;
+        while (*format >= '0' && *format <= '9' && length < 16)
+            spec->text[length++] = *format++;
+    }
+
+    if (format[0] == 'h' && format[1] == 'h') {
+        spec->modifier = 'H';
+        format += 2;
+    } else if (format[0] == 'l' && format[1] == 'l') {
+        spec->modifier = 'L';
+        format += 2;
+    } else if (*format && strchr("hlzjt", *format)) {
+        spec->modifier = *format++;
+    }
+
+    switch (*format) {
+        case 'd':
+        case 'i':
+            spec->arg = LogArg_Signed;
+            break;
+        case 'u':
+        case 'x':
+        case 'X':
+        case 'o':
+            spec->arg = LogArg_Unsigned;
+            break;
+        case 'c':
+            spec->arg = LogArg_Char;
+            break;
+        case 'f':
+        case 'e':
+        case 'g':
+            spec->arg = LogArg_Double;
+            break;
+        case 's':
+            spec->arg = LogArg_String;
+            break;
+        case 'p':
+            spec->arg = LogArg_Pointer;
+            break;
+        default:
+            return 0;
+    }
+
+    if (spec->arg == LogArg_Signed || spec->arg == LogArg_Unsigned) {
+        spec->text[length++] = 'l';
+        spec->text[length++] = 'l';
+    }
+
+    spec->text[length++] = *format++;
+    spec->length = (size_t) (format - start);
+    return 1;
+}
+
+static uint64_t ReadArg(const struct LogSpec *spec, va_list *args) {
+    const char *string;
+    void *pointer;
+    double real;
+    uint64_t value = 0;
+
+    switch (spec->arg) {
+        case LogArg_Signed:
+            switch (spec->modifier) {
+                case 'H':
+                    return (uint64_t) (int64_t) (signed char) va_arg(*args, int);
+                case 'h':
+                    return (uint64_t) (int64_t) (short) va_arg(*args, int);
+                case 'l':
+                    return (uint64_t) (int64_t) va_arg(*args, long);
+                case 'L':
+                    return (uint64_t) va_arg(*args, long long);
+                case 'z':
+                case 't':
+                    return (uint64_t) (int64_t) va_arg(*args, ptrdiff_t);
+                case 'j':
+                    return (uint64_t) va_arg(*args, intmax_t);
+                default:
+                    return (uint64_t) (int64_t) va_arg(*args, int);
+            }
+        case LogArg_Unsigned:
+            switch (spec->modifier) {
+                case 'H':
+                    return (unsigned char) va_arg(*args, unsigned);
+                case 'h':
+                    return (unsigned short) va_arg(*args, unsigned);
+                case 'l':
+                    return va_arg(*args, unsigned long);
+                case 'L':
+                    return va_arg(*args, unsigned long long);
+                case 'z':
+                case 't':
+                    return va_arg(*args, size_t);
+                case 'j':
+                    return va_arg(*args, uintmax_t);
+                default:
+                    return va_arg(*args, unsigned);
+            }
+        case LogArg_Char:
+            return (uint64_t) va_arg(*args, int);
+        case LogArg_Double:
+            real = va_arg(*args, double);
+            memcpy(&value, &real, sizeof(real));
+            return value;
+        case LogArg_String:
+            string = va_arg(*args, const char *);
+            return (uint64_t) (uintptr_t) string;
+        case LogArg_Pointer:
+            pointer = va_arg(*args, void *);
+            return (uint64_t) (uintptr_t) pointer;
+        default:
+            return 0;
+    }
+}
+
+static size_t FormatRecord(char *line, const struct LogRecord *record) {
+    const char *format = record->format;
+    size_t length = 0;
+    size_t index = 0;
+
+    if (record->level == LOG_LEVEL_ERROR)
+        length = (size_t) snprintf(line, LOG_LINE_LENGTH, "error: ");
+    else if (record->level == LOG_LEVEL_WARNING)
+        length = (size_t) snprintf(line, LOG_LINE_LENGTH, "warning: ");
+
+    while (*format && length < LOG_LINE_LENGTH - 1) {
+        const char *percent = strchr(format, '%');
+        size_t literal = percent ? (size_t) (percent - format) : strlen(format);
+        struct LogSpec spec;
+        int written = 0;
+
+        if (literal > LOG_LINE_LENGTH - 1 - length)
+            literal = LOG_LINE_LENGTH - 1 - length;
+        memcpy(line + length, format, literal);
+        length += literal;
+        format += literal;
+
+        if (percent == NULL || length >= LOG_LINE_LENGTH - 1)
+            break;
+
+        if (!ParseSpec(format, &spec) || (spec.arg != LogArg_None && index == LOG_MAX_ARGS))
+            break;
+
+        uint64_t value = spec.arg != LogArg_None ? record->args[index++] : 0;
+        char *position = line + length;
+        size_t left = LOG_LINE_LENGTH - length;
+        double real;
+
+        switch (spec.arg) {
+            case LogArg_None:
+                written = snprintf(position, left, "%%");
+                break;
+            case LogArg_Signed:
+                written = snprintf(position, left, spec.text, (long long) value);
+                break;
+            case LogArg_Unsigned:
+                written = snprintf(position, left, spec.text, (unsigned long long) value);
+                break;
+            case LogArg_Char:
+                written = snprintf(position, left, spec.text, (int) value);
+                break;
+            case LogArg_Double:
+                memcpy(&real, &value, sizeof(real));
+                written = snprintf(position, left, spec.text, real);
+                break;
+            case LogArg_String:
+                written = snprintf(position, left, spec.text, value ? (const char *) (uintptr_t) value : "(null)");
+                break;
+            case LogArg_Pointer:
+                written = snprintf(position, left, spec.text, (void *) (uintptr_t) value);
+                break;
+        }
+
+        if (written > 0)
+            length += (size_t) written < left ? (size_t) written : left - 1;
+        format += spec.length;
+    }
+
+    return length;
+}
+
+static void WriteRecord(FILE *stream, const struct LogRecord *record) {
+    char line[LOG_LINE_LENGTH];
+    size_t length = FormatRecord(line, record);
+
+    fwrite(line, 1, length, stream);
+}
+
+static void LogMain(void *argument) {
+    (void) argument;
+
+    for (;;) {
+        // Checked before the ring, a stopped logger has seen every record published before the stop
+        size_t running = AtomicLoad(&g_logger.running);
+        struct LogRecord *record = &g_logger.records[g_logger.head & (LOG_RING_SIZE - 1)];
+
+        if (AtomicLoad(&record->sequence) == g_logger.head + 1) {
+            WriteRecord(g_logger.stream, record);
+            AtomicStore(&record->sequence, g_logger.head + LOG_RING_SIZE);
+            g_logger.head++;
+            continue;
+        }
+
+        fflush(g_logger.stream);
+        AtomicStore(&g_logger.written, g_logger.head);
+
+        if (!running)
+            break;
+
+        ThreadSleep(1);
+    }
+}
+
+_Bool LogStart(FILE *stream) {
+    if (AtomicLoad(&g_logger.running))
+        return 1;
+
+    for (size_t i = 0; i < LOG_RING_SIZE; i++)
+        g_logger.records[i].sequence = i;
+
+    g_logger.tail = 0;
+    g_logger.written = 0;
+    g_logger.head = 0;
+    g_logger.stream = stream;
+    AtomicStore(&g_logger.running, 1);
+
+    if (!ThreadStart(&g_logger.thread, LogMain, NULL)) {
+        AtomicStore(&g_logger.running, 0);
+        return 0;
+    }
+
+    return 1;
+}
+
+void LogFlush(void) {
+    if (!AtomicLoad(&g_logger.running)) {
+        fflush(stdout);
+        return;
+    }
+
+    size_t target = AtomicLoad(&g_logger.tail);
+    while (AtomicLoad(&g_logger.written) < target)
+        ThreadSleep(1);
+}
+
+void LogStop(void) {
+    if (!AtomicLoad(&g_logger.running))
+        return;
+
+    AtomicStore(&g_logger.running, 0);
+    ThreadJoin(&g_logger.thread);
+}
+
+void LogWrite(int level, const char *format, ...) {
+    struct LogRecord local;
+    struct LogRecord *record = &local;
+    _Bool running = AtomicLoad(&g_logger.running) != 0;
+    size_t position = 0;
+    size_t count = 0;
+    va_list args;
+
+    if (running) {
+        // Waits for the logger thread to free the slot when the ring is full
+        position = AtomicFetchAdd(&g_logger.tail, 1);
+        record = &g_logger.records[position & (LOG_RING_SIZE - 1)];
+        while (AtomicLoad(&record->sequence) != position)
+            ThreadSleep(0);
+    }
+
+    record->format = format;
+    record->level = level;
+
+    va_start(args, format);
+    for (const char *percent = strchr(format, '%'); percent && count < LOG_MAX_ARGS; percent = strchr(percent, '%')) {
+        struct LogSpec spec;
+
+        if (!ParseSpec(percent, &spec))
+            break;
+        if (spec.arg != LogArg_None)
+            record->args[count++] = ReadArg(&spec, &args);
+        percent += spec.length;
+    }
+    va_end(args);
+
+    if (running)
+        AtomicStore(&record->sequence, position + 1);
+    else
+        WriteRecord(stdout, record);
+}
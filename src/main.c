@@ -5,6 +5,20 @@
 #include "rtti.h"
 #include "json.h"
 #include "scan.h"
+#include "pe.h"
+#include "cache.h"
+#include "typedb.h"
+#include "traverse.h"
+#include "arena.h"
+#include "sort.h"
+#include "log.h"
+#include "stats.h"
+#include "export.h"
+#include "diff.h"
+#include "typehash.h"
+#include "registry.h"
+#include "layout.h"
+#include "plan.h"
 
 #include <Windows.h>
 #include <stdio.h>
@@ -16,6 +30,9 @@
 #include <detours.h>
 #include <stdlib.h>
 
+// In-process tools look types up through the DLL, see registry.h
+#pragma comment(linker, "/export:RTTI_FindByName")
+
 static uint64_t RTTI_Hash(const void *item, uint64_t seed0, uint64_t seed1) {
     const char *name = RTTI_Name(*(struct RTTI **) item);
     return hashmap_sip(name, strlen(name), seed0, seed1);
@@ -26,75 +43,172 @@ static int RTTI_Compare(const void *a, const void *b, void *data) {
     return strcmp(RTTI_Name(*(struct RTTI **) a), RTTI_Name(*(struct RTTI **) b));
 }
 
-static int RTTIKind_Order(struct RTTI *rtti) {
-    switch (rtti->kind) {
-        case RTTIKind_Compound:
-            return 0;
-        case RTTIKind_Enum:
-            return 1;
-        case RTTIKind_EnumFlags:
-            return 2;
-        case RTTIKind_Atom:
-            return 3;
-        default:
-            return 4;
-    }
-}
-
-static int RTTIKind_CompareLexical(const void *a, const void *b) {
-    struct RTTI *a_rtti = *(struct RTTI **) a;
-    struct RTTI *b_rtti = *(struct RTTI **) b;
-
-    int order_a = RTTIKind_Order(a_rtti);
-    int order_b = RTTIKind_Order(b_rtti);
+static void OnTypeFound(struct RTTI *, void *);
 
-    if (order_a != order_b)
-        return order_a - order_b;
+static void CountTypes(struct RTTI **types, size_t count);
 
-    return strcmp(RTTI_Name(a_rtti), RTTI_Name(b_rtti));
-}
+static void WriteDelta(void);
 
-static void ScanType(struct RTTI *, struct hashmap *);
+static struct Traversal g_all_types;
 
-static void ExportTypes(FILE *file, struct RTTI **types, size_t count);
+static struct hashmap *g_types_by_name;
 
-static void ExportIda(FILE *file, struct RTTI **types, size_t count);
+static struct JsonContext g_stream;
 
-static struct hashmap *g_all_types;
+static struct PeImage g_image;
 
 static void (*RTTIFactory_RegisterAllTypes)();
 
 static char (*RTTIFactory_RegisterType)(void *, struct RTTI *);
 
 static char RTTIFactory_RegisterType_Hook(void *a1, struct RTTI *type) {
-    printf("RTTIFactory::RegisterType: '%s' (kind: %s, pointer: %p)\n", RTTI_Name(type), RTTIKind_Name(type->kind), type);
-    ScanType(type, g_all_types);
+    LogDebug("RTTIFactory::RegisterType: '%s' (kind: %s, pointer: %p)\n", RTTI_Name(type), RTTIKind_Name(type->kind), type);
+    struct StatsTimer timer = StatsBegin("traverse");
+    if (!g_all_types.failed && !TraversalAdd(&g_all_types, type))
+        LogError("Out of memory walking the RTTI graph at '%s', no dumps will be written\n", RTTI_Name(type));
+    StatsEnd(timer);
     return RTTIFactory_RegisterType(a1, type);
 }
 
 static void RTTIFactory_RegisterAllTypes_Hook() {
     RTTIFactory_RegisterAllTypes();
 
-    size_t count = hashmap_count(g_all_types);
+    if (g_stream.stream) {
+        JsonFinish(&g_stream);
+        fclose(g_stream.stream);
+        g_stream.stream = NULL;
+    }
+
+    // A partial graph would be written out as if types had been removed from the game
+    if (g_all_types.failed) {
+        LogStop();
+        return;
+    }
+
+    // Distinct objects may share a name, the first one discovered represents it in the dumps
+    struct StatsTimer timer = StatsBegin("dedupe");
+    struct TypeSet *visited = &g_all_types.visited;
+    g_types_by_name = hashmap_new_with_allocator(SessionMalloc, SessionRealloc, SessionFree, sizeof(struct RTTI *), visited->count,
+                                                 0, 0, RTTI_Hash, RTTI_Compare, NULL, NULL);
+
+    for (size_t index = 0; index < visited->count; index++) {
+        if (hashmap_get(g_types_by_name, &visited->items[index]) == NULL)
+            hashmap_set(g_types_by_name, &visited->items[index]);
+    }
+
+    size_t count = hashmap_count(g_types_by_name);
     struct RTTI **item;
-    struct RTTI **sorted = calloc(count, sizeof(struct RTTI *));
+    struct RTTI **sorted = SessionAlloc(count * sizeof(struct RTTI *), sizeof(struct RTTI *));
 
-    for (size_t cur = 0, idx = 0; hashmap_iter(g_all_types, &idx, (void *) &item); cur++)
+    LogInfo("Found %zu types (%zu unique names)\n", visited->count, count);
+
+    for (size_t cur = 0, idx = 0; hashmap_iter(g_types_by_name, &idx, (void *) &item); cur++)
         sorted[cur] = *item;
 
-    qsort(sorted, count, sizeof(struct RTTI *), RTTIKind_CompareLexical);
+    StatsEnd(timer);
+    CountTypes(sorted, count);
+
+    // Same order either way, the dumps of an unchanged game stay byte-identical
+    timer = StatsBegin("sort");
+    if (!SortTypes(sorted, count)) {
+        LogWarning("Unable to allocate the sort keys, sorting %zu types with qsort\n", count);
+        qsort(sorted, count, sizeof(*sorted), RTTIKind_CompareLexical);
+    }
+    StatsEnd(timer);
+
+    timer = StatsBegin("registry");
+    if (!RegistryBuild(sorted, count))
+        LogWarning("Unable to build the name registry, RTTI_FindByName finds nothing\n");
+    StatsEnd(timer);
 
     FILE *file;
 
-    fopen_s(&file, "hfw_types.json", "w");
-    ExportTypes(file, sorted, count);
-    fclose(file);
+    // Written next to the current dump first, a failed write leaves both earlier dumps as they were
+    timer = StatsBegin("export_typedb");
+    _Bool written = fopen_s(&file, "hfw_types.new.bin", "wb") == 0;
+    if (written) {
+        written = TypeDbWrite(file, sorted, count) && !ferror(file);
+        StatsSet("bytes.hfw_types.bin", (uint64_t) ftell(file));
+        written = fclose(file) == 0 && written;
+    }
+    StatsEnd(timer);
+
+    // The previous dump is kept around, the delta against it is what needs reviewing after a patch
+    _Bool has_previous = 0;
+    if (written) {
+        remove("hfw_types.prev.bin");
+        has_previous = rename("hfw_types.bin", "hfw_types.prev.bin") == 0;
+        written = rename("hfw_types.new.bin", "hfw_types.bin") == 0;
+
+        // The new dump could not take its place, the previous one goes back to where it was
+        if (!written && has_previous && rename("hfw_types.prev.bin", "hfw_types.bin") != 0)
+            LogError("Unable to move hfw_types.prev.bin back, the previous dump is left there\n");
+    }
+
+    if (!written) {
+        LogError("Unable to write hfw_types.bin, the new dump is discarded\n");
+        remove("hfw_types.new.bin");
+    } else if (has_previous) {
+        WriteDelta();
+    }
+
+    timer = StatsBegin("export_ida");
+    if (fopen_s(&file, "hfw_ggrtti.idc", "w") == 0) {
+        if (getenv("DECIMA_IDC_VERBOSE"))
+            ExportIda(file, sorted, count);
+        else
+            ExportIdaCompact(file, sorted, count, (uintptr_t) g_image.data, g_image.size);
+        StatsSet("bytes.hfw_ggrtti.idc", (uint64_t) ftell(file));
+        fclose(file);
+    } else {
+        LogError("Unable to open hfw_ggrtti.idc for writing\n");
+    }
+    StatsEnd(timer);
+
+    // Inherited attrs at absolute offsets, for consumers that would otherwise walk the bases themselves
+    if (getenv("DECIMA_LAYOUTS") && fopen_s(&file, "hfw_layouts.json", "w") == 0) {
+        ExportLayouts(file, sorted, count);
+        StatsSet("bytes.hfw_layouts.json", (uint64_t) ftell(file));
+        fclose(file);
+    }
+
+    // The JSON goes last, its $stats covers everything before it.
+    // Every core by default, DECIMA_EXPORT_THREADS=1 writes it on this thread alone
+    const char *threads = getenv("DECIMA_EXPORT_THREADS");
+    if (fopen_s(&file, "hfw_types.json", "w") == 0) {
+        ExportTypes(file, sorted, count, threads ? (unsigned) strtoul(threads, NULL, 10) : 0);
+        fclose(file);
+    } else {
+        LogError("Unable to open hfw_types.json for writing\n");
+    }
+
+    if (getenv("DECIMA_TRACE") && fopen_s(&file, "hfw_trace.json", "w") == 0) {
+        StatsWriteTrace(file);
+        fclose(file);
+    }
+
+#if DECIMA_LOG_LEVEL >= LOG_LEVEL_INFO
+    struct ArenaStats stats = SessionStats();
+    LogInfo("Session: %zu bytes allocated in %zu blocks, peak %zu bytes reserved\n", stats.total, stats.num_blocks, stats.peak);
+#endif
+
+    // The game keeps running with the registry alive, for tools that look types up in-process
+    if (getenv("DECIMA_RESIDENT")) {
+        LogInfo("Staying resident, types can be looked up with RTTI_FindByName\n");
+        return;
+    }
 
-    fopen_s(&file, "hfw_ggrtti.idc", "w");
-    ExportIda(file, sorted, count);
-    fclose(file);
+    // Queued messages may point at names that live in the session
+    LogStop();
 
-    free(sorted);
+    g_types_by_name = NULL;
+    RegistryReset();
+    RTTI_ResetDisplayNames();
+    RTTI_ResetEnumTables();
+    TypeHashReset();
+    LayoutReset();
+    PlanReset();
+    SessionReset();
 
     ExitProcess(0);
 }
@@ -117,28 +231,64 @@ _Bool APIENTRY DllMain(HINSTANCE handle, DWORD reason, LPVOID reserved) {
         AttachConsole(ATTACH_PARENT_PROCESS);
         freopen("CON", "w", stdout);
 
-        struct Section section;
-        if (!FindSection(GetModuleHandleA(NULL), ".text", &section)) {
-            perror("Unable to find '.text' section in the executable");
+        if (!PeAttach(GetModuleHandleA(NULL), &g_image)) {
+            perror("Unable to parse the headers of the executable");
             return FALSE;
         }
 
-        if (!FindPattern(section.start, section.end, "40 55 48 8B EC 48 83 EC 70 80 3D ? ? ? ? ? 0F 85 ? ? ? ? 48 89 9C 24",
-                         (void **) &RTTIFactory_RegisterAllTypes)) {
-            perror("Unable to find 'RTTIFactory::RegisterAllTypes' function in the executable");
+        struct Signature signatures[] = {
+                {.name = "RTTIFactory::RegisterAllTypes", .pattern = "40 55 48 8B EC 48 83 EC 70 80 3D ? ? ? ? ? 0F 85 ? ? ? ? 48 89 9C 24"},
+                {.name = "RTTIFactory::RegisterType", .pattern = "40 55 53 56 48 8D 6C 24 ? 48 81 EC ? ? ? ? 0F B6 42 05 48 8B DA 48 8B"},
+        };
+
+        _Bool cached;
+        struct StatsTimer timer = StatsBegin("resolve_signatures");
+        if (!ResolveSignatures("decima_native.cache", &g_image, ".text", signatures, sizeof(signatures) / sizeof(*signatures), &cached)) {
+            perror("Unable to scan '.text' section of the executable");
             return FALSE;
         }
+        StatsEnd(timer);
+        StatsSet("signatures_cached", cached);
 
-        if (!FindPattern(section.start, section.end, "40 55 53 56 48 8D 6C 24 ? 48 81 EC ? ? ? ? 0F B6 42 05 48 8B DA 48 8B",
-                         (void **) &RTTIFactory_RegisterType)) {
-            perror("Unable to find 'RTTIFactory::RegisterType' function in the executable");
-            return FALSE;
+        if (cached)
+            LogInfo("Resolved signatures from cache\n");
+
+        for (size_t index = 0; index < sizeof(signatures) / sizeof(*signatures); index++) {
+            struct Signature *signature = &signatures[index];
+
+            if (signature->count == 0) {
+                LogError("Unable to find '%s' function in the executable\n", signature->name);
+                return FALSE;
+            }
+
+            if (signature->count > 1) {
+                LogError("Signature of '%s' is ambiguous, found %zu matches:\n", signature->name, signature->count);
+                for (size_t i = 0; i < signature->count && i < SIGNATURE_MAX_MATCHES; i++)
+                    LogError("  %p\n", signature->matches[i]);
+                return FALSE;
+            }
         }
 
-        printf("Found RTTIFactory::RegisterAllTypes at %p\n", RTTIFactory_RegisterAllTypes);
-        printf("Found RTTIFactory::RegisterType at %p\n", RTTIFactory_RegisterType);
+        RTTIFactory_RegisterAllTypes = signatures[0].matches[0];
+        RTTIFactory_RegisterType = signatures[1].matches[0];
 
-        g_all_types = hashmap_new(sizeof(struct RTTI *), 0, 0, 0, RTTI_Hash, RTTI_Compare, NULL, NULL);
+        LogInfo("Found RTTIFactory::RegisterAllTypes at %p\n", RTTIFactory_RegisterAllTypes);
+        LogInfo("Found RTTIFactory::RegisterType at %p\n", RTTIFactory_RegisterType);
+
+        // Streams every type as soon as it is discovered, the sorted hfw_types.json is still written at the end
+        if (getenv("DECIMA_STREAM")) {
+            FILE *file;
+            if (fopen_s(&file, "hfw_types.ndjson", "w") == 0) {
+                JsonInit(&g_stream, file);
+                JsonSingleLine(&g_stream, 1);
+            }
+        }
+
+        if (!TraversalInit(&g_all_types, 1 << 16, OnTypeFound, NULL))
+            LogError("Unable to allocate the RTTI graph walk, no dumps will be written\n");
+
+        // Everything the hooks log is formatted on a background thread, away from type registration
+        LogStart(stdout);
 
         DetourTransactionBegin();
         DetourUpdateThread(GetCurrentThread());
@@ -152,261 +302,76 @@ _Bool APIENTRY DllMain(HINSTANCE handle, DWORD reason, LPVOID reserved) {
         DetourDetach((PVOID *) &RTTIFactory_RegisterType, RTTIFactory_RegisterType_Hook);
         DetourTransactionCommit();
 
-        hashmap_free(g_all_types);
+        TraversalFree(&g_all_types);
+        g_types_by_name = NULL;
+        RegistryReset();
+        RTTI_ResetDisplayNames();
+        RTTI_ResetEnumTables();
+        TypeHashReset();
+        LayoutReset();
+        PlanReset();
+        SessionReset();
     }
 
     return TRUE;
 }
 
-static void ScanType(struct RTTI *rtti, struct hashmap *registered) {
-    union {
-        struct RTTIContainer *container;
-        struct RTTIPointer *pointer;
-        struct RTTIAtom *atom;
-        struct RTTICompound *compound;
-    } object;
+static void OnTypeFound(struct RTTI *rtti, void *context) {
+    (void) context;
 
-    if (rtti == NULL || hashmap_get(registered, &rtti) != NULL)
-        return;
+    LogDebug("Found mType '%s' (kind: %s, pointer: %p)\n", RTTI_Name(rtti), RTTIKind_Name(rtti->kind), rtti);
 
-    hashmap_set(registered, &rtti);
-
-    printf("Found mType '%s' (kind: %s, pointer: %p)\n", RTTI_Name(rtti), RTTIKind_Name(rtti->kind), rtti);
-
-    if (RTTI_AsContainer(rtti, &object.container))
-        ScanType(object.container->mItemType, registered);
-    if (RTTI_AsPointer(rtti, &object.pointer))
-        ScanType(object.pointer->mItemType, registered);
-    else if (RTTI_AsAtom(rtti, &object.atom))
-        ScanType(object.atom->mBaseType, registered);
-    else if (RTTI_AsCompound(rtti, &object.compound)) {
-        for (int index = 0; index < object.compound->mNumBases; index++)
-            ScanType(object.compound->mBases[index].mType, registered);
-        for (int index = 0; index < object.compound->mNumAttrs; index++)
-            ScanType(object.compound->mAttrs[index].type, registered);
-        for (int index = 0; index < object.compound->mNumMessageHandlers; index++)
-            ScanType(object.compound->mMessageHandlers[index].mMessage, registered);
-    }
+    if (g_stream.stream)
+        StreamType(&g_stream, rtti);
 }
 
-static void ExportType(struct JsonContext *ctx, struct RTTI *rtti) {
-    struct RTTICompound *rtti_class;
-    struct RTTIEnum *rtti_enum;
-    struct RTTIAtom *rtti_Atom;
-
-    if (rtti->kind == RTTIKind_Pointer || rtti->kind == RTTIKind_Container || rtti->kind == RTTIKind_POD)
-        return;
-
-    JsonNameObject(ctx, RTTI_DisplayName(rtti));
-    JsonNameValueStr(ctx, "kind", RTTIKind_Name(rtti->kind));
-
-    if (RTTI_AsCompound(rtti, &rtti_class)) {
-        JsonNameValueNum(ctx, "mVersion", rtti_class->mVersion);
-        JsonNameValueNum(ctx, "mFlags", rtti_class->mFlags);
-
-        if (rtti_class->mNumMessageHandlers) {
-            JsonNameArray(ctx, "messages");
-
-            printf("mMessageHandlers (pointer: %p, count: %d)\n", rtti_class->mMessageHandlers,
-                   rtti_class->mNumMessageHandlers);
-            for (int i = 0; i < rtti_class->mNumMessageHandlers; i++) {
-                struct RTTIMessageHandler *handler = &rtti_class->mMessageHandlers[i];
-                printf("  message_handler %d: %p '%s'\n", i, handler->mMessage, RTTI_Name(handler->mMessage));
-                JsonValueStr(ctx, RTTI_DisplayName(handler->mMessage));
-            }
-
-            JsonEndArray(ctx);
-        }
-
-        if (rtti_class->mNumBases) {
-            JsonNameArray(ctx, "mBases");
-
-            printf("mBases (pointer: %p, count: %d)\n", rtti_class->mBases, rtti_class->mNumBases);
-            for (int i = 0; i < rtti_class->mNumBases; i++) {
-                struct RTTIBase *base = &rtti_class->mBases[i];
-                printf("  base %d: %p '%s'\n", i, base->mType, RTTI_Name(base->mType));
-                JsonBeginCompactObject(ctx);
-                JsonNameValueStr(ctx, "mTypeName", RTTI_DisplayName(base->mType));
-                JsonNameValueNum(ctx, "mOffset", base->mOffset);
-                JsonEndCompactObject(ctx);
-            }
-
-            JsonEndArray(ctx);
-        }
-
-        if (rtti_class->mNumAttrs) {
-            JsonNameArray(ctx, "mAttrs");
-
-            printf("mAttrs (pointer: %p, count: %d)\n", rtti_class->mAttrs, rtti_class->mNumAttrs);
-            for (int i = 0; i < rtti_class->mNumAttrs; i++) {
-                struct RTTIAttr *attr = &rtti_class->mAttrs[i];
-
-                if (attr->type == NULL) {
-                    JsonBeginCompactObject(ctx);
-                    JsonNameValueStr(ctx, "category", attr->mName);
-                    JsonEndCompactObject(ctx);
-                    continue;
-                }
-
-                printf("  attr %d: %p %s ('%s')\n", i, attr->type, attr->mName, RTTI_Name(attr->type));
-                JsonBeginCompactObject(ctx);
-                JsonNameValueStr(ctx, "mTypeName", attr->mName);
-                JsonNameValueStr(ctx, "mType", RTTI_DisplayName(attr->type));
-                JsonNameValueNum(ctx, "mOffset", attr->mOffset);
-                JsonNameValueNum(ctx, "mFlags", attr->mFlags);
-                if (attr->mMinValue)
-                    JsonNameValueStr(ctx, "min", attr->mMinValue);
-                if (attr->mMaxValue)
-                    JsonNameValueStr(ctx, "max", attr->mMaxValue);
-                if (attr->mGetter || attr->mSetter)
-                    JsonNameValueBool(ctx, "property", 1);
-                JsonEndCompactObject(ctx);
-            }
-
-            JsonEndArray(ctx);
-        }
-    } else if (RTTI_AsEnum(rtti, &rtti_enum)) {
-        JsonNameValueNum(ctx, "mSize", rtti_enum->size);
-        JsonNameArray(ctx, "values");
-
-        for (int i = 0; i < rtti_enum->num_values; i++) {
-            struct RTTIValue *m = &rtti_enum->values[i];
-
-            JsonBeginCompactObject(ctx);
-            JsonNameValueNum(ctx, "mValue", m->mValue);
-            JsonNameValueStr(ctx, "mTypeName", m->mName);
-
-            if (m->mAliases[0]) {
-                JsonNameCompactArray(ctx, "alias");
-                for (size_t j = 0; j < 4 && m->mAliases[j]; j++)
-                    JsonValueStr(ctx, m->mAliases[j]);
-                JsonEndArray(ctx);
-            }
-
-            JsonEndCompactObject(ctx);
-        }
-
-        JsonEndArray(ctx);
-    } else if (RTTI_AsAtom(rtti, &rtti_Atom)) {
-        JsonNameValueStr(ctx, "mBaseType", RTTI_DisplayName(rtti_Atom->mBaseType));
-    }
-
-    JsonEndObject(ctx);
-}
-
-void ExportTypes(FILE *file, struct RTTI **types, size_t count) {
-    struct JsonContext ctx;
-    JsonInit(&ctx, file);
-    JsonBeginObject(&ctx);
-
-    JsonNameCompactObject(&ctx, "$spec");
-    JsonNameValueStr(&ctx, "mVersion", "5.0");
-    JsonEndCompactObject(&ctx);
+static void CountTypes(struct RTTI **types, size_t count) {
+    static const char *counters[] = {"atoms", "pointers", "containers", "enums", "compounds", "enum_flags", "pods", "enum_bitsets"};
+    uint64_t kinds[sizeof(counters) / sizeof(*counters)] = {0};
+    struct ArenaStats session = SessionStats();
 
     for (size_t index = 0; index < count; index++) {
-        ExportType(&ctx, types[index]);
+        if (types[index]->kind < sizeof(counters) / sizeof(*counters))
+            kinds[types[index]->kind]++;
     }
 
-    JsonEndObject(&ctx);
-}
+    for (size_t kind = 0; kind < sizeof(counters) / sizeof(*counters); kind++)
+        StatsSet(counters[kind], kinds[kind]);
 
-static const char *RTTIKind_IDAName(enum RTTIKind kind) {
-    switch (kind) {
-        case RTTIKind_Atom:
-            return "RTTIAtom";
-        case RTTIKind_Pointer:
-            return "RTTIPointer";
-        case RTTIKind_Container:
-            return "RTTIContainer";
-        case RTTIKind_Enum:
-        case RTTIKind_EnumFlags:
-            return "RTTIEnum";
-        case RTTIKind_Compound:
-            return "RTTICompound";
-        case RTTIKind_POD:
-            return "RTTIPod";
-        default:
-            assert(0 && "Unexpected RTTIKind");
-            return NULL;
-    }
+    StatsSet("types_visited", g_all_types.visited.count);
+    StatsSet("types_unique", count);
+    StatsSet("typeset_probes", g_all_types.visited.probes);
+    StatsSet("session_bytes", session.total);
+    StatsSet("session_peak", session.peak);
 }
 
-void ExportIda(FILE *file, struct RTTI **types, size_t count) {
-    fputs("#include <idc.idc>\n\nstatic main()\n{", file);
+static void WriteDelta(void) {
+    struct StatsTimer timer = StatsBegin("diff");
+    struct TypeDb previous, current;
+    struct DiffSummary summary;
+    FILE *file;
 
-    struct RTTICompound *type_compound;
-    struct RTTIEnum *type_enum;
-    struct RTTIContainer *type_container;
-    struct RTTIPointer *type_pointer;
+    if (!TypeDbOpen("hfw_types.prev.bin", &previous)) {
+        LogWarning("Previous dump is unreadable or from an older version, no delta is written\n");
+        StatsEnd(timer);
+        return;
+    }
 
-    for (size_t index = 0; index < count; index++) {
-        struct RTTI *type = types[index];
-        fprintf(file, "\n\t// %s %s\n", RTTIKind_Name(type->kind), RTTI_Name(type));
-        fprintf(file, "\tset_name(0x%p, \"RTTI_%s\");\n", type, RTTI_Name(type));
-        fprintf(file, "\tapply_type(0x%p, \"%s\");\n", type, RTTIKind_IDAName(type->kind));
-
-        if (RTTI_AsCompound(type, &type_compound)) {
-            struct RTTIBase *bases = type_compound->mBases;
-            if (bases) {
-                uint8_t bases_count = type_compound->mNumBases;
-                fprintf(file, "\tdel_items(0x%p, DELIT_SIMPLE, %zu);\n", bases, bases_count * sizeof(struct RTTIBase));
-                fprintf(file, "\tapply_type(0x%p, \"RTTIBase[%d]\");\n", bases, bases_count);
-                fprintf(file, "\tset_name(0x%p, \"%s::sBases\");\n", bases, RTTI_Name(type));
-            }
-            struct RTTIAttr *attrs = type_compound->mAttrs;
-            if (attrs) {
-                uint8_t attrs_count = type_compound->mNumAttrs;
-                fprintf(file, "\tdel_items(0x%p, DELIT_SIMPLE, %zu);\n", attrs, attrs_count * sizeof(struct RTTIAttr));
-                fprintf(file, "\tset_name(0x%p, \"%s::sAttrs\");\n", attrs, RTTI_Name(type));
-                fprintf(file, "\tapply_type(0x%p, \"RTTIAttr[%d]\");\n", attrs, attrs_count);
-            }
-            struct RTTIMessageHandler *messages = type_compound->mMessageHandlers;
-            if (messages) {
-                uint8_t messages_count = type_compound->mNumMessageHandlers;
-                fprintf(file, "\tdel_items(0x%p, DELIT_SIMPLE, %zu);\n", messages, messages_count * sizeof(struct RTTIMessageHandler));
-                fprintf(file, "\tset_name(0x%p, \"%s::sMessageHandlers\");\n", messages, RTTI_Name(type));
-                fprintf(file, "\tapply_type(0x%p, \"RTTIMessageHandler[%d]\");\n", messages, messages_count);
-
-                for (uint8_t i = 0; i < messages_count; ++i) {
-                    struct RTTIMessageHandler *message = &messages[i];
-                    if (strcmp(RTTI_Name(message->mMessage), "MsgReadBinary") == 0) {
-                        fprintf(file, "\tset_name(0x%p, \"%s::OnReadBinary\");\n", message->mHandler, RTTI_Name(type));
-                        fprintf(file, "\tapply_type(0x%p, \"__int64 __fastcall f(void* this, MsgReadBinary* msg)\");\n", message->mHandler);
-                    }
-                }
-            }
-            struct RTTIMessageOrderEntry* message_order_entries = type_compound->mMessageOrderEntries;
-            if (message_order_entries) {
-                uint8_t entry_count = type_compound->mNumMessageOrderEntries;
-                fprintf(file, "\tdel_items(0x%p, DELIT_SIMPLE, %zu);\n", message_order_entries, entry_count * sizeof(struct RTTIMessageOrderEntry));
-                fprintf(file, "\tset_name(0x%p, \"%s::sInheritedMessageHandlers\");\n", message_order_entries, RTTI_Name(type));
-                fprintf(file, "\tapply_type(0x%p, \"RTTIInheritedMessageHandler[%d]\");\n", message_order_entries, entry_count);
-            }
-            if (type_compound->mGetExportedSymbols) {
-                fprintf(file, "\tset_name(0x%p, \"%s::GetExportedSymbols\");\n", type_compound->mGetExportedSymbols, RTTI_Name(type));
-            }
-        } else if (RTTI_AsEnum(type, &type_enum)) {
-            if (type_enum->values) {
-                fprintf(file, "\tdel_items(0x%p, DELIT_SIMPLE, %zu);\n", type_enum->values,
-                        type_enum->num_values * sizeof(struct RTTIValue));
-                fprintf(file, "\tset_name(0x%p, \"%s::sValues\");\n", type_enum->values, RTTI_Name(type));
-                fprintf(file, "\tapply_type(0x%p, \"RTTIValue[%d]\");", type_enum->values, type_enum->num_values);
-            }
-        } else if (RTTI_AsContainer(type, &type_container)) {
-            const char *container_name;
-            if (strcmp(type_container->mContainerType->mTypeName, "Array") == 0) {
-                // Arrays share the same info
-                container_name = type_container->mContainerType->mTypeName;
-            } else {
-                container_name = type_container->mTypeName;
+    if (TypeDbOpen("hfw_types.bin", &current)) {
+        if (fopen_s(&file, "hfw_types.delta.json", "w") == 0) {
+            if (DiffTypes(file, &previous, &current, &summary)) {
+                LogInfo("Delta: %zu added, %zu removed, %zu changed, %zu unchanged\n", summary.added, summary.removed,
+                        summary.changed, summary.unchanged);
+                StatsSet("diff.added", summary.added);
+                StatsSet("diff.removed", summary.removed);
+                StatsSet("diff.changed", summary.changed);
+                StatsSet("diff.unchanged", summary.unchanged);
             }
-            fprintf(file, "\tset_name(0x%p, \"%s::sInfo\");\n", type_container->mContainerType, container_name);
-            fprintf(file, "\tapply_type(0x%p, \"RTTIContainerData\");\n", type_container->mContainerType);
-        } else if (RTTI_AsPointer(type, &type_pointer)) {
-            fprintf(file, "\tset_name(0x%p, \"%s::sInfo\");\n", type_pointer->mPointerType, type_pointer->mPointerType->mTypeName);
-            fprintf(file, "\tapply_type(0x%p, \"RTTIPointerData\");\n", type_pointer->mPointerType);
+            fclose(file);
         }
+        TypeDbClose(&current);
     }
 
-    fputs("}", file);
+    TypeDbClose(&previous);
+    StatsEnd(timer);
 }
@@ -0,0 +1,85 @@
+#include "mapping.h"
+
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+_Bool MapFile(const char *path, struct FileMapping *mapping) {
+    memset(mapping, 0, sizeof(*mapping));
+
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    LARGE_INTEGER size;
+
+    if (file == INVALID_HANDLE_VALUE)
+        return 0;
+
+    if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+        CloseHandle(file);
+        return 0;
+    }
+
+    HANDLE handle = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (handle == NULL) {
+        CloseHandle(file);
+        return 0;
+    }
+
+    mapping->data = MapViewOfFile(handle, FILE_MAP_READ, 0, 0, 0);
+    mapping->size = (size_t) size.QuadPart;
+    mapping->file = file;
+    mapping->mapping = handle;
+
+    if (mapping->data == NULL) {
+        UnmapFile(mapping);
+        return 0;
+    }
+#else
+    int fd = open(path, O_RDONLY);
+    struct stat st;
+
+    if (fd < 0)
+        return 0;
+
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        close(fd);
+        return 0;
+    }
+
+    void *data = mmap(NULL, (size_t) st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+
+    if (data == MAP_FAILED)
+        return 0;
+
+    mapping->data = data;
+    mapping->size = (size_t) st.st_size;
+    mapping->mapping = data;
+#endif
+
+    return 1;
+}
+
+void UnmapFile(struct FileMapping *mapping) {
+#ifdef _WIN32
+    if (mapping->mapping) {
+        if (mapping->data)
+            UnmapViewOfFile(mapping->data);
+        CloseHandle(mapping->mapping);
+    }
+    if (mapping->file)
+        CloseHandle(mapping->file);
+#else
+    if (mapping->mapping)
+        munmap(mapping->mapping, mapping->size);
+#endif
+
+    memset(mapping, 0, sizeof(*mapping));
+}
@@ -0,0 +1,91 @@
+#include "memo.h"
+#include "arena.h"
+
+#include <stdint.h>
+#include <string.h>
+
+struct MemoSlot {
+    volatile size_t key; ///< 0 for an empty slot. Published after `value`
+    size_t value;
+};
+
+struct MemoTable {
+    size_t capacity;
+    unsigned shift;
+    size_t count;
+    struct MemoSlot slots[];
+};
+
+static size_t HashKey(size_t key, unsigned shift) {
+    return (size_t) (((uint64_t) key * 0x9E3779B97F4A7C15ull) >> shift);
+}
+
+static void InsertSlot(struct MemoTable *table, size_t key, size_t value) {
+    size_t mask = table->capacity - 1;
+    size_t slot = HashKey(key, table->shift);
+
+    while (table->slots[slot].key)
+        slot = (slot + 1) & mask;
+
+    table->slots[slot].value = value;
+    AtomicStore(&table->slots[slot].key, key);
+    table->count++;
+}
+
+static struct MemoTable *Grow(struct Memo *memo, struct MemoTable *table) {
+    size_t capacity = table ? table->capacity * 2 : 1024;
+    size_t size = sizeof(struct MemoTable) + capacity * sizeof(struct MemoSlot);
+    struct MemoTable *grown = SessionAlloc(size, sizeof(void *));
+
+    if (grown == NULL)
+        return NULL;
+
+    memset(grown, 0, size);
+    grown->capacity = capacity;
+    grown->shift = 64;
+    while (((size_t) 1 << (64 - grown->shift)) < capacity)
+        grown->shift--;
+
+    for (size_t i = 0; table && i < table->capacity; i++) {
+        if (table->slots[i].key)
+            InsertSlot(grown, table->slots[i].key, table->slots[i].value);
+    }
+
+    AtomicStore(&memo->table, (size_t) (uintptr_t) grown);
+    return grown;
+}
+
+_Bool MemoFind(struct Memo *memo, const void *key, size_t *value) {
+    struct MemoTable *table = (struct MemoTable *) (uintptr_t) AtomicLoad(&memo->table);
+
+    if (table == NULL)
+        return 0;
+
+    size_t mask = table->capacity - 1;
+
+    for (size_t slot = HashKey((size_t) (uintptr_t) key, table->shift);; slot = (slot + 1) & mask) {
+        size_t current = AtomicLoad(&table->slots[slot].key);
+        if (current == (size_t) (uintptr_t) key) {
+            *value = table->slots[slot].value;
+            return 1;
+        }
+        if (current == 0)
+            return 0;
+    }
+}
+
+_Bool MemoInsert(struct Memo *memo, const void *key, size_t value) {
+    struct MemoTable *table = (struct MemoTable *) (uintptr_t) memo->table;
+
+    if (table == NULL || (table->count + 1) * 2 > table->capacity) {
+        if ((table = Grow(memo, table)) == NULL)
+            return 0;
+    }
+
+    InsertSlot(table, (size_t) (uintptr_t) key, value);
+    return 1;
+}
+
+void MemoReset(struct Memo *memo) {
+    AtomicStore(&memo->table, 0);
+}
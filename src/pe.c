@@ -0,0 +1,206 @@
+#include "pe.h"
+
+#include <string.h>
+
+#define PE_DOS_MAGIC 0x5A4D
+#define PE_NT_SIGNATURE 0x00004550
+#define PE_OPTIONAL_MAGIC_32 0x10B
+#define PE_OPTIONAL_MAGIC_64 0x20B
+
+static uint16_t ReadU16(const uint8_t *data) {
+    uint16_t value;
+    memcpy(&value, data, sizeof(value));
+    return value;
+}
+
+static uint32_t ReadU32(const uint8_t *data) {
+    uint32_t value;
+    memcpy(&value, data, sizeof(value));
+    return value;
+}
+
+static uint64_t ReadU64(const uint8_t *data) {
+    uint64_t value;
+    memcpy(&value, data, sizeof(value));
+    return value;
+}
+
+static _Bool ParseHeaders(struct PeImage *image) {
+    const uint8_t *data = image->data;
+
+    if (image->size < 0x40 || ReadU16(data) != PE_DOS_MAGIC)
+        return 0;
+
+    uint32_t nt_offset = ReadU32(data + 0x3C);
+    if (nt_offset > image->size || image->size - nt_offset < 24 || ReadU32(data + nt_offset) != PE_NT_SIGNATURE)
+        return 0;
+
+    const uint8_t *file_header = data + nt_offset + 4;
+    const uint8_t *optional_header = file_header + 20;
+    uint16_t optional_size = ReadU16(file_header + 16);
+    size_t sections_offset = (size_t) (optional_header - data) + optional_size;
+
+    image->num_sections = ReadU16(file_header + 2);
+    image->time_date_stamp = ReadU32(file_header + 4);
+
+    if (optional_size < 60 || sections_offset > image->size)
+        return 0;
+
+    switch (ReadU16(optional_header)) {
+        case PE_OPTIONAL_MAGIC_32:
+            image->image_base = ReadU32(optional_header + 28);
+            break;
+        case PE_OPTIONAL_MAGIC_64:
+            image->image_base = ReadU64(optional_header + 24);
+            break;
+        default:
+            return 0;
+    }
+
+    image->size_of_image = ReadU32(optional_header + 56);
+
+    if ((image->size - sections_offset) / sizeof(struct PeSectionHeader) < image->num_sections)
+        return 0;
+
+    image->sections = (const struct PeSectionHeader *) (data + sections_offset);
+
+    return 1;
+}
+
+_Bool PeOpen(const char *path, struct PeImage *image) {
+    memset(image, 0, sizeof(*image));
+
+    if (!MapFile(path, &image->mapping))
+        return 0;
+
+    image->data = image->mapping.data;
+    image->size = image->mapping.size;
+
+    if (!ParseHeaders(image)) {
+        PeClose(image);
+        return 0;
+    }
+
+    return 1;
+}
+
+_Bool PeAttach(void *module, struct PeImage *image) {
+    memset(image, 0, sizeof(*image));
+
+    image->data = module;
+    image->size = SIZE_MAX - (uintptr_t) module;
+    image->loaded = 1;
+
+    if (!ParseHeaders(image))
+        return 0;
+
+    image->size = image->size_of_image;
+
+    return 1;
+}
+
+void PeClose(struct PeImage *image) {
+    UnmapFile(&image->mapping);
+    memset(image, 0, sizeof(*image));
+}
+
+const struct PeSectionHeader *PeFindSectionHeader(const struct PeImage *image, const char *name) {
+    char padded[PE_SECTION_NAME_LENGTH] = {0};
+    size_t length = strlen(name);
+
+    if (length > PE_SECTION_NAME_LENGTH)
+        return NULL;
+
+    memcpy(padded, name, length);
+
+    for (uint16_t index = 0; index < image->num_sections; index++) {
+        if (memcmp(image->sections[index].mName, padded, PE_SECTION_NAME_LENGTH) == 0)
+            return &image->sections[index];
+    }
+
+    return NULL;
+}
+
+_Bool PeFindSection(const struct PeImage *image, const char *name, struct Section *section) {
+    const struct PeSectionHeader *header = PeFindSectionHeader(image, name);
+    uint32_t start;
+    uint32_t size;
+
+    if (header == NULL)
+        return 0;
+
+    if (image->loaded) {
+        start = header->mVirtualAddress;
+        size = header->mVirtualSize;
+    } else {
+        // The raw data is padded to the file alignment, anything past the virtual size is not part of the section
+        start = header->mPointerToRawData;
+        size = header->mSizeOfRawData;
+        if (header->mVirtualSize && header->mVirtualSize < size)
+            size = header->mVirtualSize;
+    }
+
+    if (start > image->size || image->size - start < size)
+        return 0;
+
+    section->start = image->data + start;
+    section->end = image->data + start + size;
+
+    return 1;
+}
+
+_Bool PeOffsetToRva(const struct PeImage *image, uint32_t offset, uint32_t *rva) {
+    for (uint16_t index = 0; index < image->num_sections; index++) {
+        const struct PeSectionHeader *header = &image->sections[index];
+
+        if (offset >= header->mPointerToRawData && offset - header->mPointerToRawData < header->mSizeOfRawData) {
+            *rva = header->mVirtualAddress + (offset - header->mPointerToRawData);
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+_Bool PeRvaToOffset(const struct PeImage *image, uint32_t rva, uint32_t *offset) {
+    for (uint16_t index = 0; index < image->num_sections; index++) {
+        const struct PeSectionHeader *header = &image->sections[index];
+
+        if (rva >= header->mVirtualAddress && rva - header->mVirtualAddress < header->mSizeOfRawData) {
+            *offset = header->mPointerToRawData + (rva - header->mVirtualAddress);
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+_Bool PeAddressOf(const struct PeImage *image, const void *position, uint64_t *address) {
+    const uint8_t *pointer = position;
+    uint32_t rva;
+
+    if (pointer < image->data || (size_t) (pointer - image->data) >= image->size)
+        return 0;
+
+    if (image->loaded) {
+        rva = (uint32_t) (pointer - image->data);
+    } else if (!PeOffsetToRva(image, (uint32_t) (pointer - image->data), &rva)) {
+        return 0;
+    }
+
+    *address = image->image_base + rva;
+    return 1;
+}
+
+_Bool PeRvaToPointer(const struct PeImage *image, uint32_t rva, void **position) {
+    uint32_t offset = rva;
+
+    if (!image->loaded && !PeRvaToOffset(image, rva, &offset))
+        return 0;
+
+    if (offset >= image->size)
+        return 0;
+
+    *position = image->data + offset;
+    return 1;
+}
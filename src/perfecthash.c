@@ -0,0 +1,250 @@
+#include "perfecthash.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define PERFECT_HASH_BUCKET_SIZE 4
+#define PERFECT_HASH_MAX_DISPLACEMENT (1u << 22)
+#define PERFECT_HASH_MAX_SEEDS 16
+
+/// Scratch state of a build, indexed by key unless noted otherwise.
+struct Builder {
+    const char *const *keys;
+    uint32_t count;
+    uint64_t *hashes;
+    uint32_t *first; ///< Per bucket, position of its first key in `order`
+    uint32_t *sizes; ///< Per bucket, number of distinct keys
+    uint32_t *order; ///< Keys grouped by bucket, in key order within a bucket
+    uint32_t *queue; ///< Buckets from the biggest to the smallest
+    uint8_t *taken; ///< Per slot
+    uint32_t *buckets;
+    uint32_t *slots;
+};
+
+static uint64_t Mix(uint64_t x) {
+    x ^= x >> 30;
+    x *= 0xBF58476D1CE4E5B9ull;
+    x ^= x >> 27;
+    x *= 0x94D049BB133111EBull;
+    return x ^ (x >> 31);
+}
+
+static uint64_t HashKey(uint64_t seed, const char *key) {
+    uint64_t hash = 0xCBF29CE484222325ull ^ seed;
+
+    while (*key) {
+        hash ^= (uint8_t) *key++;
+        hash *= 0x100000001B3ull;
+    }
+
+    return Mix(hash);
+}
+
+/// Maps a 32-bit value onto [0, range) without a division.
+static uint32_t Reduce(uint32_t value, uint32_t range) {
+    return (uint32_t) (((uint64_t) value * range) >> 32);
+}
+
+static uint32_t BucketOf(uint64_t hash, uint32_t num_buckets) {
+    return Reduce((uint32_t) (hash >> 32), num_buckets);
+}
+
+static uint32_t SlotOf(uint64_t hash, uint32_t displacement, uint32_t num_slots) {
+    return Reduce((uint32_t) (Mix(hash ^ displacement * 0x9E3779B97F4A7C15ull) >> 32), num_slots);
+}
+
+/// Groups the keys by bucket and drops repeated ones. Fails when distinct keys share a full hash.
+static _Bool Distribute(struct Builder *builder, uint64_t seed, uint32_t num_buckets, uint32_t *num_slots) {
+    uint32_t count = builder->count;
+    uint32_t unique = 0;
+
+    memset(builder->first, 0, (num_buckets + 1) * sizeof(uint32_t));
+
+    for (uint32_t i = 0; i < count; i++) {
+        builder->hashes[i] = HashKey(seed, builder->keys[i]);
+        builder->first[BucketOf(builder->hashes[i], num_buckets) + 1]++;
+    }
+
+    for (uint32_t b = 0; b < num_buckets; b++) {
+        builder->first[b + 1] += builder->first[b];
+        builder->sizes[b] = 0;
+    }
+
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t bucket = BucketOf(builder->hashes[i], num_buckets);
+        uint32_t *members = &builder->order[builder->first[bucket]];
+        uint32_t size = builder->sizes[bucket];
+        _Bool repeated = 0;
+
+        for (uint32_t j = 0; j < size && !repeated; j++) {
+            if (builder->hashes[members[j]] != builder->hashes[i])
+                continue;
+            if (strcmp(builder->keys[members[j]], builder->keys[i]) != 0)
+                return 0;
+            repeated = 1;
+        }
+
+        if (!repeated) {
+            members[size] = i;
+            builder->sizes[bucket]++;
+            unique++;
+        }
+    }
+
+    *num_slots = unique;
+    return 1;
+}
+
+/// Orders the buckets by descending size with a counting sort, big buckets are the hardest to place.
+/// Place stops at the first empty bucket, so without this order there is no table to build.
+static _Bool SortBuckets(struct Builder *builder, uint32_t num_buckets) {
+    uint32_t max_size = 0;
+
+    for (uint32_t b = 0; b < num_buckets; b++) {
+        if (builder->sizes[b] > max_size)
+            max_size = builder->sizes[b];
+    }
+
+    uint32_t *starts = calloc(max_size + 2, sizeof(uint32_t));
+
+    if (starts == NULL)
+        return 0;
+
+    for (uint32_t b = 0; b < num_buckets; b++)
+        starts[max_size - builder->sizes[b] + 1]++;
+    for (uint32_t s = 0; s <= max_size; s++)
+        starts[s + 1] += starts[s];
+    for (uint32_t b = 0; b < num_buckets; b++)
+        builder->queue[starts[max_size - builder->sizes[b]]++] = b;
+
+    free(starts);
+    return 1;
+}
+
+/// Searches the displacement of every bucket with more than one key, then hands the remaining
+/// free slots to the buckets of one key directly.
+static _Bool Place(struct Builder *builder, uint32_t num_buckets, uint32_t num_slots) {
+    uint32_t cursor = 0;
+
+    memset(builder->taken, 0, num_slots);
+    memset(builder->buckets, 0, num_buckets * sizeof(uint32_t));
+
+    for (uint32_t q = 0; q < num_buckets; q++) {
+        uint32_t bucket = builder->queue[q];
+        uint32_t size = builder->sizes[bucket];
+        const uint32_t *members = &builder->order[builder->first[bucket]];
+
+        if (size == 0)
+            break;
+
+        if (size == 1) {
+            while (builder->taken[cursor])
+                cursor++;
+            builder->taken[cursor] = 1;
+            builder->slots[cursor] = members[0];
+            builder->buckets[bucket] = PERFECT_HASH_DIRECT | cursor;
+            continue;
+        }
+
+        uint32_t displacement = 0;
+        uint32_t placed = 0;
+
+        for (; displacement < PERFECT_HASH_MAX_DISPLACEMENT && placed < size; displacement++) {
+            for (placed = 0; placed < size; placed++) {
+                uint32_t slot = SlotOf(builder->hashes[members[placed]], displacement, num_slots);
+                if (builder->taken[slot])
+                    break;
+                builder->taken[slot] = 1;
+            }
+
+            if (placed < size) {
+                for (uint32_t k = 0; k < placed; k++)
+                    builder->taken[SlotOf(builder->hashes[members[k]], displacement, num_slots)] = 0;
+            }
+        }
+
+        if (placed < size)
+            return 0;
+
+        builder->buckets[bucket] = --displacement;
+        for (uint32_t k = 0; k < size; k++)
+            builder->slots[SlotOf(builder->hashes[members[k]], displacement, num_slots)] = members[k];
+    }
+
+    return 1;
+}
+
+_Bool PerfectHashBuild(struct PerfectHash *hash, const char *const *keys, uint32_t count) {
+    uint32_t num_buckets = count / PERFECT_HASH_BUCKET_SIZE + 1;
+    struct Builder builder = {
+            .keys = keys,
+            .count = count,
+            .hashes = malloc(((size_t) count + 1) * sizeof(uint64_t)),
+            .first = malloc(((size_t) num_buckets + 1) * sizeof(uint32_t)),
+            .sizes = malloc((size_t) num_buckets * sizeof(uint32_t)),
+            .order = malloc(((size_t) count + 1) * sizeof(uint32_t)),
+            .queue = malloc((size_t) num_buckets * sizeof(uint32_t)),
+            .taken = malloc((size_t) count + 1),
+            .buckets = malloc((size_t) num_buckets * sizeof(uint32_t)),
+            .slots = malloc(((size_t) count + 1) * sizeof(uint32_t)),
+    };
+    _Bool built = 0;
+
+    memset(hash, 0, sizeof(*hash));
+
+    if (count < PERFECT_HASH_DIRECT && builder.hashes && builder.first && builder.sizes && builder.order && builder.queue
+        && builder.taken && builder.buckets && builder.slots) {
+        for (uint64_t attempt = 0; attempt < PERFECT_HASH_MAX_SEEDS && !built; attempt++) {
+            uint64_t seed = Mix(attempt + 1);
+            uint32_t num_slots;
+
+            if (!Distribute(&builder, seed, num_buckets, &num_slots))
+                continue;
+
+            if (!SortBuckets(&builder, num_buckets))
+                break;
+
+            if (Place(&builder, num_buckets, num_slots)) {
+                hash->seed = seed;
+                hash->num_buckets = num_buckets;
+                hash->num_slots = num_slots;
+                built = 1;
+            }
+        }
+    }
+
+    if (built) {
+        hash->buckets = builder.buckets;
+        hash->slots = builder.slots;
+    } else {
+        free(builder.buckets);
+        free(builder.slots);
+    }
+
+    free(builder.hashes);
+    free(builder.first);
+    free(builder.sizes);
+    free(builder.order);
+    free(builder.queue);
+    free(builder.taken);
+
+    return built;
+}
+
+void PerfectHashFree(struct PerfectHash *hash) {
+    free((void *) hash->buckets);
+    free((void *) hash->slots);
+    memset(hash, 0, sizeof(*hash));
+}
+
+uint32_t PerfectHashLookup(const struct PerfectHash *hash, const char *key) {
+    if (hash->num_slots == 0)
+        return PERFECT_HASH_NONE;
+
+    uint64_t value = HashKey(hash->seed, key);
+    uint32_t displacement = hash->buckets[BucketOf(value, hash->num_buckets)];
+    uint32_t slot = displacement & PERFECT_HASH_DIRECT ? displacement & ~PERFECT_HASH_DIRECT
+                                                      : SlotOf(value, displacement, hash->num_slots);
+
+    return hash->slots[slot];
+}
@@ -0,0 +1,685 @@
+#include "plan.h"
+#include "arena.h"
+#include "layout.h"
+#include "memo.h"
+#include "typeset.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define PLAN_MAX_ALIASES 16 ///< Atoms naming other atoms as their base, deeper chains are treated as opaque
+#define PLAN_BUFFER_SIZE 65536
+
+static struct Memo g_plans;
+
+struct AtomOp {
+    const char *name;
+    uint8_t op;
+    uint16_t size; ///< The value must have, 0 for any
+};
+
+/// Base atoms with a known representation, aliases are looked up through their base type.
+static const struct AtomOp g_atom_ops[] = {
+        {"bool", PlanOp_Bool, 1},
+        {"int8", PlanOp_Int, 1},
+        {"int16", PlanOp_Int, 2},
+        {"int", PlanOp_Int, 4},
+        {"int32", PlanOp_Int, 4},
+        {"int64", PlanOp_Int, 8},
+        {"uint8", PlanOp_Uint, 1},
+        {"uint16", PlanOp_Uint, 2},
+        {"uint", PlanOp_Uint, 4},
+        {"uint32", PlanOp_Uint, 4},
+        {"uint64", PlanOp_Uint, 8},
+        {"wchar", PlanOp_Uint, 2},
+        {"ucs4", PlanOp_Uint, 4},
+        {"float", PlanOp_Float, 4},
+        {"double", PlanOp_Double, 8},
+        {"HalfFloat", PlanOp_Half, 2},
+        {"String", PlanOp_String, sizeof(void *)},
+};
+
+/// Object ids of one write, keyed by address.
+struct ObjectIds {
+    const void **keys;
+    uint32_t *ids;
+    size_t capacity;
+    unsigned shift;
+    uint32_t count;
+};
+
+struct PlanRun {
+    const struct PlanWriter *writer;
+    struct ObjectIds ids;
+    size_t depth; ///< Pointers followed to get to the current object
+    struct JsonContext *json;
+    FILE *file;
+    uint8_t *buffer;
+    size_t length;
+    _Bool failed;
+};
+
+static uint32_t SizeOf(struct RTTI *rtti) {
+    switch (rtti->kind) {
+        case RTTIKind_Atom:
+            return ((struct RTTIAtom *) rtti)->mSize;
+        case RTTIKind_Enum:
+        case RTTIKind_EnumFlags:
+            return ((struct RTTIEnum *) rtti)->size;
+        case RTTIKind_Container:
+            return ((struct RTTIContainer *) rtti)->mContainerType->mSize;
+        case RTTIKind_Pointer:
+            return ((struct RTTIPointer *) rtti)->mPointerType->mSize;
+        case RTTIKind_Compound:
+            return ((struct RTTICompound *) rtti)->mSize;
+        default:
+            return 0;
+    }
+}
+
+static const struct Plan *FindPlan(struct Memo *memo, struct RTTI *rtti) {
+    size_t plan;
+    return MemoFind(memo, rtti, &plan) ? (const struct Plan *) plan : NULL;
+}
+
+static uint8_t AtomOp(struct RTTIAtom *atom) {
+    struct RTTIAtom *base = atom;
+
+    for (int i = 0; i < PLAN_MAX_ALIASES; i++) {
+        for (size_t j = 0; j < sizeof(g_atom_ops) / sizeof(*g_atom_ops); j++) {
+            if (strcmp(base->mTypeName, g_atom_ops[j].name) != 0)
+                continue;
+            if (g_atom_ops[j].size != atom->mSize)
+                return atom->mSimple ? PlanOp_Bytes : PlanOp_Skip;
+            return g_atom_ops[j].op;
+        }
+
+        struct RTTIAtom *next;
+        if (base->mBaseType == NULL || base->mBaseType == &base->base || !RTTI_AsAtom(base->mBaseType, &next))
+            break;
+        base = next;
+    }
+
+    return atom->mSimple ? PlanOp_Bytes : PlanOp_Skip;
+}
+
+static _Bool IsArray(struct RTTIContainer *container) {
+    return strcmp(container->mContainerType->mTypeName, "Array") == 0;
+}
+
+static _Bool IsFollowed(struct RTTIPointer *pointer) {
+    return strcmp(pointer->mPointerType->mTypeName, "Ref") == 0 || strcmp(pointer->mPointerType->mTypeName, "cptr") == 0;
+}
+
+/// Type whose plan a step of this type runs, NULL for steps that run none.
+static struct RTTI *StepTarget(struct RTTI *rtti) {
+    struct RTTIContainer *container;
+    struct RTTIPointer *pointer;
+
+    if (rtti->kind == RTTIKind_Compound)
+        return rtti;
+    if (RTTI_AsContainer(rtti, &container))
+        return IsArray(container) ? container->mItemType : NULL;
+    if (RTTI_AsPointer(rtti, &pointer))
+        return pointer->mItemType;
+    return NULL;
+}
+
+static struct PlanStep LowerStep(struct Memo *pending, struct RTTI *rtti, uint32_t offset, const char *name) {
+    struct PlanStep step = {.op = PlanOp_Skip, .size = (uint16_t) SizeOf(rtti), .offset = offset, .name = name};
+    struct RTTI *target = StepTarget(rtti);
+    struct RTTIContainer *container;
+    struct RTTIPointer *pointer;
+    struct RTTIEnum *enumeration;
+    struct RTTIAtom *atom;
+
+    if (target != NULL && (step.plan = FindPlan(&g_plans, target)) == NULL)
+        step.plan = FindPlan(pending, target);
+
+    if (RTTI_AsAtom(rtti, &atom)) {
+        step.op = AtomOp(atom);
+    } else if (RTTI_AsEnum(rtti, &enumeration)) {
+        step.op = rtti->kind == RTTIKind_EnumFlags ? PlanOp_Flags : PlanOp_Enum;
+        step.enumeration = enumeration;
+    } else if (rtti->kind == RTTIKind_Compound) {
+        step.op = PlanOp_Compound;
+    } else if (RTTI_AsContainer(rtti, &container)) {
+        step.op = IsArray(container) && step.plan != NULL ? PlanOp_Array : PlanOp_Skip;
+    } else if (RTTI_AsPointer(rtti, &pointer)) {
+        step.op = PlanOp_Pointer;
+        step.follow = IsFollowed(pointer);
+    }
+
+    return step;
+}
+
+/// Collects `root` and every type reachable from it that has no plan yet, allocates all of their plans,
+/// fills them in and only then publishes them, so that plans referring to each other are complete when seen.
+static const struct Plan *Compile(struct RTTI *root) {
+    struct TypeSet types;
+    struct Memo pending = {0};
+    _Bool failed = !TypeSetInit(&types, 64) || !TypeSetInsert(&types, root);
+
+    for (size_t i = 0; i < types.count && !failed; i++) {
+        struct RTTI *rtti = types.items[i];
+        struct RTTICompound *compound;
+        const struct Layout *layout = NULL;
+
+        if (RTTI_AsCompound(rtti, &compound) && (layout = LayoutOf(compound)) == NULL) {
+            failed = 1;
+            break;
+        }
+
+        uint32_t count = layout ? layout->num_fields : 1;
+        struct Plan *plan = SessionAlloc(sizeof(struct Plan) + count * sizeof(struct PlanStep), sizeof(void *));
+
+        if (plan == NULL || !MemoInsert(&pending, rtti, (size_t) (uintptr_t) plan)) {
+            failed = 1;
+            break;
+        }
+
+        plan->type = rtti;
+        plan->size = SizeOf(rtti);
+        plan->num_steps = count;
+
+        for (uint32_t j = 0; j < count && !failed; j++) {
+            struct RTTI *target = StepTarget(layout ? layout->fields[j].attr->type : rtti);
+
+            if (target != NULL && FindPlan(&g_plans, target) == NULL && !TypeSetContains(&types, target))
+                failed = !TypeSetInsert(&types, target);
+        }
+    }
+
+    for (size_t i = 0; i < types.count && !failed; i++) {
+        struct RTTI *rtti = types.items[i];
+        struct Plan *plan = (struct Plan *) FindPlan(&pending, rtti);
+        struct RTTICompound *compound;
+
+        if (!RTTI_AsCompound(rtti, &compound)) {
+            plan->steps[0] = LowerStep(&pending, rtti, 0, NULL);
+            continue;
+        }
+
+        const struct Layout *layout = LayoutOf(compound);
+        for (uint32_t j = 0; j < plan->num_steps; j++) {
+            const struct LayoutField *field = &layout->fields[j];
+            plan->steps[j] = LowerStep(&pending, field->attr->type, field->offset, field->attr->mName);
+        }
+    }
+
+    for (size_t i = 0; i < types.count && !failed; i++)
+        failed = !MemoInsert(&g_plans, types.items[i], (size_t) (uintptr_t) FindPlan(&pending, types.items[i]));
+
+    TypeSetFree(&types);
+    return failed ? NULL : FindPlan(&g_plans, root);
+}
+
+const struct Plan *PlanOf(struct RTTI *rtti) {
+    const struct Plan *plan = FindPlan(&g_plans, rtti);
+
+    if (plan != NULL)
+        return plan;
+
+    SpinLockAcquire(&g_plans.lock);
+
+    if ((plan = FindPlan(&g_plans, rtti)) == NULL)
+        plan = Compile(rtti);
+
+    SpinLockRelease(&g_plans.lock);
+
+    return plan;
+}
+
+void PlanReset(void) {
+    MemoReset(&g_plans);
+}
+
+static size_t HashObject(const void *object, unsigned shift) {
+    return (size_t) (((uint64_t) (uintptr_t) object * 0x9E3779B97F4A7C15ull) >> shift);
+}
+
+static uint32_t IdsFind(struct ObjectIds *ids, const void *object) {
+    size_t mask = ids->capacity - 1;
+
+    for (size_t slot = ids->capacity ? HashObject(object, ids->shift) : 0; ids->capacity && ids->keys[slot]; slot = (slot + 1) & mask) {
+        if (ids->keys[slot] == object)
+            return ids->ids[slot];
+    }
+
+    return UINT32_MAX;
+}
+
+/// Numbers the object after the ones seen before it.
+static _Bool IdsAdd(struct ObjectIds *ids, const void *object, uint32_t *id) {
+    if ((ids->count + 1) * 2 > ids->capacity) {
+        struct ObjectIds grown = {.capacity = ids->capacity ? ids->capacity * 2 : 256, .shift = 64, .count = ids->count};
+
+        grown.keys = calloc(grown.capacity, sizeof(void *));
+        grown.ids = malloc(grown.capacity * sizeof(uint32_t));
+        if (grown.keys == NULL || grown.ids == NULL) {
+            free(grown.keys);
+            free(grown.ids);
+            return 0;
+        }
+
+        while (((size_t) 1 << (64 - grown.shift)) < grown.capacity)
+            grown.shift--;
+
+        for (size_t i = 0; i < ids->capacity; i++) {
+            if (ids->keys[i] == NULL)
+                continue;
+
+            size_t slot = HashObject(ids->keys[i], grown.shift);
+            while (grown.keys[slot])
+                slot = (slot + 1) & (grown.capacity - 1);
+            grown.keys[slot] = ids->keys[i];
+            grown.ids[slot] = ids->ids[i];
+        }
+
+        free(ids->keys);
+        free(ids->ids);
+        *ids = grown;
+    }
+
+    size_t slot = HashObject(object, ids->shift);
+    while (ids->keys[slot])
+        slot = (slot + 1) & (ids->capacity - 1);
+
+    ids->keys[slot] = object;
+    ids->ids[slot] = *id = ids->count++;
+    return 1;
+}
+
+static void IdsFree(struct ObjectIds *ids) {
+    free(ids->keys);
+    free(ids->ids);
+    memset(ids, 0, sizeof(*ids));
+}
+
+static uint64_t ReadUnsigned(const uint8_t *value, size_t size) {
+    uint8_t u8;
+    uint16_t u16;
+    uint32_t u32;
+    uint64_t u64 = 0;
+
+    switch (size) {
+        case 1:
+            memcpy(&u8, value, 1);
+            return u8;
+        case 2:
+            memcpy(&u16, value, 2);
+            return u16;
+        case 4:
+            memcpy(&u32, value, 4);
+            return u32;
+        default:
+            memcpy(&u64, value, size < 8 ? size : 8);
+            return u64;
+    }
+}
+
+static int64_t ReadSigned(const uint8_t *value, size_t size) {
+    uint64_t bits = ReadUnsigned(value, size);
+    unsigned shift = size < 8 ? 64 - (unsigned) size * 8 : 0;
+
+    return (int64_t) (bits << shift) >> shift;
+}
+
+static const void *ReadPointer(const uint8_t *value) {
+    const void *pointer;
+    memcpy(&pointer, value, sizeof(pointer));
+    return pointer;
+}
+
+static float HalfToFloat(uint16_t half) {
+    uint32_t sign = (uint32_t) (half & 0x8000) << 16;
+    uint32_t exponent = (half >> 10) & 0x1F;
+    uint32_t mantissa = half & 0x3FF;
+    uint32_t bits;
+    float value;
+
+    if (exponent == 0x1F) {
+        bits = sign | 0x7F800000 | mantissa << 13;
+    } else if (exponent != 0) {
+        bits = sign | (exponent + 112) << 23 | mantissa << 13;
+    } else if (mantissa != 0) {
+        // Subnormal halves are normal floats
+        exponent = 113;
+        while ((mantissa & 0x400) == 0) {
+            mantissa <<= 1;
+            exponent--;
+        }
+        bits = sign | exponent << 23 | (mantissa & 0x3FF) << 13;
+    } else {
+        bits = sign;
+    }
+
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+/// Dynamic plan of the object a followed pointer points to.
+static const struct Plan *PointeePlan(struct PlanRun *run, const struct PlanStep *step, const void *object) {
+    if (run->writer->resolve != NULL) {
+        struct RTTI *type = run->writer->resolve(object, step->plan->type, run->writer->context);
+        if (type != NULL && type != step->plan->type)
+            return PlanOf(type);
+    }
+
+    return step->plan;
+}
+
+static _Bool IsFollowing(struct PlanRun *run, const struct PlanStep *step) {
+    return step->follow && step->plan != NULL && !run->writer->no_follow && run->depth < PLAN_MAX_DEPTH;
+}
+
+/// Only compounds get an id, other values pointed to are written in place every time.
+static _Bool IsIdentified(const struct Plan *plan) {
+    return plan->type->kind == RTTIKind_Compound;
+}
+
+static void JsonPlan(struct PlanRun *run, const struct Plan *plan, const uint8_t *object, uint32_t id);
+
+static void JsonBytes(struct JsonContext *ctx, const uint8_t *value, size_t size) {
+    static const char digits[] = "0123456789ABCDEF";
+    char inline_text[2 * 32 + 1];
+    char *text = size <= 32 ? inline_text : malloc(2 * size + 1);
+
+    if (text == NULL) {
+        JsonValueNull(ctx);
+        return;
+    }
+
+    for (size_t i = 0; i < size; i++) {
+        text[i * 2] = digits[value[i] >> 4];
+        text[i * 2 + 1] = digits[value[i] & 15];
+    }
+    text[size * 2] = 0;
+
+    JsonValueStr(ctx, text);
+
+    if (text != inline_text)
+        free(text);
+}
+
+static void JsonAddress(struct JsonContext *ctx, const void *address) {
+    char text[2 + 16 + 1];
+    snprintf(text, sizeof(text), "0x%llx", (unsigned long long) (uintptr_t) address);
+    JsonValueStr(ctx, text);
+}
+
+static void JsonFlags(struct JsonContext *ctx, struct RTTIEnum *enumeration, uint64_t value) {
+    const char *names[64];
+    uint64_t rest;
+    size_t count = RTTI_EnumFlags(enumeration, value, names, &rest);
+
+    JsonBeginArray(ctx);
+
+    for (size_t i = 0; i < count; i++)
+        JsonValueStr(ctx, names[i]);
+
+    // Bits without a name are kept as a number
+    if (rest)
+        JsonValueUnsigned(ctx, rest);
+
+    JsonEndArray(ctx);
+}
+
+static void JsonPointer(struct PlanRun *run, const struct PlanStep *step, const void *object) {
+    uint32_t id;
+
+    if (object == NULL) {
+        JsonValueNull(run->json);
+    } else if (!IsFollowing(run, step)) {
+        JsonAddress(run->json, object);
+    } else if ((id = IdsFind(&run->ids, object)) != UINT32_MAX) {
+        JsonBeginCompactObject(run->json);
+        JsonNameValueUnsigned(run->json, "$ref", id);
+        JsonEndCompactObject(run->json);
+    } else {
+        const struct Plan *plan = PointeePlan(run, step, object);
+
+        id = UINT32_MAX;
+        if (plan == NULL || (IsIdentified(plan) && !IdsAdd(&run->ids, object, &id))) {
+            run->failed = 1;
+            JsonAddress(run->json, object);
+            return;
+        }
+
+        run->depth++;
+        JsonPlan(run, plan, object, id);
+        run->depth--;
+    }
+}
+
+static void JsonStep(struct PlanRun *run, const struct PlanStep *step, const uint8_t *object) {
+    struct JsonContext *ctx = run->json;
+    const uint8_t *value = object + step->offset;
+    float half;
+    float single;
+    double number;
+
+    switch ((enum PlanOp) step->op) {
+        case PlanOp_Bool:
+            JsonValueBool(ctx, *value != 0);
+            break;
+        case PlanOp_Int:
+            JsonValueNum(ctx, ReadSigned(value, step->size));
+            break;
+        case PlanOp_Uint:
+            JsonValueUnsigned(ctx, ReadUnsigned(value, step->size));
+            break;
+        case PlanOp_Float:
+            memcpy(&single, value, sizeof(single));
+            JsonValueFloat(ctx, single);
+            break;
+        case PlanOp_Double:
+            memcpy(&number, value, sizeof(number));
+            JsonValueDouble(ctx, number);
+            break;
+        case PlanOp_Half:
+            half = HalfToFloat((uint16_t) ReadUnsigned(value, 2));
+            JsonValueFloat(ctx, half);
+            break;
+        case PlanOp_String:
+            JsonValueStr(ctx, ReadPointer(value) ? (const char *) ReadPointer(value) : "");
+            break;
+        case PlanOp_Bytes:
+            JsonBytes(ctx, value, step->size);
+            break;
+        case PlanOp_Enum: {
+            uint64_t bits = ReadUnsigned(value, step->size);
+            const char *name = RTTI_EnumName(step->enumeration, bits);
+            if (name != NULL)
+                JsonValueStr(ctx, name);
+            else
+                JsonValueUnsigned(ctx, bits);
+            break;
+        }
+        case PlanOp_Flags:
+            JsonFlags(ctx, step->enumeration, ReadUnsigned(value, step->size));
+            break;
+        case PlanOp_Compound:
+            JsonPlan(run, step->plan, value, UINT32_MAX);
+            break;
+        case PlanOp_Pointer:
+            JsonPointer(run, step, ReadPointer(value));
+            break;
+        case PlanOp_Array: {
+            uint32_t count = (uint32_t) ReadUnsigned(value, 4);
+            const uint8_t *items = ReadPointer(value + 8);
+
+            if (ctx->index + 1 >= JSON_MAX_DEPTH || (count && items == NULL)) {
+                JsonValueNull(ctx);
+                break;
+            }
+
+            JsonBeginArray(ctx);
+            for (uint32_t i = 0; i < count; i++)
+                JsonPlan(run, step->plan, items + (size_t) i * step->plan->size, UINT32_MAX);
+            JsonEndArray(ctx);
+            break;
+        }
+        case PlanOp_Skip:
+            JsonValueNull(ctx);
+            break;
+    }
+}
+
+/// Writes an object with its id when it is the target of a followed pointer.
+static void JsonPlan(struct PlanRun *run, const struct Plan *plan, const uint8_t *object, uint32_t id) {
+    struct JsonContext *ctx = run->json;
+
+    if (plan->type->kind != RTTIKind_Compound) {
+        JsonStep(run, &plan->steps[0], object);
+        return;
+    }
+
+    if (ctx->index + 1 >= JSON_MAX_DEPTH) {
+        JsonValueNull(ctx);
+        return;
+    }
+
+    JsonBeginObject(ctx);
+
+    if (id != UINT32_MAX) {
+        JsonNameValueUnsigned(ctx, "$id", id);
+        JsonNameValueStr(ctx, "$type", RTTI_DisplayName(plan->type));
+    }
+
+    for (uint32_t i = 0; i < plan->num_steps; i++) {
+        JsonName(ctx, plan->steps[i].name);
+        JsonStep(run, &plan->steps[i], object);
+    }
+
+    JsonEndObject(ctx);
+}
+
+void PlanWriteJson(struct JsonContext *ctx, const struct Plan *plan, const void *object, const struct PlanWriter *writer) {
+    static const struct PlanWriter defaults = {0};
+    struct PlanRun run = {.writer = writer ? writer : &defaults, .json = ctx};
+
+    JsonPlan(&run, plan, object, UINT32_MAX);
+    IdsFree(&run.ids);
+}
+
+static void Emit(struct PlanRun *run, const void *data, size_t size) {
+    if (run->length + size > PLAN_BUFFER_SIZE) {
+        run->failed |= fwrite(run->buffer, 1, run->length, run->file) != run->length;
+        run->length = 0;
+    }
+
+    if (size > PLAN_BUFFER_SIZE) {
+        run->failed |= fwrite(data, 1, size, run->file) != size;
+        return;
+    }
+
+    memcpy(run->buffer + run->length, data, size);
+    run->length += size;
+}
+
+static void EmitUnsigned(struct PlanRun *run, uint64_t value, size_t size) {
+    uint8_t bytes[8];
+
+    for (size_t i = 0; i < size; i++)
+        bytes[i] = (uint8_t) (value >> i * 8);
+
+    Emit(run, bytes, size);
+}
+
+static void EmitString(struct PlanRun *run, const char *string) {
+    size_t length = string ? strlen(string) : 0;
+
+    EmitUnsigned(run, length, 4);
+    Emit(run, string, length);
+}
+
+static void BinaryPlan(struct PlanRun *run, const struct Plan *plan, const uint8_t *object);
+
+static void BinaryPointer(struct PlanRun *run, const struct PlanStep *step, const void *object) {
+    uint32_t id;
+
+    if (object == NULL) {
+        EmitUnsigned(run, 0, 1);
+    } else if (!IsFollowing(run, step)) {
+        EmitUnsigned(run, 3, 1);
+        EmitUnsigned(run, (uintptr_t) object, 8);
+    } else if ((id = IdsFind(&run->ids, object)) != UINT32_MAX) {
+        EmitUnsigned(run, 2, 1);
+        EmitUnsigned(run, id, 4);
+    } else {
+        const struct Plan *plan = PointeePlan(run, step, object);
+
+        if (plan == NULL || (IsIdentified(plan) && !IdsAdd(&run->ids, object, &id))) {
+            run->failed = 1;
+            EmitUnsigned(run, 3, 1);
+            EmitUnsigned(run, (uintptr_t) object, 8);
+            return;
+        }
+
+        EmitUnsigned(run, 1, 1);
+        EmitString(run, RTTI_DisplayName(plan->type));
+        run->depth++;
+        BinaryPlan(run, plan, object);
+        run->depth--;
+    }
+}
+
+static void BinaryPlan(struct PlanRun *run, const struct Plan *plan, const uint8_t *object) {
+    for (uint32_t i = 0; i < plan->num_steps; i++) {
+        const struct PlanStep *step = &plan->steps[i];
+        const uint8_t *value = object + step->offset;
+
+        switch ((enum PlanOp) step->op) {
+            case PlanOp_Bool:
+            case PlanOp_Int:
+            case PlanOp_Uint:
+            case PlanOp_Float:
+            case PlanOp_Double:
+            case PlanOp_Half:
+            case PlanOp_Bytes:
+            case PlanOp_Enum:
+            case PlanOp_Flags:
+                Emit(run, value, step->size);
+                break;
+            case PlanOp_String:
+                EmitString(run, ReadPointer(value));
+                break;
+            case PlanOp_Compound:
+                BinaryPlan(run, step->plan, value);
+                break;
+            case PlanOp_Pointer:
+                BinaryPointer(run, step, ReadPointer(value));
+                break;
+            case PlanOp_Array: {
+                uint32_t count = (uint32_t) ReadUnsigned(value, 4);
+                const uint8_t *items = ReadPointer(value + 8);
+
+                if (items == NULL)
+                    count = 0;
+
+                EmitUnsigned(run, count, 4);
+                for (uint32_t j = 0; j < count; j++)
+                    BinaryPlan(run, step->plan, items + (size_t) j * step->plan->size);
+                break;
+            }
+            case PlanOp_Skip:
+                break;
+        }
+    }
+}
+
+_Bool PlanWriteBinary(FILE *file, const struct Plan *plan, const void *object, const struct PlanWriter *writer) {
+    static const struct PlanWriter defaults = {0};
+    struct PlanRun run = {.writer = writer ? writer : &defaults, .file = file, .buffer = malloc(PLAN_BUFFER_SIZE)};
+
+    if (run.buffer == NULL)
+        return 0;
+
+    BinaryPlan(&run, plan, object);
+    run.failed |= fwrite(run.buffer, 1, run.length, file) != run.length;
+
+    free(run.buffer);
+    IdsFree(&run.ids);
+    return !run.failed;
+}
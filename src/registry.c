@@ -0,0 +1,68 @@
+#include "registry.h"
+#include "perfecthash.h"
+#include "thread.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+struct Registry {
+    struct PerfectHash names;
+    size_t count;
+    struct RTTI *types[];
+};
+
+static volatile size_t g_registry;
+
+_Bool RegistryBuild(struct RTTI **types, size_t count) {
+    struct Registry *registry = malloc(sizeof(struct Registry) + count * sizeof(struct RTTI *));
+    const char **keys = malloc((count + 1) * sizeof(const char *));
+
+    if (registry == NULL || keys == NULL || count >= PERFECT_HASH_DIRECT) {
+        free(registry);
+        free(keys);
+        return 0;
+    }
+
+    registry->count = count;
+    memcpy(registry->types, types, count * sizeof(struct RTTI *));
+
+    for (size_t i = 0; i < count; i++)
+        keys[i] = RTTI_DisplayName(types[i]);
+
+    _Bool built = PerfectHashBuild(&registry->names, keys, (uint32_t) count);
+    free(keys);
+
+    if (!built) {
+        free(registry);
+        return 0;
+    }
+
+    RegistryReset();
+    AtomicStore(&g_registry, (size_t) (uintptr_t) registry);
+    return 1;
+}
+
+void RegistryReset(void) {
+    struct Registry *registry = (struct Registry *) (uintptr_t) AtomicLoad(&g_registry);
+
+    AtomicStore(&g_registry, 0);
+
+    if (registry != NULL) {
+        PerfectHashFree(&registry->names);
+        free(registry);
+    }
+}
+
+struct RTTI *RTTI_FindByName(const char *name) {
+    struct Registry *registry = (struct Registry *) (uintptr_t) AtomicLoad(&g_registry);
+
+    if (registry == NULL)
+        return NULL;
+
+    uint32_t index = PerfectHashLookup(&registry->names, name);
+
+    if (index == PERFECT_HASH_NONE || strcmp(RTTI_DisplayName(registry->types[index]), name) != 0)
+        return NULL;
+
+    return registry->types[index];
+}
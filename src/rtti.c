@@ -1,4 +1,9 @@
 #include "rtti.h"
+#include "arena.h"
+#include "memo.h"
+
+#include <stddef.h>
+#include <string.h>
 
 const char *RTTIKind_Name(enum RTTIKind kind) {
     switch (kind) {
@@ -37,36 +42,85 @@ const char *RTTI_Name(struct RTTI *rtti) {
     return "";
 }
 
-static char *RTTI_DisplayNameInternal(struct RTTI *rtti, char *ptr) {
-    struct RTTIContainer *container = NULL;
-    const char *name;
+/// Display names of containers and pointers, keyed by the RTTI object.
+static struct Memo g_names;
 
-    if (RTTI_AsContainer(rtti, &container) || RTTI_AsPointer(rtti, (struct RTTIPointer **) &container)) {
-        name = container->mContainerType->mTypeName;
-    } else {
-        name = RTTI_Name(rtti);
-    }
+static _Bool AsWrapper(struct RTTI *rtti, struct RTTIContainer **wrapper) {
+    // Pointers share the layout of containers up to the item type and the name of their data
+    return RTTI_AsContainer(rtti, wrapper) || RTTI_AsPointer(rtti, (struct RTTIPointer **) wrapper);
+}
 
-    while (*name) {
-        *ptr++ = *name++;
+/// Builds `Container<Item<...>>` without recursion, reusing the cached name of any inner wrapper.
+static const char *BuildDisplayName(struct RTTI *rtti) {
+    struct RTTIContainer *wrapper = NULL;
+    struct RTTI *current = rtti;
+    const char *inner = NULL;
+    size_t length = 0;
+    size_t depth = 0;
+
+    while (inner == NULL) {
+        size_t cached;
+        if (current != rtti && MemoFind(&g_names, current, &cached))
+            inner = (const char *) cached;
+        if (inner == NULL && !AsWrapper(current, &wrapper))
+            inner = RTTI_Name(current);
+        if (inner == NULL) {
+            length += strlen(wrapper->mContainerType->mTypeName) + 2;
+            depth++;
+            current = wrapper->mItemType;
+        }
     }
 
-    if (container) {
+    size_t inner_length = strlen(inner);
+    char *name = SessionAlloc(length + inner_length + 1, 1);
+    char *ptr = name;
+
+    if (name == NULL)
+        return NULL;
+
+    current = rtti;
+    for (size_t i = 0; i < depth; i++) {
+        AsWrapper(current, &wrapper);
+        size_t wrapper_length = strlen(wrapper->mContainerType->mTypeName);
+        memcpy(ptr, wrapper->mContainerType->mTypeName, wrapper_length);
+        ptr += wrapper_length;
         *ptr++ = '<';
-        ptr = RTTI_DisplayNameInternal(container->mItemType, ptr);
-        *ptr++ = '>';
+        current = wrapper->mItemType;
     }
 
-    return ptr;
+    memcpy(ptr, inner, inner_length);
+    ptr += inner_length;
+    memset(ptr, '>', depth);
+    ptr[depth] = '\0';
+
+    return name;
 }
 
 const char *RTTI_DisplayName(struct RTTI *rtti) {
+    const char *name;
+    size_t cached;
+
     if (rtti->kind != RTTIKind_Container && rtti->kind != RTTIKind_Pointer)
         return RTTI_Name(rtti);
 
-    static char buffer[4096];
-    *RTTI_DisplayNameInternal(rtti, buffer) = '\0';
-    return buffer;
+    if (MemoFind(&g_names, rtti, &cached))
+        return (const char *) cached;
+
+    SpinLockAcquire(&g_names.lock);
+
+    if (MemoFind(&g_names, rtti, &cached))
+        name = (const char *) cached;
+    else if ((name = BuildDisplayName(rtti)) != NULL)
+        MemoInsert(&g_names, rtti, (size_t) (uintptr_t) name);
+
+    SpinLockRelease(&g_names.lock);
+
+    assert(name != NULL && "Out of memory");
+    return name ? name : "";
+}
+
+void RTTI_ResetDisplayNames(void) {
+    MemoReset(&g_names);
 }
 
 _Bool RTTI_AsCompound(struct RTTI *rtti, struct RTTICompound **result) {
@@ -1,50 +1,582 @@
 #include "scan.h"
+#include "pe.h"
+#include "thread.h"
 
 #include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
 
-#include <windows.h>
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SCAN_SSE2
+#include <immintrin.h>
+#endif
+
+#if defined(SCAN_SSE2) && (defined(__GNUC__) || defined(_MSC_VER))
+#define SCAN_AVX2
+#endif
+
+#if defined(__GNUC__)
+#define SCAN_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define SCAN_TARGET_AVX2
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+#define SIGNATURES_MAX_SIMD 8
+#define SCAN_CHUNK_SIZE (4 << 20)
 
 _Bool FindSection(void *module, const char *name, struct Section *result) {
-    PIMAGE_DOS_HEADER dos_header = (PIMAGE_DOS_HEADER) module;
-    PIMAGE_NT_HEADERS64 nt_header = (PIMAGE_NT_HEADERS) ((uint8_t *) module + dos_header->e_lfanew);
-    PIMAGE_SECTION_HEADER section = IMAGE_FIRST_SECTION(nt_header);
+    struct PeImage image;
+    return PeAttach(module, &image) && PeFindSection(&image, name, result);
+}
+
+/// Rough commonness of a byte in x86-64 machine code; lower is rarer.
+static int ByteFrequency(uint8_t value) {
+    switch (value) {
+        case 0x00:
+        case 0xCC:
+        case 0xFF:
+            return 8;
+        case 0x48:
+        case 0x8B:
+        case 0x89:
+            return 7;
+        case 0x24:
+        case 0x4C:
+        case 0x0F:
+        case 0x8D:
+        case 0xE8:
+            return 6;
+        case 0x01:
+        case 0x83:
+        case 0x85:
+        case 0x84:
+        case 0xC3:
+        case 0x44:
+        case 0x41:
+        case 0x49:
+        case 0x4D:
+            return 5;
+        case 0x53:
+        case 0x55:
+        case 0x56:
+        case 0x57:
+        case 0x5B:
+        case 0x5D:
+        case 0x5E:
+        case 0x5F:
+        case 0x74:
+        case 0x75:
+        case 0xEB:
+        case 0x33:
+        case 0xC0:
+        case 0xC7:
+        case 0x45:
+        case 0x90:
+        case 0x08:
+        case 0x10:
+        case 0x20:
+        case 0x28:
+        case 0x30:
+        case 0x38:
+        case 0x40:
+        case 0x50:
+            return 4;
+        default:
+            return value < 0x10 ? 3 : 1;
+    }
+}
+
+static unsigned CountTrailingZeros(uint32_t value) {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward(&index, value);
+    return index;
+#else
+    return __builtin_ctz(value);
+#endif
+}
+
+static int HexDigit(char ch) {
+    if (ch >= '0' && ch <= '9')
+        return ch - '0';
+    if (ch >= 'a' && ch <= 'f')
+        return ch - 'a' + 10;
+    if (ch >= 'A' && ch <= 'F')
+        return ch - 'A' + 10;
+    return -1;
+}
+
+_Bool CompilePattern(const char *text, struct Pattern *result) {
+    size_t length = 0;
+
+    while (*text) {
+        if (*text == ' ') {
+            text++;
+            continue;
+        }
+
+        if (length == PATTERN_MAX_LENGTH)
+            return 0;
+
+        if (*text == '?') {
+            result->bytes[length] = 0;
+            result->mask[length] = 0;
+            text += text[1] == '?' ? 2 : 1;
+        } else {
+            int high = HexDigit(text[0]);
+            int low = high < 0 ? -1 : HexDigit(text[1]);
+
+            if (low < 0)
+                return 0;
 
-    for (WORD index = 0; index < nt_header->FileHeader.NumberOfSections; index++) {
-        if (memcmp(section->Name, name, sizeof(section->Name)) == 0) {
-            result->start = (uint8_t *) module + section->VirtualAddress;
-            result->end = (uint8_t *) module + section->VirtualAddress + section->Misc.VirtualSize;
-            return TRUE;
+            result->bytes[length] = (uint8_t) (high << 4 | low);
+            result->mask[length] = 0xFF;
+            text += 2;
         }
 
-        section++;
+        length++;
     }
 
-    return FALSE;
-}
+    if (length == 0)
+        return 0;
+
+    result->length = length;
+    result->anchor = 0;
+    result->second = 0;
+
+    int anchor_frequency = 0x100;
+    int second_frequency = 0x100;
+
+    for (size_t i = 0; i < length; i++) {
+        if (!result->mask[i])
+            continue;
+
+        int frequency = ByteFrequency(result->bytes[i]);
+        if (frequency < anchor_frequency) {
+            result->second = result->anchor;
+            second_frequency = anchor_frequency;
+            result->anchor = i;
+            anchor_frequency = frequency;
+        } else if (frequency < second_frequency) {
+            result->second = i;
+            second_frequency = frequency;
+        }
+    }
+
+    if (second_frequency == 0x100)
+        result->second = result->anchor;
 
-static int ScanPattern(uint8_t *start, const uint8_t *end, const char *pattern, uint8_t **position) {
-    while (start < end && *pattern) {
-        if (*pattern == '?') {
-            pattern += 2;
-        } else if (*start == strtol(pattern, NULL, 16)) {
-            pattern += 3;
+    for (size_t i = 0; i < 256; i++)
+        result->shift[i] = length;
+
+    for (size_t i = 0; i + 1 < length; i++) {
+        if (result->mask[i]) {
+            result->shift[result->bytes[i]] = length - 1 - i;
         } else {
-            *position = start + 1;
-            return 0;
+            for (size_t j = 0; j < 256; j++)
+                result->shift[j] = length - 1 - i;
         }
-        start++;
     }
-    return !*pattern;
+
+    return 1;
 }
 
-_Bool FindPattern(void *start, const void *end, const char *pattern, void **position) {
-    void *current = start;
-    while (current < end) {
-        if (ScanPattern(current, end, pattern, (uint8_t **) &current)) {
-            *position = current;
+_Bool MatchPattern(const void *position, const struct Pattern *pattern) {
+    const uint8_t *data = position;
+
+    for (size_t i = 0; i < pattern->length; i++) {
+        if ((data[i] & pattern->mask[i]) != pattern->bytes[i])
+            return 0;
+    }
+
+    return 1;
+}
+
+/// Searches candidate positions [start, start + count) with a Horspool skip loop.
+static _Bool ScanHorspool(const uint8_t *start, size_t count, const struct Pattern *pattern, const uint8_t **position) {
+    size_t offset = 0;
+
+    while (offset < count) {
+        if (MatchPattern(start + offset, pattern)) {
+            *position = start + offset;
             return 1;
         }
+        offset += pattern->shift[start[offset + pattern->length - 1]];
     }
+
     return 0;
 }
+
+#ifdef SCAN_SSE2
+
+static _Bool ScanSse2(const uint8_t *start, size_t count, const struct Pattern *pattern, const uint8_t **position) {
+    const __m128i anchor = _mm_set1_epi8((char) pattern->bytes[pattern->anchor]);
+    const __m128i second = _mm_set1_epi8((char) pattern->bytes[pattern->second]);
+    size_t offset = 0;
+
+    for (; offset + 16 <= count; offset += 16) {
+        const uint8_t *current = start + offset;
+        __m128i a = _mm_loadu_si128((const __m128i *) (current + pattern->anchor));
+        __m128i b = _mm_loadu_si128((const __m128i *) (current + pattern->second));
+        uint32_t mask = (uint32_t) _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(a, anchor), _mm_cmpeq_epi8(b, second)));
+
+        while (mask) {
+            const uint8_t *candidate = current + CountTrailingZeros(mask);
+            if (MatchPattern(candidate, pattern)) {
+                *position = candidate;
+                return 1;
+            }
+            mask &= mask - 1;
+        }
+    }
+
+    return ScanHorspool(start + offset, count - offset, pattern, position);
+}
+
+#endif
+
+#ifdef SCAN_AVX2
+
+SCAN_TARGET_AVX2
+static _Bool ScanAvx2(const uint8_t *start, size_t count, const struct Pattern *pattern, const uint8_t **position) {
+    const __m256i anchor = _mm256_set1_epi8((char) pattern->bytes[pattern->anchor]);
+    const __m256i second = _mm256_set1_epi8((char) pattern->bytes[pattern->second]);
+    size_t offset = 0;
+
+    for (; offset + 32 <= count; offset += 32) {
+        const uint8_t *current = start + offset;
+        __m256i a = _mm256_loadu_si256((const __m256i *) (current + pattern->anchor));
+        __m256i b = _mm256_loadu_si256((const __m256i *) (current + pattern->second));
+        uint32_t mask = (uint32_t) _mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpeq_epi8(a, anchor), _mm256_cmpeq_epi8(b, second)));
+
+        while (mask) {
+            const uint8_t *candidate = current + CountTrailingZeros(mask);
+            if (MatchPattern(candidate, pattern)) {
+                *position = candidate;
+                return 1;
+            }
+            mask &= mask - 1;
+        }
+    }
+
+    return ScanSse2(start + offset, count - offset, pattern, position);
+}
+
+static _Bool HasAvx2(void) {
+    static int supported = -1;
+
+    if (supported < 0) {
+#ifdef _MSC_VER
+        int info[4];
+        __cpuid(info, 0);
+        supported = 0;
+        if (info[0] >= 7) {
+            __cpuid(info, 1);
+            // OSXSAVE and AVX, then check that the OS saves YMM state
+            if ((info[2] & (1 << 27)) && (info[2] & (1 << 28)) && (_xgetbv(0) & 6) == 6) {
+                __cpuidex(info, 7, 0);
+                supported = (info[1] & (1 << 5)) != 0;
+            }
+        }
+#else
+        __builtin_cpu_init();
+        supported = __builtin_cpu_supports("avx2") != 0;
+#endif
+    }
+
+    return supported;
+}
+
+#endif
+
+_Bool FindCompiledPattern(const void *start, const void *end, const struct Pattern *pattern, void **position) {
+    const uint8_t *begin = start;
+    const uint8_t *found;
+
+    if (begin >= (const uint8_t *) end || (size_t) ((const uint8_t *) end - begin) < pattern->length)
+        return 0;
+
+    // Number of positions where the whole pattern still fits before `end`
+    size_t count = (size_t) ((const uint8_t *) end - begin) - pattern->length + 1;
+
+    if (!pattern->mask[pattern->anchor]) {
+        // Nothing but wildcards, matches right away
+        *position = (void *) begin;
+        return 1;
+    }
+
+#if defined(SCAN_AVX2)
+    if (HasAvx2() ? ScanAvx2(begin, count, pattern, &found) : ScanSse2(begin, count, pattern, &found)) {
+#elif defined(SCAN_SSE2)
+    if (ScanSse2(begin, count, pattern, &found)) {
+#else
+    if (ScanHorspool(begin, count, pattern, &found)) {
+#endif
+        *position = (void *) found;
+        return 1;
+    }
+
+    return 0;
+}
+
+_Bool FindPattern(void *start, const void *end, const char *pattern, void **position) {
+    struct Pattern compiled;
+
+    if (!CompilePattern(pattern, &compiled))
+        return 0;
+
+    return FindCompiledPattern(start, end, &compiled, position);
+}
+
+struct ParallelScan {
+    const uint8_t *start;
+    const struct Pattern *pattern;
+    size_t count; ///< Number of candidate positions
+    size_t num_chunks;
+    volatile size_t next_chunk;
+    volatile size_t best; ///< Lowest matching offset found so far, or SIZE_MAX
+};
+
+static void ScanChunks(void *context, unsigned index) {
+    struct ParallelScan *scan = context;
+    (void) index;
+
+    for (;;) {
+        size_t chunk = AtomicFetchAdd(&scan->next_chunk, 1);
+        size_t first = chunk * SCAN_CHUNK_SIZE;
+
+        // Chunks are handed out in address order, so once a match precedes this chunk nothing after it can win
+        if (chunk >= scan->num_chunks || first >= AtomicLoad(&scan->best))
+            return;
+
+        size_t last = first + SCAN_CHUNK_SIZE < scan->count ? first + SCAN_CHUNK_SIZE : scan->count;
+        void *position;
+
+        // Chunks overlap by the pattern length minus one so that a match straddling the boundary is kept
+        if (!FindCompiledPattern(scan->start + first, scan->start + last + scan->pattern->length - 1, scan->pattern, &position))
+            continue;
+
+        size_t offset = (size_t) ((const uint8_t *) position - scan->start);
+        size_t best = AtomicLoad(&scan->best);
+
+        while (offset < best && !AtomicCompareExchange(&scan->best, best, offset))
+            best = AtomicLoad(&scan->best);
+    }
+}
+
+_Bool FindCompiledPatternParallel(const void *start, const void *end, const struct Pattern *pattern, unsigned threads, void **position) {
+    const uint8_t *begin = start;
+
+    if (begin >= (const uint8_t *) end || (size_t) ((const uint8_t *) end - begin) < pattern->length)
+        return 0;
+
+    struct ParallelScan scan = {
+            .start = begin,
+            .pattern = pattern,
+            .count = (size_t) ((const uint8_t *) end - begin) - pattern->length + 1,
+            .next_chunk = 0,
+            .best = SIZE_MAX,
+    };
+
+    scan.num_chunks = (scan.count + SCAN_CHUNK_SIZE - 1) / SCAN_CHUNK_SIZE;
+
+    if (threads == 0)
+        threads = ThreadCount();
+    if (threads > scan.num_chunks)
+        threads = (unsigned) scan.num_chunks;
+
+    if (threads <= 1)
+        return FindCompiledPattern(start, end, pattern, position);
+
+    ThreadRunParallel(threads, ScanChunks, &scan);
+
+    if (scan.best == SIZE_MAX)
+        return 0;
+
+    *position = (void *) (begin + scan.best);
+    return 1;
+}
+
+_Bool FindPatternParallel(void *start, const void *end, const char *pattern, unsigned threads, void **position) {
+    struct Pattern compiled;
+
+    if (!CompilePattern(pattern, &compiled))
+        return 0;
+
+    return FindCompiledPatternParallel(start, end, &compiled, threads, position);
+}
+
+static void RecordMatch(struct Signature *signature, const uint8_t *position) {
+    if (signature->count < SIGNATURE_MAX_MATCHES)
+        signature->matches[signature->count] = (void *) position;
+    signature->count++;
+}
+
+static void CheckAnchor(const uint8_t *start, size_t size, size_t offset, struct Signature *signatures, const int *head, const int *next) {
+    for (int index = head[start[offset]]; index >= 0; index = next[index]) {
+        struct Signature *signature = &signatures[index];
+        const struct Pattern *pattern = &signature->compiled;
+
+        if (offset < pattern->anchor || size - (offset - pattern->anchor) < pattern->length)
+            continue;
+
+        if (MatchPattern(start + offset - pattern->anchor, pattern))
+            RecordMatch(signature, start + offset - pattern->anchor);
+    }
+}
+
+#ifdef SCAN_SSE2
+
+/// Tests every signature against each block of 16 candidate positions using its two rarest bytes.
+/// Returns the offset of the first candidate position left for the scalar tail.
+static size_t ScanSignaturesSse2(const uint8_t *start, size_t size, struct Signature *signatures, size_t count) {
+    __m128i anchors[SIGNATURES_MAX_SIMD];
+    __m128i seconds[SIGNATURES_MAX_SIMD];
+    size_t reach = 0;
+    size_t offset = 0;
+
+    for (size_t i = 0; i < count; i++) {
+        const struct Pattern *pattern = &signatures[i].compiled;
+        anchors[i] = _mm_set1_epi8((char) pattern->bytes[pattern->anchor]);
+        seconds[i] = _mm_set1_epi8((char) pattern->bytes[pattern->second]);
+        if (pattern->length > reach)
+            reach = pattern->length;
+    }
+
+    for (; size >= reach && offset + 16 <= size - reach + 1; offset += 16) {
+        const uint8_t *current = start + offset;
+
+        for (size_t i = 0; i < count; i++) {
+            const struct Pattern *pattern = &signatures[i].compiled;
+            __m128i a = _mm_loadu_si128((const __m128i *) (current + pattern->anchor));
+            __m128i b = _mm_loadu_si128((const __m128i *) (current + pattern->second));
+            uint32_t mask = (uint32_t) _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(a, anchors[i]), _mm_cmpeq_epi8(b, seconds[i])));
+
+            while (mask) {
+                const uint8_t *candidate = current + CountTrailingZeros(mask);
+                if (MatchPattern(candidate, pattern))
+                    RecordMatch(&signatures[i], candidate);
+                mask &= mask - 1;
+            }
+        }
+    }
+
+    return offset;
+}
+
+#endif
+
+#ifdef SCAN_AVX2
+
+SCAN_TARGET_AVX2
+static size_t ScanSignaturesAvx2(const uint8_t *start, size_t size, struct Signature *signatures, size_t count) {
+    __m256i anchors[SIGNATURES_MAX_SIMD];
+    __m256i seconds[SIGNATURES_MAX_SIMD];
+    size_t reach = 0;
+    size_t offset = 0;
+
+    for (size_t i = 0; i < count; i++) {
+        const struct Pattern *pattern = &signatures[i].compiled;
+        anchors[i] = _mm256_set1_epi8((char) pattern->bytes[pattern->anchor]);
+        seconds[i] = _mm256_set1_epi8((char) pattern->bytes[pattern->second]);
+        if (pattern->length > reach)
+            reach = pattern->length;
+    }
+
+    for (; size >= reach && offset + 32 <= size - reach + 1; offset += 32) {
+        const uint8_t *current = start + offset;
+
+        for (size_t i = 0; i < count; i++) {
+            const struct Pattern *pattern = &signatures[i].compiled;
+            __m256i a = _mm256_loadu_si256((const __m256i *) (current + pattern->anchor));
+            __m256i b = _mm256_loadu_si256((const __m256i *) (current + pattern->second));
+            uint32_t mask = (uint32_t) _mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpeq_epi8(a, anchors[i]), _mm256_cmpeq_epi8(b, seconds[i])));
+
+            while (mask) {
+                const uint8_t *candidate = current + CountTrailingZeros(mask);
+                if (MatchPattern(candidate, pattern))
+                    RecordMatch(&signatures[i], candidate);
+                mask &= mask - 1;
+            }
+        }
+    }
+
+    return offset + ScanSignaturesSse2(start + offset, size - offset, signatures, count);
+}
+
+#endif
+
+_Bool FindPatterns(const struct Section *section, struct Signature *signatures, size_t count) {
+    const uint8_t *start = section->start;
+    size_t size = section->start < section->end ? (size_t) ((uint8_t *) section->end - start) : 0;
+    _Bool wildcards = 0;
+
+    for (size_t i = 0; i < count; i++) {
+        signatures[i].count = 0;
+
+        if (!CompilePattern(signatures[i].pattern, &signatures[i].compiled))
+            return 0;
+
+        if (!signatures[i].compiled.mask[signatures[i].compiled.anchor])
+            wildcards = 1;
+    }
+
+    size_t offset = 0;
+
+#ifdef SCAN_SSE2
+    // A handful of signatures is cheaper to test side by side in registers than through the anchor table
+    if (count <= SIGNATURES_MAX_SIMD && !wildcards) {
+#ifdef SCAN_AVX2
+        offset = HasAvx2() ? ScanSignaturesAvx2(start, size, signatures, count) : ScanSignaturesSse2(start, size, signatures, count);
+#else
+        offset = ScanSignaturesSse2(start, size, signatures, count);
+#endif
+
+        for (; offset < size; offset++) {
+            for (size_t i = 0; i < count; i++) {
+                if (size - offset >= signatures[i].compiled.length && MatchPattern(start + offset, &signatures[i].compiled))
+                    RecordMatch(&signatures[i], start + offset);
+            }
+        }
+
+        return 1;
+    }
+#endif
+
+    int head[256];
+    int *next = malloc(count * sizeof(int));
+
+    if (next == NULL)
+        return 0;
+
+    for (size_t i = 0; i < 256; i++)
+        head[i] = -1;
+
+    // Bucket the signatures by their anchor byte so that a single sweep serves all of them
+    for (size_t i = 0; i < count; i++) {
+        const struct Pattern *pattern = &signatures[i].compiled;
+
+        if (!pattern->mask[pattern->anchor]) {
+            // Nothing but wildcards, matches every position
+            for (offset = 0; size >= pattern->length && offset <= size - pattern->length; offset++)
+                RecordMatch(&signatures[i], start + offset);
+            next[i] = -1;
+            continue;
+        }
+
+        next[i] = head[pattern->bytes[pattern->anchor]];
+        head[pattern->bytes[pattern->anchor]] = (int) i;
+    }
+
+    for (offset = 0; offset < size; offset++) {
+        if (head[start[offset]] >= 0)
+            CheckAnchor(start, size, offset, signatures, head, next);
+    }
+
+    free(next);
+    return 1;
+}
@@ -0,0 +1,168 @@
+#include "sort.h"
+#include "arena.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SORT_INSERTION_THRESHOLD 32
+
+struct SortKey {
+    uint64_t prefix; ///< Name bytes at the current depth, big-endian so that integer order is strcmp order
+    uint64_t order;
+    const char *name;
+    struct RTTI *rtti;
+};
+
+int RTTIKind_Order(struct RTTI *rtti) {
+    switch (rtti->kind) {
+        case RTTIKind_Compound:
+            return 0;
+        case RTTIKind_Enum:
+            return 1;
+        case RTTIKind_EnumFlags:
+            return 2;
+        case RTTIKind_Atom:
+            return 3;
+        default:
+            return 4;
+    }
+}
+
+int RTTIKind_CompareLexical(const void *a, const void *b) {
+    struct RTTI *a_rtti = *(struct RTTI **) a;
+    struct RTTI *b_rtti = *(struct RTTI **) b;
+
+    int order_a = RTTIKind_Order(a_rtti);
+    int order_b = RTTIKind_Order(b_rtti);
+
+    if (order_a != order_b)
+        return order_a - order_b;
+
+    return strcmp(RTTI_Name(a_rtti), RTTI_Name(b_rtti));
+}
+
+/// Reads up to 8 bytes of the name from `depth` on, zero padded past its end.
+static void LoadPrefix(struct SortKey *key, size_t depth) {
+    const unsigned char *name = (const unsigned char *) key->name + depth;
+    uint64_t prefix = 0;
+    size_t length = 0;
+
+    for (; length < 8 && name[length]; length++)
+        prefix |= (uint64_t) name[length] << (56 - length * 8);
+
+    key->prefix = prefix;
+}
+
+static _Bool KeyLess(const struct SortKey *a, const struct SortKey *b, size_t depth) {
+    if (a->order != b->order)
+        return a->order < b->order;
+    if (a->prefix != b->prefix)
+        return a->prefix < b->prefix;
+    return strcmp(a->name + depth, b->name + depth) < 0;
+}
+
+static void InsertionSort(struct SortKey *keys, size_t count, size_t depth) {
+    for (size_t i = 1; i < count; i++) {
+        struct SortKey key = keys[i];
+        size_t j = i;
+
+        while (j > 0 && KeyLess(&key, &keys[j - 1], depth)) {
+            keys[j] = keys[j - 1];
+            j--;
+        }
+
+        keys[j] = key;
+    }
+}
+
+static unsigned RadixByte(const struct SortKey *key, size_t pass) {
+    return pass < 8 ? (unsigned) (key->prefix >> (pass * 8)) & 0xFF : (unsigned) key->order & 0xFF;
+}
+
+/// LSD radix sort over the 8 prefix bytes and the kind order as the most significant byte.
+/// Passes where every key has the same byte are skipped.
+static void RadixSort(struct SortKey *keys, struct SortKey *scratch, size_t count) {
+    size_t histogram[9][256] = {{0}};
+    struct SortKey *source = keys;
+    struct SortKey *target = scratch;
+
+    for (size_t i = 0; i < count; i++) {
+        for (size_t pass = 0; pass < 9; pass++)
+            histogram[pass][RadixByte(&keys[i], pass)]++;
+    }
+
+    for (size_t pass = 0; pass < 9; pass++) {
+        size_t *offsets = histogram[pass];
+        size_t offset = 0;
+
+        if (offsets[RadixByte(&source[0], pass)] == count)
+            continue;
+
+        for (size_t value = 0; value < 256; value++) {
+            size_t bucket = offsets[value];
+            offsets[value] = offset;
+            offset += bucket;
+        }
+
+        for (size_t i = 0; i < count; i++)
+            target[offsets[RadixByte(&source[i], pass)]++] = source[i];
+
+        struct SortKey *swap = source;
+        source = target;
+        target = swap;
+    }
+
+    if (source != keys)
+        memcpy(keys, source, count * sizeof(struct SortKey));
+}
+
+/// Sorts keys by their name from `depth` on. Runs that still tie on all 8 prefix bytes
+/// are sorted again on the next 8 bytes of their names.
+static void SortRange(struct SortKey *keys, struct SortKey *scratch, size_t count, size_t depth) {
+    if (count < SORT_INSERTION_THRESHOLD) {
+        InsertionSort(keys, count, depth);
+        return;
+    }
+
+    RadixSort(keys, scratch, count);
+
+    for (size_t start = 0; start < count;) {
+        size_t end = start + 1;
+
+        while (end < count && keys[end].order == keys[start].order && keys[end].prefix == keys[start].prefix)
+            end++;
+
+        // A zero last byte means the names ended within the prefix, so the whole run is made of equal names
+        if (end - start > 1 && (keys[start].prefix & 0xFF) != 0) {
+            for (size_t i = start; i < end; i++)
+                LoadPrefix(&keys[i], depth + 8);
+
+            SortRange(keys + start, scratch, end - start, depth + 8);
+        }
+
+        start = end;
+    }
+}
+
+_Bool SortTypes(struct RTTI **types, size_t count) {
+    struct SortKey *keys = SessionAlloc(count * sizeof(struct SortKey), sizeof(uint64_t));
+    struct SortKey *scratch = SessionAlloc(count * sizeof(struct SortKey), sizeof(uint64_t));
+
+    if (keys == NULL || scratch == NULL)
+        return 0;
+
+    for (size_t i = 0; i < count; i++) {
+        keys[i].order = (uint64_t) RTTIKind_Order(types[i]);
+        keys[i].name = RTTI_Name(types[i]);
+        keys[i].rtti = types[i];
+        LoadPrefix(&keys[i], 0);
+    }
+
+    SortRange(keys, scratch, count, 0);
+
+    for (size_t i = 0; i < count; i++)
+        types[i] = keys[i].rtti;
+
+    return 1;
+}
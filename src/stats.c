@@ -0,0 +1,173 @@
+#include "stats.h"
+
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+struct StatsPhase {
+    const char *name;
+    uint64_t duration;
+    uint64_t runs;
+};
+
+struct StatsCounter {
+    const char *name;
+    uint64_t value;
+};
+
+struct StatsEvent {
+    const char *name;
+    uint64_t start;
+    uint64_t duration;
+};
+
+struct Stats {
+    uint64_t origin; ///< Time of the first measurement, trace timestamps are relative to it
+    struct StatsPhase phases[STATS_MAX_PHASES];
+    size_t num_phases;
+    struct StatsCounter counters[STATS_MAX_COUNTERS];
+    size_t num_counters;
+    struct StatsEvent events[STATS_MAX_EVENTS];
+    size_t num_events;
+    size_t dropped_events;
+};
+
+static struct Stats g_stats;
+
+uint64_t StatsNow(void) {
+#ifdef _WIN32
+    static LARGE_INTEGER frequency;
+    LARGE_INTEGER counter;
+
+    if (frequency.QuadPart == 0)
+        QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+
+    uint64_t ticks = (uint64_t) counter.QuadPart;
+    uint64_t rate = (uint64_t) frequency.QuadPart;
+    return ticks / rate * 1000000000ull + ticks % rate * 1000000000ull / rate;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ull + (uint64_t) ts.tv_nsec;
+#endif
+}
+
+static _Bool SameName(const char *a, const char *b) {
+    return a == b || strcmp(a, b) == 0;
+}
+
+struct StatsTimer StatsBegin(const char *name) {
+    struct StatsTimer timer = {name, StatsNow()};
+
+    if (g_stats.origin == 0)
+        g_stats.origin = timer.start;
+
+    return timer;
+}
+
+void StatsEnd(struct StatsTimer timer) {
+    uint64_t duration = StatsNow() - timer.start;
+    struct StatsPhase *phase = NULL;
+
+    for (size_t i = 0; i < g_stats.num_phases && phase == NULL; i++) {
+        if (SameName(g_stats.phases[i].name, timer.name))
+            phase = &g_stats.phases[i];
+    }
+
+    if (phase == NULL && g_stats.num_phases < STATS_MAX_PHASES) {
+        phase = &g_stats.phases[g_stats.num_phases++];
+        phase->name = timer.name;
+    }
+
+    if (phase != NULL) {
+        phase->duration += duration;
+        phase->runs++;
+    }
+
+    if (g_stats.num_events < STATS_MAX_EVENTS)
+        g_stats.events[g_stats.num_events++] = (struct StatsEvent) {timer.name, timer.start - g_stats.origin, duration};
+    else
+        g_stats.dropped_events++;
+}
+
+static struct StatsCounter *FindCounter(const char *name) {
+    for (size_t i = 0; i < g_stats.num_counters; i++) {
+        if (SameName(g_stats.counters[i].name, name))
+            return &g_stats.counters[i];
+    }
+
+    if (g_stats.num_counters == STATS_MAX_COUNTERS)
+        return NULL;
+
+    struct StatsCounter *counter = &g_stats.counters[g_stats.num_counters++];
+    counter->name = name;
+    counter->value = 0;
+    return counter;
+}
+
+void StatsSet(const char *name, uint64_t value) {
+    struct StatsCounter *counter = FindCounter(name);
+
+    if (counter != NULL)
+        counter->value = value;
+}
+
+void StatsAdd(const char *name, uint64_t value) {
+    struct StatsCounter *counter = FindCounter(name);
+
+    if (counter != NULL)
+        counter->value += value;
+}
+
+void StatsExport(struct JsonContext *ctx) {
+    JsonBeginObject(ctx);
+
+    JsonNameObject(ctx, "phases");
+    for (size_t i = 0; i < g_stats.num_phases; i++) {
+        JsonNameCompactObject(ctx, g_stats.phases[i].name);
+        JsonNameValueUnsigned(ctx, "us", g_stats.phases[i].duration / 1000);
+        JsonNameValueUnsigned(ctx, "runs", g_stats.phases[i].runs);
+        JsonEndCompactObject(ctx);
+    }
+    JsonEndObject(ctx);
+
+    JsonNameObject(ctx, "counters");
+    for (size_t i = 0; i < g_stats.num_counters; i++)
+        JsonNameValueUnsigned(ctx, g_stats.counters[i].name, g_stats.counters[i].value);
+    JsonEndObject(ctx);
+
+    JsonEndObject(ctx);
+}
+
+void StatsWriteTrace(FILE *file) {
+    struct JsonContext ctx;
+
+    JsonInit(&ctx, file);
+    JsonBeginObject(&ctx);
+    JsonNameValueStr(&ctx, "displayTimeUnit", "ms");
+    JsonNameValueUnsigned(&ctx, "droppedEvents", g_stats.dropped_events);
+
+    JsonNameArray(&ctx, "traceEvents");
+    for (size_t i = 0; i < g_stats.num_events; i++) {
+        const struct StatsEvent *event = &g_stats.events[i];
+
+        // Complete events, timestamps and durations in microseconds
+        JsonBeginCompactObject(&ctx);
+        JsonNameValueStr(&ctx, "name", event->name);
+        JsonNameValueStr(&ctx, "ph", "X");
+        JsonNameValueUnsigned(&ctx, "ts", event->start / 1000);
+        JsonNameValueUnsigned(&ctx, "dur", event->duration / 1000);
+        JsonNameValueNum(&ctx, "pid", 1);
+        JsonNameValueNum(&ctx, "tid", 1);
+        JsonEndCompactObject(&ctx);
+    }
+    JsonEndArray(&ctx);
+
+    JsonEndObject(&ctx);
+    JsonFinish(&ctx);
+}
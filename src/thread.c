@@ -0,0 +1,126 @@
+#include "thread.h"
+
+#include <stdlib.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+struct ThreadStart {
+    void (*proc)(void *);
+    void *argument;
+};
+
+#ifdef _WIN32
+static DWORD WINAPI ThreadMain(LPVOID parameter) {
+#else
+static void *ThreadMain(void *parameter) {
+#endif
+    struct ThreadStart start = *(struct ThreadStart *) parameter;
+    free(parameter);
+    start.proc(start.argument);
+    return 0;
+}
+
+_Bool ThreadStart(struct Thread *thread, void (*proc)(void *), void *argument) {
+    struct ThreadStart *start = malloc(sizeof(struct ThreadStart));
+
+    if (start == NULL)
+        return 0;
+
+    start->proc = proc;
+    start->argument = argument;
+
+#ifdef _WIN32
+    thread->handle = CreateThread(NULL, 0, ThreadMain, start, 0, NULL);
+    if (thread->handle == NULL) {
+        free(start);
+        return 0;
+    }
+#else
+    pthread_t handle;
+    if (pthread_create(&handle, NULL, ThreadMain, start) != 0) {
+        free(start);
+        return 0;
+    }
+    thread->handle = (void *) (uintptr_t) handle;
+#endif
+
+    return 1;
+}
+
+void ThreadJoin(struct Thread *thread) {
+#ifdef _WIN32
+    WaitForSingleObject(thread->handle, INFINITE);
+    CloseHandle(thread->handle);
+#else
+    pthread_join((pthread_t) (uintptr_t) thread->handle, NULL);
+#endif
+    thread->handle = NULL;
+}
+
+unsigned ThreadCount(void) {
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwNumberOfProcessors ? (unsigned) info.dwNumberOfProcessors : 1;
+#else
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return count > 0 ? (unsigned) count : 1;
+#endif
+}
+
+void ThreadSleep(unsigned milliseconds) {
+#ifdef _WIN32
+    Sleep(milliseconds);
+#else
+    if (milliseconds == 0) {
+        sched_yield();
+    } else {
+        struct timespec duration = {milliseconds / 1000, (long) (milliseconds % 1000) * 1000000};
+        nanosleep(&duration, NULL);
+    }
+#endif
+}
+
+struct ParallelTask {
+    void (*proc)(void *, unsigned);
+    void *context;
+    unsigned index;
+};
+
+static void RunTask(void *argument) {
+    struct ParallelTask *task = argument;
+    task->proc(task->context, task->index);
+}
+
+void ThreadRunParallel(unsigned threads, void (*proc)(void *context, unsigned index), void *context) {
+    struct ParallelTask tasks[THREAD_MAX_WORKERS];
+    struct Thread workers[THREAD_MAX_WORKERS];
+    _Bool started[THREAD_MAX_WORKERS];
+
+    if (threads == 0)
+        threads = 1;
+    if (threads > THREAD_MAX_WORKERS)
+        threads = THREAD_MAX_WORKERS;
+
+    for (unsigned i = 1; i < threads; i++) {
+        tasks[i] = (struct ParallelTask) {proc, context, i};
+        started[i] = ThreadStart(&workers[i], RunTask, &tasks[i]);
+    }
+
+    proc(context, 0);
+
+    // Whatever failed to start runs on the calling thread
+    for (unsigned i = 1; i < threads; i++) {
+        if (started[i])
+            ThreadJoin(&workers[i]);
+        else
+            proc(context, i);
+    }
+}
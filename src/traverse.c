@@ -0,0 +1,148 @@
+#include "traverse.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <xmmintrin.h>
+#define PREFETCH(_Ptr) _mm_prefetch((const char *) (_Ptr), _MM_HINT_T0)
+#elif defined(__GNUC__)
+#define PREFETCH(_Ptr) __builtin_prefetch(_Ptr)
+#else
+#define PREFETCH(_Ptr) ((void) (_Ptr))
+#endif
+
+_Bool TraversalInit(struct Traversal *traversal, size_t capacity, void (*visit)(struct RTTI *, void *), void *context) {
+    memset(traversal, 0, sizeof(*traversal));
+
+    if (!TypeSetInit(&traversal->visited, capacity)) {
+        traversal->failed = 1;
+        return 0;
+    }
+
+    traversal->capacity = 1024;
+    traversal->stack = malloc(traversal->capacity * sizeof(struct RTTI *));
+    traversal->visit = visit;
+    traversal->context = context;
+
+    if (traversal->stack == NULL) {
+        TraversalFree(traversal);
+        traversal->failed = 1;
+        return 0;
+    }
+
+    return 1;
+}
+
+void TraversalFree(struct Traversal *traversal) {
+    TypeSetFree(&traversal->visited);
+    free(traversal->stack);
+    memset(traversal, 0, sizeof(*traversal));
+}
+
+static _Bool Reserve(struct Traversal *traversal, size_t count) {
+    if (traversal->capacity - traversal->depth >= count)
+        return 1;
+
+    size_t capacity = traversal->capacity * 2;
+    while (capacity - traversal->depth < count)
+        capacity *= 2;
+
+    struct RTTI **stack = realloc(traversal->stack, capacity * sizeof(struct RTTI *));
+    if (stack == NULL) {
+        traversal->failed = 1;
+        return 0;
+    }
+
+    traversal->stack = stack;
+    traversal->capacity = capacity;
+    return 1;
+}
+
+/// Pushes an edge target unless it is already known, and starts pulling it into the cache
+/// so that it is resident by the time it is popped.
+static void Push(struct Traversal *traversal, struct RTTI *rtti) {
+    if (rtti == NULL || TypeSetContains(&traversal->visited, rtti))
+        return;
+
+    PREFETCH(rtti);
+    traversal->stack[traversal->depth++] = rtti;
+}
+
+/// Pushes the edges of a type in reverse, so that they are popped in declaration order.
+static void PushEdges(struct Traversal *traversal, struct RTTI *rtti) {
+    union {
+        struct RTTIContainer *container;
+        struct RTTIPointer *pointer;
+        struct RTTIAtom *atom;
+        struct RTTICompound *compound;
+        struct RTTIEnum *enumeration;
+    } object;
+
+    if (RTTI_AsContainer(rtti, &object.container)) {
+        if (Reserve(traversal, 1))
+            Push(traversal, object.container->mItemType);
+    } else if (RTTI_AsPointer(rtti, &object.pointer)) {
+        if (Reserve(traversal, 1))
+            Push(traversal, object.pointer->mItemType);
+    } else if (RTTI_AsAtom(rtti, &object.atom)) {
+        if (Reserve(traversal, 2)) {
+            Push(traversal, object.atom->representation_type);
+            Push(traversal, object.atom->mBaseType);
+        }
+    } else if (RTTI_AsEnum(rtti, &object.enumeration)) {
+        if (Reserve(traversal, 1))
+            Push(traversal, object.enumeration->representation_type);
+    } else if (RTTI_AsCompound(rtti, &object.compound)) {
+        struct RTTICompound *compound = object.compound;
+        size_t count = 1 + compound->mNumBases + compound->mNumAttrs + compound->mNumMessageHandlers + compound->mNumMessageOrderEntries * 2;
+
+        if (!Reserve(traversal, count))
+            return;
+
+        Push(traversal, compound->representation_type);
+        for (int index = compound->mNumMessageOrderEntries - 1; index >= 0; index--) {
+            Push(traversal, compound->mMessageOrderEntries[index].mCompound);
+            Push(traversal, compound->mMessageOrderEntries[index].mMessage);
+        }
+        for (int index = compound->mNumMessageHandlers - 1; index >= 0; index--)
+            Push(traversal, compound->mMessageHandlers[index].mMessage);
+        for (int index = compound->mNumAttrs - 1; index >= 0; index--)
+            Push(traversal, compound->mAttrs[index].type);
+        for (int index = compound->mNumBases - 1; index >= 0; index--)
+            Push(traversal, compound->mBases[index].mType);
+    }
+}
+
+_Bool TraversalAdd(struct Traversal *traversal, struct RTTI *root) {
+    if (traversal->failed)
+        return 0;
+    if (root == NULL || TypeSetContains(&traversal->visited, root))
+        return 1;
+    if (!Reserve(traversal, 1))
+        return 0;
+
+    traversal->stack[traversal->depth++] = root;
+
+    while (traversal->depth && !traversal->failed) {
+        struct RTTI *rtti = traversal->stack[--traversal->depth];
+
+        // The same type may have been pushed from several places before it was reached
+        if (!TypeSetInsert(&traversal->visited, rtti)) {
+            traversal->failed = traversal->visited.failed;
+            continue;
+        }
+
+        if (traversal->visit)
+            traversal->visit(rtti, traversal->context);
+
+        PushEdges(traversal, rtti);
+
+        if (traversal->depth)
+            PREFETCH(traversal->stack[traversal->depth - 1]);
+    }
+
+    // Types left on the stack would be missing their subgraphs, the walk cannot be resumed
+    traversal->depth = 0;
+    return !traversal->failed;
+}
@@ -0,0 +1,431 @@
+#include "typedb.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+struct Buffer {
+    uint8_t *data;
+    size_t length;
+    size_t capacity;
+};
+
+struct StringTable {
+    struct Buffer data;
+    uint32_t *slots; ///< Offset + 1 of the interned string, 0 for an empty slot
+    size_t num_slots;
+    size_t count;
+};
+
+struct Writer {
+    struct Buffer types;
+    struct Buffer attrs;
+    struct Buffer bases;
+    struct Buffer values;
+    struct Buffer messages;
+    struct StringTable strings;
+    _Bool failed;
+};
+
+static void *BufferAppend(struct Writer *writer, struct Buffer *buffer, const void *data, size_t size) {
+    if (buffer->capacity - buffer->length < size) {
+        size_t capacity = buffer->capacity ? buffer->capacity : 4096;
+        while (capacity - buffer->length < size)
+            capacity *= 2;
+
+        uint8_t *grown = realloc(buffer->data, capacity);
+        if (grown == NULL) {
+            writer->failed = 1;
+            return NULL;
+        }
+
+        buffer->data = grown;
+        buffer->capacity = capacity;
+    }
+
+    void *position = buffer->data + buffer->length;
+    memcpy(position, data, size);
+    buffer->length += size;
+    return position;
+}
+
+#define HASH_BASIS 0xCBF29CE484222325ull
+
+static uint64_t HashBytes(uint64_t hash, const void *data, size_t size) {
+    const uint8_t *bytes = data;
+
+    for (size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= 0x100000001B3ull;
+    }
+
+    return hash;
+}
+
+static uint64_t HashString(const char *string) {
+    return HashBytes(HASH_BASIS, string, strlen(string));
+}
+
+/// Mixes the string along with its terminator, so that adjacent strings cannot run into each other.
+/// NULL hashes differently from the empty string.
+static uint64_t HashField(uint64_t hash, const char *string) {
+    if (string == NULL)
+        return HashBytes(hash, "\xFF", 1);
+
+    return HashBytes(hash, string, strlen(string) + 1);
+}
+
+static uint64_t HashNumber(uint64_t hash, uint64_t value) {
+    return HashBytes(hash, &value, sizeof(value));
+}
+
+static _Bool GrowStrings(struct StringTable *table) {
+    size_t num_slots = table->num_slots ? table->num_slots * 2 : 4096;
+    uint32_t *slots = calloc(num_slots, sizeof(uint32_t));
+
+    if (slots == NULL)
+        return 0;
+
+    for (size_t i = 0; i < table->num_slots; i++) {
+        if (!table->slots[i])
+            continue;
+
+        size_t slot = HashString((const char *) table->data.data + table->slots[i] - 1) & (num_slots - 1);
+        while (slots[slot])
+            slot = (slot + 1) & (num_slots - 1);
+        slots[slot] = table->slots[i];
+    }
+
+    free(table->slots);
+    table->slots = slots;
+    table->num_slots = num_slots;
+    return 1;
+}
+
+static uint32_t Intern(struct Writer *writer, const char *string) {
+    struct StringTable *table = &writer->strings;
+
+    if (string == NULL)
+        return TYPEDB_NONE;
+
+    if (table->count * 2 >= table->num_slots && !GrowStrings(table)) {
+        writer->failed = 1;
+        return TYPEDB_NONE;
+    }
+
+    size_t slot = HashString(string) & (table->num_slots - 1);
+
+    while (table->slots[slot]) {
+        if (strcmp((const char *) table->data.data + table->slots[slot] - 1, string) == 0)
+            return table->slots[slot] - 1;
+        slot = (slot + 1) & (table->num_slots - 1);
+    }
+
+    uint32_t offset = (uint32_t) table->data.length;
+    if (BufferAppend(writer, &table->data, string, strlen(string) + 1) == NULL)
+        return TYPEDB_NONE;
+
+    table->slots[slot] = offset + 1;
+    table->count++;
+    return offset;
+}
+
+static void AddType(struct Writer *writer, struct RTTI *rtti) {
+    struct RTTICompound *compound;
+    struct RTTIEnum *enumeration;
+    struct RTTIAtom *atom;
+    struct TypeDbType record = {0};
+    uint64_t hash = HASH_BASIS;
+
+    record.name = Intern(writer, RTTI_DisplayName(rtti));
+    record.kind = rtti->kind;
+    record.base_type = TYPEDB_NONE;
+    record.first_attr = (uint32_t) (writer->attrs.length / sizeof(struct TypeDbAttr));
+    record.first_base = (uint32_t) (writer->bases.length / sizeof(struct TypeDbBase));
+    record.first_value = (uint32_t) (writer->values.length / sizeof(struct TypeDbValue));
+    record.first_message = (uint32_t) (writer->messages.length / sizeof(uint32_t));
+
+    hash = HashNumber(hash, rtti->kind);
+
+    if (RTTI_AsCompound(rtti, &compound)) {
+        record.flags = compound->mFlags;
+        record.version = compound->mVersion;
+        record.size = compound->mSize;
+
+        for (int i = 0; i < compound->mNumMessageHandlers; i++) {
+            const char *name = RTTI_DisplayName(compound->mMessageHandlers[i].mMessage);
+            uint32_t message = Intern(writer, name);
+            BufferAppend(writer, &writer->messages, &message, sizeof(message));
+            hash = HashField(hash, name);
+        }
+
+        for (int i = 0; i < compound->mNumBases; i++) {
+            const char *name = RTTI_DisplayName(compound->mBases[i].mType);
+            struct TypeDbBase base = {
+                    .type = Intern(writer, name),
+                    .offset = compound->mBases[i].mOffset,
+            };
+            BufferAppend(writer, &writer->bases, &base, sizeof(base));
+            hash = HashNumber(HashField(hash, name), base.offset);
+        }
+
+        for (int i = 0; i < compound->mNumAttrs; i++) {
+            struct RTTIAttr *attr = &compound->mAttrs[i];
+            struct TypeDbAttr entry = {
+                    .name = Intern(writer, attr->mName),
+                    .type = TYPEDB_NONE,
+                    .min = TYPEDB_NONE,
+                    .max = TYPEDB_NONE,
+            };
+
+            hash = HashField(hash, attr->mName);
+
+            if (attr->type != NULL) {
+                const char *type = RTTI_DisplayName(attr->type);
+                entry.type = Intern(writer, type);
+                entry.offset = attr->mOffset;
+                entry.flags = attr->mFlags;
+                entry.min = Intern(writer, attr->mMinValue);
+                entry.max = Intern(writer, attr->mMaxValue);
+                if (attr->mGetter || attr->mSetter)
+                    entry.attributes |= TYPEDB_ATTR_PROPERTY;
+
+                hash = HashField(HashField(HashField(hash, type), attr->mMinValue), attr->mMaxValue);
+                hash = HashNumber(hash, (uint64_t) entry.offset << 48 | (uint64_t) entry.flags << 32 | entry.attributes);
+            }
+
+            BufferAppend(writer, &writer->attrs, &entry, sizeof(entry));
+        }
+
+        record.num_messages = compound->mNumMessageHandlers;
+        record.num_bases = compound->mNumBases;
+        record.num_attrs = compound->mNumAttrs;
+    } else if (RTTI_AsEnum(rtti, &enumeration)) {
+        record.size = enumeration->size;
+        if (RTTI_EnumSigned(enumeration))
+            record.attributes |= TYPEDB_TYPE_SIGNED;
+
+        for (int i = 0; i < enumeration->num_values; i++) {
+            struct RTTIValue *value = &enumeration->values[i];
+            struct TypeDbValue entry = {
+                    .value = RTTI_EnumNormalize(enumeration, value->mValue),
+                    .name = Intern(writer, value->mName),
+            };
+
+            hash = HashNumber(HashField(hash, value->mName), entry.value);
+
+            for (size_t j = 0; j < 4; j++) {
+                entry.aliases[j] = Intern(writer, value->mAliases[j]);
+                hash = HashField(hash, value->mAliases[j]);
+            }
+
+            BufferAppend(writer, &writer->values, &entry, sizeof(entry));
+        }
+
+        record.num_values = enumeration->num_values;
+    } else if (RTTI_AsAtom(rtti, &atom)) {
+        record.size = atom->mSize;
+        record.base_type = Intern(writer, RTTI_DisplayName(atom->mBaseType));
+        hash = HashField(hash, RTTI_DisplayName(atom->mBaseType));
+    }
+
+    // Counts go in as well, so that moving an entry from one array to another changes the hash
+    hash = HashNumber(hash, (uint64_t) record.attributes << 48 | (uint64_t) record.flags << 32 | record.version);
+    hash = HashNumber(hash, (uint64_t) record.size << 32 | record.num_messages);
+    hash = HashNumber(hash, (uint64_t) record.num_bases << 32 | record.num_attrs);
+    record.hash = HashNumber(hash, record.num_values);
+
+    BufferAppend(writer, &writer->types, &record, sizeof(record));
+}
+
+static uint64_t Align(uint64_t offset) {
+    return (offset + 7) & ~(uint64_t) 7;
+}
+
+static void WriteSection(FILE *file, const struct Buffer *buffer, uint64_t *position) {
+    static const uint8_t padding[8] = {0};
+    uint64_t aligned = Align(*position);
+
+    fwrite(padding, 1, (size_t) (aligned - *position), file);
+    if (buffer->length)
+        fwrite(buffer->data, 1, buffer->length, file);
+    *position = aligned + buffer->length;
+}
+
+/// Builds the name lookup once every name is interned, the string table does not move anymore by then.
+static _Bool BuildNames(struct Writer *writer, struct PerfectHash *names) {
+    const struct TypeDbType *records = (const struct TypeDbType *) writer->types.data;
+    uint32_t num_types = (uint32_t) (writer->types.length / sizeof(struct TypeDbType));
+    const char **keys = malloc(((size_t) num_types + 1) * sizeof(const char *));
+    _Bool built;
+
+    if (keys == NULL)
+        return 0;
+
+    for (uint32_t i = 0; i < num_types; i++)
+        keys[i] = (const char *) writer->strings.data.data + records[i].name;
+
+    built = PerfectHashBuild(names, keys, num_types);
+    free(keys);
+    return built;
+}
+
+_Bool TypeDbWrite(FILE *file, struct RTTI **types, size_t count) {
+    struct Writer writer = {0};
+    struct TypeDbHeader header = {0};
+    struct PerfectHash names = {0};
+
+    for (size_t index = 0; index < count; index++) {
+        enum RTTIKind kind = types[index]->kind;
+        if (kind != RTTIKind_Pointer && kind != RTTIKind_Container && kind != RTTIKind_POD)
+            AddType(&writer, types[index]);
+    }
+
+    if (!writer.failed && !BuildNames(&writer, &names))
+        writer.failed = 1;
+
+    if (!writer.failed) {
+        struct Buffer buckets = {.data = (uint8_t *) names.buckets, .length = names.num_buckets * sizeof(uint32_t)};
+        struct Buffer slots = {.data = (uint8_t *) names.slots, .length = names.num_slots * sizeof(uint32_t)};
+
+        header.magic = TYPEDB_MAGIC;
+        header.version = TYPEDB_VERSION;
+        header.num_types = (uint32_t) (writer.types.length / sizeof(struct TypeDbType));
+        header.num_attrs = (uint32_t) (writer.attrs.length / sizeof(struct TypeDbAttr));
+        header.num_bases = (uint32_t) (writer.bases.length / sizeof(struct TypeDbBase));
+        header.num_values = (uint32_t) (writer.values.length / sizeof(struct TypeDbValue));
+        header.num_messages = (uint32_t) (writer.messages.length / sizeof(uint32_t));
+        header.strings_size = (uint32_t) writer.strings.data.length;
+        header.types_offset = Align(sizeof(header));
+        header.attrs_offset = Align(header.types_offset + writer.types.length);
+        header.bases_offset = Align(header.attrs_offset + writer.attrs.length);
+        header.values_offset = Align(header.bases_offset + writer.bases.length);
+        header.messages_offset = Align(header.values_offset + writer.values.length);
+        header.strings_offset = Align(header.messages_offset + writer.messages.length);
+        header.num_buckets = names.num_buckets;
+        header.num_slots = names.num_slots;
+        header.hash_seed = names.seed;
+        header.buckets_offset = Align(header.strings_offset + writer.strings.data.length);
+        header.slots_offset = Align(header.buckets_offset + buckets.length);
+
+        uint64_t position = sizeof(header);
+        fwrite(&header, sizeof(header), 1, file);
+        WriteSection(file, &writer.types, &position);
+        WriteSection(file, &writer.attrs, &position);
+        WriteSection(file, &writer.bases, &position);
+        WriteSection(file, &writer.values, &position);
+        WriteSection(file, &writer.messages, &position);
+        WriteSection(file, &writer.strings.data, &position);
+        WriteSection(file, &buckets, &position);
+        WriteSection(file, &slots, &position);
+    }
+
+    PerfectHashFree(&names);
+
+    free(writer.types.data);
+    free(writer.attrs.data);
+    free(writer.bases.data);
+    free(writer.values.data);
+    free(writer.messages.data);
+    free(writer.strings.data.data);
+    free(writer.strings.slots);
+
+    return !writer.failed;
+}
+
+static _Bool CheckArray(const struct FileMapping *mapping, uint64_t offset, uint64_t count, size_t size) {
+    return offset <= mapping->size && count <= (mapping->size - offset) / size;
+}
+
+_Bool TypeDbOpen(const char *path, struct TypeDb *db) {
+    memset(db, 0, sizeof(*db));
+
+    if (!MapFile(path, &db->mapping))
+        return 0;
+
+    const struct TypeDbHeader *header = (const struct TypeDbHeader *) db->mapping.data;
+
+    if (db->mapping.size < sizeof(*header)
+        || header->magic != TYPEDB_MAGIC
+        || header->version != TYPEDB_VERSION
+        || !CheckArray(&db->mapping, header->types_offset, header->num_types, sizeof(struct TypeDbType))
+        || !CheckArray(&db->mapping, header->attrs_offset, header->num_attrs, sizeof(struct TypeDbAttr))
+        || !CheckArray(&db->mapping, header->bases_offset, header->num_bases, sizeof(struct TypeDbBase))
+        || !CheckArray(&db->mapping, header->values_offset, header->num_values, sizeof(struct TypeDbValue))
+        || !CheckArray(&db->mapping, header->messages_offset, header->num_messages, sizeof(uint32_t))
+        || !CheckArray(&db->mapping, header->strings_offset, header->strings_size, 1)
+        || !CheckArray(&db->mapping, header->buckets_offset, header->num_buckets, sizeof(uint32_t))
+        || !CheckArray(&db->mapping, header->slots_offset, header->num_slots, sizeof(uint32_t))
+        || header->num_buckets == 0 || header->num_slots > header->num_types
+        || (header->strings_size && db->mapping.data[header->strings_offset + header->strings_size - 1] != '\0')) {
+        TypeDbClose(db);
+        return 0;
+    }
+
+    const struct TypeDbType *types = (const struct TypeDbType *) (db->mapping.data + header->types_offset);
+
+    for (uint32_t i = 0; i < header->num_types; i++) {
+        if (types[i].first_attr > header->num_attrs || types[i].num_attrs > header->num_attrs - types[i].first_attr
+            || types[i].first_base > header->num_bases || types[i].num_bases > header->num_bases - types[i].first_base
+            || types[i].first_value > header->num_values || types[i].num_values > header->num_values - types[i].first_value
+            || types[i].first_message > header->num_messages || types[i].num_messages > header->num_messages - types[i].first_message) {
+            TypeDbClose(db);
+            return 0;
+        }
+    }
+
+    // Lookups index with these without checking, so that a lookup stays one hash and one comparison
+    const uint32_t *buckets = (const uint32_t *) (db->mapping.data + header->buckets_offset);
+    const uint32_t *slots = (const uint32_t *) (db->mapping.data + header->slots_offset);
+
+    for (uint32_t i = 0; i < header->num_buckets; i++) {
+        if (buckets[i] & PERFECT_HASH_DIRECT && (buckets[i] & ~PERFECT_HASH_DIRECT) >= header->num_slots) {
+            TypeDbClose(db);
+            return 0;
+        }
+    }
+
+    for (uint32_t i = 0; i < header->num_slots; i++) {
+        if (slots[i] >= header->num_types || types[slots[i]].name >= header->strings_size) {
+            TypeDbClose(db);
+            return 0;
+        }
+    }
+
+    db->header = header;
+    db->types = (const struct TypeDbType *) (db->mapping.data + header->types_offset);
+    db->attrs = (const struct TypeDbAttr *) (db->mapping.data + header->attrs_offset);
+    db->bases = (const struct TypeDbBase *) (db->mapping.data + header->bases_offset);
+    db->values = (const struct TypeDbValue *) (db->mapping.data + header->values_offset);
+    db->messages = (const uint32_t *) (db->mapping.data + header->messages_offset);
+    db->strings = (const char *) (db->mapping.data + header->strings_offset);
+    db->names = (struct PerfectHash) {
+            .seed = header->hash_seed,
+            .num_buckets = header->num_buckets,
+            .num_slots = header->num_slots,
+            .buckets = buckets,
+            .slots = slots,
+    };
+
+    return 1;
+}
+
+void TypeDbClose(struct TypeDb *db) {
+    UnmapFile(&db->mapping);
+    memset(db, 0, sizeof(*db));
+}
+
+const char *TypeDbString(const struct TypeDb *db, uint32_t offset) {
+    if (offset >= db->header->strings_size)
+        return NULL;
+
+    return db->strings + offset;
+}
+
+const struct TypeDbType *TypeDbFind(const struct TypeDb *db, const char *name) {
+    uint32_t index = PerfectHashLookup(&db->names, name);
+
+    if (index == PERFECT_HASH_NONE || strcmp(db->strings + db->types[index].name, name) != 0)
+        return NULL;
+
+    return &db->types[index];
+}
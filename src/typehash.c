@@ -0,0 +1,328 @@
+#include "typehash.h"
+#include "memo.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define HASH_BASIS 0xCBF29CE484222325ull
+#define HASH_NOMINAL 0x6E6F6D696E616C00ull ///< Marks a type that is referenced by name rather than by structure
+#define HASH_NO_NODE 0xFFFFFFFF
+
+static_assert(sizeof(size_t) >= sizeof(uint64_t), "Hashes are memoized as size_t");
+
+/// Structural hashes keyed by the RTTI object. The lock is held while new hashes are computed.
+static struct Memo g_hashes;
+
+struct HashNode {
+    struct RTTI *rtti;
+    uint32_t low; ///< Lowest node reachable through the nodes that are still on the component stack
+    _Bool on_stack;
+};
+
+struct HashFrame {
+    uint32_t node;
+    uint32_t edge; ///< Next edge to follow
+};
+
+/// State of one Tarjan walk over the types that have no hash yet. Nodes are numbered in discovery order.
+struct HashWalk {
+    struct HashNode *nodes;
+    uint32_t num_nodes;
+    uint32_t *slots; ///< Node + 1 keyed by the RTTI object, 0 for an empty slot
+    size_t num_slots;
+    unsigned shift; ///< 64 - log2(num_slots)
+    uint32_t *components; ///< Nodes whose component is not complete yet
+    uint32_t num_components;
+    struct HashFrame *frames;
+    uint32_t num_frames;
+    uint32_t capacity; ///< Of `nodes`, `components` and `frames`
+};
+
+static size_t HashPointer(const struct RTTI *rtti, unsigned shift) {
+    return (size_t) (((uint64_t) (uintptr_t) rtti * 0x9E3779B97F4A7C15ull) >> shift);
+}
+
+static uint64_t Mix(uint64_t hash, uint64_t value) {
+    hash = (hash ^ value) * 0x9E3779B97F4A7C15ull;
+    return hash ^ (hash >> 29);
+}
+
+static uint64_t MixString(uint64_t hash, const char *string) {
+    uint64_t value = HASH_BASIS;
+
+    if (string == NULL)
+        return Mix(hash, 0);
+
+    while (*string) {
+        value ^= (uint8_t) *string++;
+        value *= 0x100000001B3ull;
+    }
+
+    return Mix(hash, value);
+}
+
+/// Types whose hash goes into the hash of `rtti`, bases first and attrs next for compounds.
+/// Category markers have no type and show up as NULL edges. Pointers refer to their item by name
+/// and have no edges, nearly every type reaches every other one through them.
+static uint32_t EdgeCount(struct RTTI *rtti) {
+    struct RTTICompound *compound;
+
+    if (RTTI_AsCompound(rtti, &compound))
+        return compound->mNumBases + compound->mNumAttrs;
+    if (rtti->kind == RTTIKind_Container || rtti->kind == RTTIKind_Atom)
+        return 1;
+    return 0;
+}
+
+static struct RTTI *EdgeAt(struct RTTI *rtti, uint32_t index) {
+    struct RTTICompound *compound;
+    struct RTTIContainer *container;
+    struct RTTIAtom *atom;
+
+    if (RTTI_AsCompound(rtti, &compound))
+        return index < compound->mNumBases ? compound->mBases[index].mType : compound->mAttrs[index - compound->mNumBases].type;
+    if (RTTI_AsContainer(rtti, &container))
+        return container->mItemType;
+    if (RTTI_AsAtom(rtti, &atom))
+        return atom->mBaseType;
+    return NULL;
+}
+
+static uint64_t NominalHash(struct RTTI *rtti) {
+    if (rtti == NULL)
+        return 0;
+
+    return MixString(Mix(HASH_NOMINAL, rtti->kind), RTTI_DisplayName(rtti));
+}
+
+/// Types hashed earlier contribute their hash, the ones still being hashed belong to the same cycle
+/// and contribute their name. Finished components are only published once all of their members are hashed.
+static uint64_t EdgeHash(struct RTTI *rtti) {
+    size_t hash;
+
+    if (rtti != NULL && MemoFind(&g_hashes, rtti, &hash))
+        return hash;
+
+    return NominalHash(rtti);
+}
+
+static uint64_t ComputeHash(struct RTTI *rtti) {
+    struct RTTICompound *compound;
+    struct RTTIContainer *container;
+    struct RTTIPointer *pointer;
+    struct RTTIEnum *enumeration;
+    struct RTTIAtom *atom;
+    uint64_t hash = Mix(HASH_BASIS, rtti->kind);
+
+    if (RTTI_AsCompound(rtti, &compound)) {
+        hash = Mix(MixString(hash, compound->mTypeName), compound->mSize);
+        hash = Mix(hash, (uint64_t) compound->mNumBases << 8 | compound->mNumAttrs);
+
+        for (int i = 0; i < compound->mNumBases; i++)
+            hash = Mix(Mix(hash, EdgeHash(compound->mBases[i].mType)), compound->mBases[i].mOffset);
+
+        for (int i = 0; i < compound->mNumAttrs; i++) {
+            struct RTTIAttr *attr = &compound->mAttrs[i];
+            hash = MixString(hash, attr->mName);
+            if (attr->type != NULL)
+                hash = Mix(Mix(hash, EdgeHash(attr->type)), attr->mOffset);
+        }
+    } else if (RTTI_AsContainer(rtti, &container)) {
+        hash = MixString(hash, container->mContainerType->mTypeName);
+        hash = Mix(Mix(hash, container->mContainerType->mSize), EdgeHash(container->mItemType));
+    } else if (RTTI_AsPointer(rtti, &pointer)) {
+        hash = MixString(hash, pointer->mPointerType->mTypeName);
+        hash = Mix(Mix(hash, pointer->mPointerType->mSize), NominalHash(pointer->mItemType));
+    } else if (RTTI_AsEnum(rtti, &enumeration)) {
+        hash = Mix(Mix(MixString(hash, enumeration->type_name), enumeration->size), enumeration->num_values);
+
+        for (int i = 0; i < enumeration->num_values; i++)
+            hash = MixString(Mix(hash, enumeration->values[i].mValue), enumeration->values[i].mName);
+    } else if (RTTI_AsAtom(rtti, &atom)) {
+        // Base atoms are their own base type
+        hash = Mix(MixString(hash, atom->mTypeName), atom->mSize);
+        hash = Mix(hash, atom->mBaseType == rtti ? 0 : EdgeHash(atom->mBaseType));
+    }
+
+    return hash;
+}
+
+static void WalkFree(struct HashWalk *walk) {
+    free(walk->nodes);
+    free(walk->slots);
+    free(walk->components);
+    free(walk->frames);
+    memset(walk, 0, sizeof(*walk));
+}
+
+static _Bool WalkGrowSlots(struct HashWalk *walk) {
+    size_t num_slots = walk->num_slots ? walk->num_slots * 2 : 1024;
+    uint32_t *slots = calloc(num_slots, sizeof(uint32_t));
+    unsigned shift = 64;
+
+    if (slots == NULL)
+        return 0;
+
+    while (((size_t) 1 << (64 - shift)) < num_slots)
+        shift--;
+
+    for (uint32_t node = 0; node < walk->num_nodes; node++) {
+        size_t slot = HashPointer(walk->nodes[node].rtti, shift);
+        while (slots[slot])
+            slot = (slot + 1) & (num_slots - 1);
+        slots[slot] = node + 1;
+    }
+
+    free(walk->slots);
+    walk->slots = slots;
+    walk->num_slots = num_slots;
+    walk->shift = shift;
+    return 1;
+}
+
+static uint32_t WalkFind(struct HashWalk *walk, struct RTTI *rtti) {
+    size_t mask = walk->num_slots - 1;
+
+    for (size_t slot = HashPointer(rtti, walk->shift); walk->slots[slot]; slot = (slot + 1) & mask) {
+        if (walk->nodes[walk->slots[slot] - 1].rtti == rtti)
+            return walk->slots[slot] - 1;
+    }
+
+    return HASH_NO_NODE;
+}
+
+/// Discovers a node and descends into it.
+static _Bool WalkPush(struct HashWalk *walk, struct RTTI *rtti) {
+    if (walk->num_nodes == walk->capacity) {
+        uint32_t capacity = walk->capacity ? walk->capacity * 2 : 256;
+        struct HashNode *nodes = realloc(walk->nodes, capacity * sizeof(struct HashNode));
+        uint32_t *components = nodes ? realloc(walk->components, capacity * sizeof(uint32_t)) : NULL;
+        struct HashFrame *frames = components ? realloc(walk->frames, capacity * sizeof(struct HashFrame)) : NULL;
+
+        if (nodes)
+            walk->nodes = nodes;
+        if (components)
+            walk->components = components;
+        if (frames == NULL)
+            return 0;
+
+        walk->frames = frames;
+        walk->capacity = capacity;
+    }
+
+    if ((walk->num_nodes + 1) * 2 > walk->num_slots && !WalkGrowSlots(walk))
+        return 0;
+
+    uint32_t node = walk->num_nodes++;
+    size_t slot = HashPointer(rtti, walk->shift);
+
+    while (walk->slots[slot])
+        slot = (slot + 1) & (walk->num_slots - 1);
+    walk->slots[slot] = node + 1;
+
+    walk->nodes[node] = (struct HashNode) {.rtti = rtti, .low = node, .on_stack = 1};
+    walk->components[walk->num_components++] = node;
+    walk->frames[walk->num_frames++] = (struct HashFrame) {.node = node, .edge = 0};
+    return 1;
+}
+
+/// Hashes every member of the component rooted at `root` and only then publishes them, so that
+/// members see each other by name regardless of the order they were discovered in.
+static _Bool WalkFinishComponent(struct HashWalk *walk, uint32_t root) {
+    uint32_t first = walk->num_components;
+
+    do {
+        first--;
+        walk->nodes[walk->components[first]].on_stack = 0;
+    } while (walk->components[first] != root);
+
+    uint32_t count = walk->num_components - first;
+    uint64_t *hashes = malloc(count * sizeof(uint64_t));
+    if (hashes == NULL)
+        return 0;
+
+    for (uint32_t i = 0; i < count; i++)
+        hashes[i] = ComputeHash(walk->nodes[walk->components[first + i]].rtti);
+
+    _Bool inserted = 1;
+    for (uint32_t i = 0; i < count && inserted; i++)
+        inserted = MemoInsert(&g_hashes, walk->nodes[walk->components[first + i]].rtti, (size_t) hashes[i]);
+
+    free(hashes);
+    walk->num_components = first;
+    return inserted;
+}
+
+/// Iterative Tarjan walk from `root` over the types that have no hash yet. Components complete
+/// in reverse topological order, so everything a component references outside of itself is hashed by then.
+static _Bool Walk(struct HashWalk *walk, struct RTTI *root) {
+    if (!WalkGrowSlots(walk) || !WalkPush(walk, root))
+        return 0;
+
+    while (walk->num_frames) {
+        struct HashFrame *frame = &walk->frames[walk->num_frames - 1];
+        struct RTTI *rtti = walk->nodes[frame->node].rtti;
+
+        if (frame->edge < EdgeCount(rtti)) {
+            struct RTTI *target = EdgeAt(rtti, frame->edge++);
+            size_t hash;
+
+            if (target == NULL || MemoFind(&g_hashes, target, &hash))
+                continue;
+
+            uint32_t node = WalkFind(walk, target);
+
+            if (node == HASH_NO_NODE) {
+                if (!WalkPush(walk, target))
+                    return 0;
+            } else if (walk->nodes[node].on_stack && node < walk->nodes[frame->node].low) {
+                walk->nodes[frame->node].low = node;
+            }
+
+            continue;
+        }
+
+        uint32_t node = frame->node;
+        uint32_t low = walk->nodes[node].low;
+
+        walk->num_frames--;
+
+        if (walk->num_frames) {
+            struct HashNode *parent = &walk->nodes[walk->frames[walk->num_frames - 1].node];
+            if (low < parent->low)
+                parent->low = low;
+        }
+
+        if (low == node && !WalkFinishComponent(walk, node))
+            return 0;
+    }
+
+    return 1;
+}
+
+uint64_t TypeHash(struct RTTI *rtti) {
+    struct HashWalk walk = {0};
+    size_t hash;
+
+    if (MemoFind(&g_hashes, rtti, &hash))
+        return hash;
+
+    SpinLockAcquire(&g_hashes.lock);
+
+    if (!MemoFind(&g_hashes, rtti, &hash)) {
+        _Bool walked = Walk(&walk, rtti);
+        assert(walked && "Out of memory");
+
+        if (!walked || !MemoFind(&g_hashes, rtti, &hash))
+            hash = 0;
+    }
+
+    SpinLockRelease(&g_hashes.lock);
+
+    WalkFree(&walk);
+    return hash;
+}
+
+void TypeHashReset(void) {
+    MemoReset(&g_hashes);
+}
@@ -0,0 +1,114 @@
+#include "typeset.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+static size_t HashPointer(const struct RTTI *rtti, unsigned shift) {
+    // Fibonacci hashing, the top bits of the product are the best mixed
+    return (size_t) (((uint64_t) (uintptr_t) rtti * 0x9E3779B97F4A7C15ull) >> shift);
+}
+
+static unsigned ShiftFor(size_t capacity) {
+    unsigned shift = 64;
+
+    while (((size_t) 1 << (64 - shift)) < capacity)
+        shift--;
+
+    return shift;
+}
+
+static _Bool Grow(struct TypeSet *set) {
+    size_t capacity = set->capacity * 2;
+    struct RTTI **slots = calloc(capacity, sizeof(struct RTTI *));
+    struct RTTI **items = realloc(set->items, capacity / 2 * sizeof(struct RTTI *));
+
+    if (slots == NULL || items == NULL) {
+        free(slots);
+        if (items != NULL)
+            set->items = items;
+        return 0;
+    }
+
+    unsigned shift = ShiftFor(capacity);
+
+    for (size_t i = 0; i < set->count; i++) {
+        size_t slot = HashPointer(items[i], shift);
+        while (slots[slot] != NULL)
+            slot = (slot + 1) & (capacity - 1);
+        slots[slot] = items[i];
+    }
+
+    free(set->slots);
+    set->slots = slots;
+    set->items = items;
+    set->capacity = capacity;
+    set->shift = shift;
+    return 1;
+}
+
+_Bool TypeSetInit(struct TypeSet *set, size_t capacity) {
+    memset(set, 0, sizeof(*set));
+
+    set->capacity = 64;
+    while (set->capacity < capacity * 2)
+        set->capacity *= 2;
+
+    set->shift = ShiftFor(set->capacity);
+    set->slots = calloc(set->capacity, sizeof(struct RTTI *));
+    set->items = malloc(set->capacity / 2 * sizeof(struct RTTI *));
+
+    if (set->slots == NULL || set->items == NULL) {
+        TypeSetFree(set);
+        return 0;
+    }
+
+    return 1;
+}
+
+void TypeSetFree(struct TypeSet *set) {
+    free(set->slots);
+    free(set->items);
+    memset(set, 0, sizeof(*set));
+}
+
+_Bool TypeSetInsert(struct TypeSet *set, struct RTTI *rtti) {
+    size_t slot = HashPointer(rtti, set->shift);
+
+    for (;; slot = (slot + 1) & (set->capacity - 1)) {
+        set->probes++;
+
+        if (set->slots[slot] == rtti)
+            return 0;
+        if (set->slots[slot] == NULL)
+            break;
+    }
+
+    // Keep the load factor at or below one half
+    if (set->count + 1 > set->capacity / 2) {
+        if (!Grow(set)) {
+            set->failed = 1;
+            return 0;
+        }
+
+        slot = HashPointer(rtti, set->shift);
+        while (set->slots[slot] != NULL)
+            slot = (slot + 1) & (set->capacity - 1);
+    }
+
+    set->slots[slot] = rtti;
+    set->items[set->count++] = rtti;
+    return 1;
+}
+
+_Bool TypeSetContains(struct TypeSet *set, struct RTTI *rtti) {
+    size_t slot = HashPointer(rtti, set->shift);
+
+    for (;; slot = (slot + 1) & (set->capacity - 1)) {
+        set->probes++;
+
+        if (set->slots[slot] == rtti)
+            return 1;
+        if (set->slots[slot] == NULL)
+            return 0;
+    }
+}